@@ -65,12 +65,27 @@ SOURCES = PerfTimer.cpp \
         Settings.cpp \
         SmartKeyService.cpp \
         SmkyAutoSubDatabase.cpp \
+        SmkyBloomFilter.cpp \
+        SmkyCompiledDictionary.cpp \
+        SmkyDocumentCache.cpp \
+        SmkyExtraLocales.cpp \
         SmkyFileKeywords.cpp \
         SmkyFilePairs.cpp \
         SmkyHunspellDatabase.cpp \
+        SmkyJournal.cpp \
+        SmkyKeyboardLayout.cpp \
+        SmkyKnownWords.cpp \
+        SmkyLocalePool.cpp \
         SmkyManufacturerDatabase.cpp \
+        SmkyPrefixIndex.cpp \
+        SmkyRequestPool.cpp \
+        SmkyRequestSessions.cpp \
+        SmkySpellCheckCache.cpp \
         SmkySpellCheckEngine.cpp \
+        SmkyStringArena.cpp \
+        SmkySymSpellIndex.cpp \
         SmkyUserDatabase.cpp \
+        SmkyWordFrequency.cpp \
         SpellCheckClient.cpp \
         StringUtils.cpp \
 
@@ -79,14 +94,31 @@ HEADERS = Database.h \
         Settings.h \
         SmartKeyService.h \
         SmkyAutoSubDatabase.h \
+        SmkyBloomFilter.h \
+        SmkyCompiledDictionary.h \
+        SmkyDeadline.h \
+        SmkyDocumentCache.h \
+        SmkyExtraLocales.h \
         SmkyFileKeywords.h \
         SmkyFilePairs.h \
+        SmkyFlatTable.h \
         SmkyHunspellDatabase.h \
+        SmkyJournal.h \
+        SmkyKeyboardLayout.h \
         SmkyKeywordsBundle.h \
+        SmkyKnownWords.h \
+        SmkyLocalePool.h \
         SmkyManufacturerDatabase.h \
         SmkyPairsBundle.h \
+        SmkyPrefixIndex.h \
+        SmkyRequestPool.h \
+        SmkyRequestSessions.h \
+        SmkySpellCheckCache.h \
         SmkySpellCheckEngine.h \
+        SmkyStringArena.h \
+        SmkySymSpellIndex.h \
         SmkyUserDatabase.h \
+        SmkyWordFrequency.h \
         SpellCheckClient.h \
         StringUtils.h \
 
@@ -130,3 +162,20 @@ TARGET = com.palm.smartkey
 #QMAKE_LINK = @echo Linking $(@)...; $$QMAKE_LINK
 #QMAKE_MOC = @echo Mocing $(@)...; $$QMAKE_MOC
 
+# Word frequencies ranking guesses of en_us are the list of Tools/Scripts, installed
+# where Settings looks for them (readOnlyDataDir/frequency/<locale>/word-frequency)
+frequency.path = /usr/palm/smartkey/DefaultData/frequency/en_us
+frequency.extra = install -D -m 644 $$PWD/Tools/Scripts/key_dict_us_1-21 $(INSTALL_ROOT)$$frequency.path/word-frequency
+INSTALLS += frequency
+
+# Tools/DictionaryCompiler compiles text dictionaries into the memory mapped images
+# (<file>.bin, <locale>.sym) read by SmkyCompiledDictionary and SmkySymSpellIndex
+dictionary_compiler.target = $$DESTDIR/DictionaryCompiler
+dictionary_compiler.depends = $$PWD/Tools/DictionaryCompiler.cpp $$PWD/Src/SmkyCompiledDictionary.cpp $$PWD/Src/SmkySymSpellIndex.cpp
+dictionary_compiler.commands = $(CXX) $(CXXFLAGS) $(INCPATH) -o $$dictionary_compiler.target $$dictionary_compiler.depends $(LFLAGS) $(LIBS)
+QMAKE_EXTRA_TARGETS += dictionary_compiler
+PRE_TARGETDEPS += $$dictionary_compiler.target
+
+dictionary_compiler_bin.path = /usr/bin
+dictionary_compiler_bin.extra = install -D -m 755 $$dictionary_compiler.target $(INSTALL_ROOT)$$dictionary_compiler_bin.path/DictionaryCompiler
+INSTALLS += dictionary_compiler_bin
@@ -20,6 +20,7 @@
 #define DATABASE_H
 
 #include <string>
+#include <glib.h>
 
 namespace SmartKey
 {
@@ -37,6 +38,22 @@ struct Entry
     std::string substitution;
 };
 
+/**
+ * Memory usage and load time of one dictionary, byte counts are approximate.
+ */
+struct DictionaryStats
+{
+    DictionaryStats() : entries(0), keyBytes(0), valueBytes(0), overheadBytes(0), mappedBytes(0), loadMs(0) {}
+
+    std::string name;
+    size_t entries;
+    size_t keyBytes;        ///< Words (keys) copied into memory, with terminating zeros.
+    size_t valueBytes;      ///< Values of pairs copied into memory, with terminating zeros.
+    size_t overheadBytes;   ///< Hash tables, indexes, images built in memory, unused storage and estimates (hunspell).
+    size_t mappedBytes;     ///< Memory mapped files (shared with page cache).
+    double loadMs;          ///< Duration of the last load.
+};
+
 enum SmartKeyErrorCode
 {
     SKERR_SUCCESS = 0,          // No error
@@ -48,7 +65,8 @@ enum SmartKeyErrorCode
     SKERR_BAD_PARAM = 6,        // Invalid parameter
     SKERR_WORD_EXISTS = 7,      // Word already exists
     SKERR_NO_MATCHING_WORDS = 8,// No matching words (like for delete, etc.)
-    SKERR_BAD_WORD = 9          // Word is incorrect
+    SKERR_BAD_WORD = 9,         // Word is incorrect
+    SKERR_BUSY = 10             // Request can't be queued to worker threads
 };
 
 /**
@@ -96,6 +114,32 @@ protected:
     Database() {}
 };
 
+/**
+ * Generation of the dictionaries content: it is changed every time any dictionary
+ * is loaded or modified, so results calculated from the dictionaries can be dropped.
+ */
+inline volatile gint* _dictionaryGenerationCounter (void)
+{
+    static volatile gint s_generation = 0;
+    return(&s_generation);
+}
+
+/**
+* get current generation of the dictionaries content
+*/
+inline gint getDictionaryGeneration (void)
+{
+    return(g_atomic_int_get(_dictionaryGenerationCounter()));
+}
+
+/**
+* notify that some dictionary was changed
+*/
+inline void changeDictionaryGeneration (void)
+{
+    g_atomic_int_inc(_dictionaryGenerationCounter());
+}
+
 
 }
 
@@ -19,6 +19,9 @@
 #include <glib.h>
 #include "Settings.h"
 #include <algorithm>
+#include <set>
+#include <sys/inotify.h>
+#include <unistd.h>
 
 using namespace SmartKey;
 
@@ -243,6 +246,7 @@ DictionariesFileNames::DictionariesFileNames (void)
     m_mandb_name = "man-db-entries";
     m_userdb_name = "user-words";
     m_contextdb_name = "context-words";
+    m_frequencydb_name = "word-frequency";
 }
 
 //=[DictionariesRelativePaths]==========================================================================================
@@ -258,6 +262,7 @@ DictionariesRelativePaths::DictionariesRelativePaths (void)
     m_autosub_hc = "autoreplace-hc";
     m_manufacturer = "manufacturer";
     m_user = "";
+    m_frequency = "frequency";
 }
 
 //=[Settings]===========================================================================================================
@@ -269,7 +274,19 @@ Settings::Settings (void)
     :readOnlyDataDir("/usr/palm/smartkey/DefaultData")
     ,readWriteDataDir("/var/palm/smartkey/DefaultData")
     ,hunspellDirectory("/usr/palm/smartkey/hunspell")
+    ,spellCacheSize(256)
+    ,suggestBudgetMs(100)
+    ,batchBudgetMs(1000)
+    ,workerThreads(1)
+    ,saveDelayMs(2000)
+    ,syncPolicy(1)
+    ,localePoolSize(2)
+    ,localePoolMemoryKb(32768)
+    ,m_watch_fd(-1)
+    ,m_watch_started(false)
 {
+    g_mutex_init(&m_paths_mutex);
+
     localeSettings.m_inputLanguage = "en";
     localeSettings.m_deviceCountry = "us";
     localeSettings.m_inputLanguage = "en";
@@ -296,48 +313,51 @@ Settings::Settings (void)
 * @param pathSuffix
 *   path suffix
 *
+* @param i_locale
+*   locale settings
+*
 * @return std::string
 *   path is not empty if found
 */
-std::string Settings::_findLocalResource (const std::string& pathPrefix, const char * pathSuffix) const
+std::string Settings::_findLocalResource (const std::string& pathPrefix, const char * pathSuffix, const LocaleSettings& i_locale) const
 {
     //standard case
-    std::string path = pathPrefix + localeSettings.m_inputLanguage + '_' + localeSettings.m_deviceCountry + pathSuffix;
+    std::string path = pathPrefix + i_locale.m_inputLanguage + '_' + i_locale.m_deviceCountry + pathSuffix;
     if (g_file_test(path.c_str(), G_FILE_TEST_EXISTS))
         return path;
 
     //degenerate case
-    path = pathPrefix + localeSettings.m_inputLanguage + '_' + localeSettings.m_inputLanguage + pathSuffix;
+    path = pathPrefix + i_locale.m_inputLanguage + '_' + i_locale.m_inputLanguage + pathSuffix;
     if (g_file_test(path.c_str(), G_FILE_TEST_EXISTS))
         return path;
 
     //check with capitalized country
-    std::string capCountry = localeSettings.m_deviceCountry;
+    std::string capCountry = i_locale.m_deviceCountry;
     std::transform(capCountry.begin(), capCountry.end(), capCountry.begin(), ::toupper);
 
-    path = pathPrefix + localeSettings.m_inputLanguage + '_' + capCountry + pathSuffix;
+    path = pathPrefix + i_locale.m_inputLanguage + '_' + capCountry + pathSuffix;
     if (g_file_test(path.c_str(), G_FILE_TEST_EXISTS))
         return path;
 
     //file name can be represented by two letters:
-    path = pathPrefix + localeSettings.m_inputLanguage + pathSuffix;
+    path = pathPrefix + i_locale.m_inputLanguage + pathSuffix;
     if (g_file_test(path.c_str(), G_FILE_TEST_EXISTS))
         return path;
 
     //check for the language with the country code from the language code
-    capCountry = localeSettings.m_inputLanguage;
+    capCountry = i_locale.m_inputLanguage;
     std::transform(capCountry.begin(), capCountry.end(), capCountry.begin(), ::toupper);
 
-    path = pathPrefix + localeSettings.m_inputLanguage + '_' + capCountry + pathSuffix;
+    path = pathPrefix + i_locale.m_inputLanguage + '_' + capCountry + pathSuffix;
     if (g_file_test(path.c_str(), G_FILE_TEST_EXISTS))
         return path;
 
     // we're desperate. Try 'us' as a country...
-    path = pathPrefix + localeSettings.m_inputLanguage + "_us" + pathSuffix;
+    path = pathPrefix + i_locale.m_inputLanguage + "_us" + pathSuffix;
     if (g_file_test(path.c_str(), G_FILE_TEST_EXISTS))
         return path;
 
-    path = pathPrefix + localeSettings.m_inputLanguage + "_US" + pathSuffix;
+    path = pathPrefix + i_locale.m_inputLanguage + "_US" + pathSuffix;
     if (g_file_test(path.c_str(), G_FILE_TEST_EXISTS))
         return path;
 
@@ -346,7 +366,7 @@ std::string Settings::_findLocalResource (const std::string& pathPrefix, const c
 }
 
 /**
-* get complete path + filename of requested db
+* get complete path + filename of requested db for current locale
 *
 * @param i_dictionary
 *   Settings::DICTIONARY
@@ -358,6 +378,248 @@ std::string Settings::_findLocalResource (const std::string& pathPrefix, const c
 *   path + filename
 */
 string Settings::getDBFilePath (DICTIONARY i_dictionary, DICT_KIND i_kind)
+{
+    return(getDBFilePath(i_dictionary, i_kind, localeSettings));
+}
+
+/**
+* get complete path + filename of requested db: path is resolved once per locale,
+* cached path is dropped when files are created, removed or renamed in the directory where it was
+* searched (paths aren't cached if data directories can't be watched)
+*
+* @param i_dictionary
+*   Settings::DICTIONARY
+*
+* @param i_kind
+*   Settings::DICT_KIND
+*
+* @param i_locale
+*   locale settings (current or the one being loaded)
+*
+* @return string
+*   path + filename
+*/
+string Settings::getDBFilePath (DICTIONARY i_dictionary, DICT_KIND i_kind, const LocaleSettings& i_locale)
+{
+    g_mutex_lock(&m_paths_mutex);
+
+    if (!m_watch_started)
+    {
+        m_watch_started = true;
+        _watchDataDirectories();
+    }
+
+    _dropChangedPaths();
+
+    PathKey key(i_locale.getLanguageCountryLocale(), std::pair<int, int>(i_dictionary, i_kind));
+    string retval;
+
+    PathsMap::const_iterator it = m_resolved_paths.find(key);
+    if (it != m_resolved_paths.end())
+    {
+        retval = it->second.first;
+    }
+    else
+    {
+        string search_dir;
+        retval = _resolveDBFilePath(i_dictionary, i_kind, i_locale, search_dir);
+
+        if (m_watch_fd >= 0)
+            m_resolved_paths[key] = ResolvedPath(retval, search_dir);
+    }
+
+    g_mutex_unlock(&m_paths_mutex);
+
+    return (retval);
+}
+
+/**
+* start watching data directories for created, removed and renamed files, directories which
+* don't exist yet are watched through their nearest existing parent
+*/
+void Settings::_watchDataDirectories (void)
+{
+    if (m_watch_fd < 0)
+    {
+        m_watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+        if (m_watch_fd < 0)
+        {
+            g_warning("Settings: can't watch data directories, paths of dictionaries are not cached");
+            return;
+        }
+    }
+
+    const std::string dirs[] = { readOnlyDataDir, readWriteDataDir, hunspellDirectory };
+
+    for (size_t i = 0; i < G_N_ELEMENTS(dirs); ++i)
+    {
+        std::string dir = dirs[i];
+        int depth = WATCH_DEPTH;
+
+        while (!g_file_test(dir.c_str(), G_FILE_TEST_IS_DIR) && dir.length() > 1)
+        {
+            gchar* p_parent = g_path_get_dirname(dir.c_str());
+            dir = p_parent;
+            g_free(p_parent);
+            depth = 0;
+        }
+
+        _watchDirectory(dir, depth);
+    }
+}
+
+/**
+* watch directory and its subdirectories
+*
+* @param i_dir
+*   directory
+*
+* @param i_depth
+*   levels of subdirectories to watch
+*/
+void Settings::_watchDirectory (const std::string& i_dir, int i_depth)
+{
+    const uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+    int wd = inotify_add_watch(m_watch_fd, i_dir.c_str(), mask);
+
+    if (wd < 0)
+        return;
+
+    m_watched_dirs[wd] = i_dir + "/";
+
+    if (i_depth <= 0)
+        return;
+
+    GDir* p_dir = g_dir_open(i_dir.c_str(), 0, NULL);
+    if (!p_dir)
+        return;
+
+    const gchar* p_name;
+    while ((p_name = g_dir_read_name(p_dir)) != NULL)
+    {
+        std::string path = i_dir + "/" + p_name;
+
+        if (g_file_test(path.c_str(), G_FILE_TEST_IS_DIR))
+            _watchDirectory(path, i_depth - 1);
+    }
+
+    g_dir_close(p_dir);
+}
+
+/**
+* read pending events of watched directories and drop cached paths which were searched in (or under)
+* changed directories; files written by the service itself are ignored, new directories are watched as well
+*/
+void Settings::_dropChangedPaths (void)
+{
+    if (m_watch_fd < 0)
+        return;
+
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    std::set<string> changed_dirs;
+    bool overflow = false;
+    bool dirs_changed = false;
+    ssize_t length;
+
+    while ((length = read(m_watch_fd, buf, sizeof(buf))) > 0)
+    {
+        for (char* p = buf; p < buf + length; )
+        {
+            const struct inotify_event* p_event = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + p_event->len;
+
+            if (p_event->mask & IN_Q_OVERFLOW)
+            {
+                overflow = true;
+                continue;
+            }
+
+            std::map<int, string>::iterator dir = m_watched_dirs.find(p_event->wd);
+            if (dir == m_watched_dirs.end())
+                continue;
+
+            if (p_event->mask & IN_IGNORED)
+            {
+                m_watched_dirs.erase(dir);
+                continue;
+            }
+
+            if (p_event->mask & (IN_ISDIR | IN_DELETE_SELF | IN_MOVE_SELF))
+                dirs_changed = true;
+            else if (p_event->len > 0 && _isServiceFile(p_event->name))
+                continue;
+
+            changed_dirs.insert(dir->second);
+        }
+    }
+
+    if (overflow)
+    {
+        m_resolved_paths.clear();
+    }
+    else if (!changed_dirs.empty())
+    {
+        PathsMap::iterator it = m_resolved_paths.begin();
+
+        while (it != m_resolved_paths.end())
+        {
+            const string& search_dir = it->second.second;
+            bool changed = false;
+
+            //file could appear in the searched directory or in its subdirectories,
+            //or the directory itself could be created in a watched parent
+            for (std::set<string>::const_iterator dir = changed_dirs.begin(); dir != changed_dirs.end() && !changed; ++dir)
+            {
+                changed = search_dir.compare(0, dir->length(), *dir) == 0 || dir->compare(0, search_dir.length(), search_dir) == 0;
+            }
+
+            if (changed)
+                m_resolved_paths.erase(it++);
+            else
+                ++it;
+        }
+    }
+
+    if (overflow || dirs_changed)
+        _watchDataDirectories();
+}
+
+/**
+* is the file written by the service itself: temporary snapshot or journal of a dictionary (see SmkyJournal),
+* its changes don't change paths of dictionaries
+*
+* @param ip_name
+*   name of the file
+*
+* @return bool
+*   true if the file is a snapshot or a journal
+*/
+bool Settings::_isServiceFile (const char* ip_name)
+{
+    return(g_str_has_suffix(ip_name, ".tmp") || g_str_has_suffix(ip_name, ".journal"));
+}
+
+/**
+* find complete path + filename of requested db
+*
+* @param i_dictionary
+*   Settings::DICTIONARY
+*
+* @param i_kind
+*   Settings::DICT_KIND
+*
+* @param i_locale
+*   locale settings
+*
+* @param o_search_dir
+*   output: directory (ending with '/') where the file was searched
+*
+* @return string
+*   path + filename
+*/
+string Settings::_resolveDBFilePath (DICTIONARY i_dictionary, DICT_KIND i_kind, const LocaleSettings& i_locale, string& o_search_dir)
 {
     string retval = "";
     string prefix;
@@ -369,7 +631,7 @@ string Settings::getDBFilePath (DICTIONARY i_dictionary, DICT_KIND i_kind)
     {
         prefix = readWriteDataDir + "/" + directories.m_autosub + "/";
         suffix = "/" + fileNames.m_autosubdb_name;
-        retval = _findLocalResource(prefix, suffix.c_str());
+        retval = _findLocalResource(prefix, suffix.c_str(), i_locale);
     }
     break;
 
@@ -377,7 +639,7 @@ string Settings::getDBFilePath (DICTIONARY i_dictionary, DICT_KIND i_kind)
     {
         prefix = readOnlyDataDir + "/" + directories.m_autosub_hc + "/";
         suffix = "/" + fileNames.m_autosubdb_name;
-        retval = _findLocalResource(prefix, suffix.c_str());
+        retval = _findLocalResource(prefix, suffix.c_str(), i_locale);
     }
     break;
 
@@ -389,7 +651,7 @@ string Settings::getDBFilePath (DICTIONARY i_dictionary, DICT_KIND i_kind)
         {
             prefix = readOnlyDataDir + "/" + directories.m_locale + "/";
             suffix = "/" + fileNames.m_localedb_name;
-            retval = _findLocalResource(prefix, suffix.c_str());
+            retval = _findLocalResource(prefix, suffix.c_str(), i_locale);
         }
     }
     break;
@@ -402,7 +664,7 @@ string Settings::getDBFilePath (DICTIONARY i_dictionary, DICT_KIND i_kind)
         {
             prefix = readOnlyDataDir + "/" + directories.m_whitelist + "/";
             suffix = "/" + fileNames.m_whitelistdb_name;
-            retval = _findLocalResource(prefix, suffix.c_str());
+            retval = _findLocalResource(prefix, suffix.c_str(), i_locale);
         }
     }
     break;
@@ -415,7 +677,7 @@ string Settings::getDBFilePath (DICTIONARY i_dictionary, DICT_KIND i_kind)
         {
             prefix = readOnlyDataDir + "/" + directories.m_manufacturer + "/";
             suffix = "/" + fileNames.m_mandb_name;
-            retval = _findLocalResource(prefix, suffix.c_str());
+            retval = _findLocalResource(prefix, suffix.c_str(), i_locale);
         }
     }
     break;
@@ -426,14 +688,21 @@ string Settings::getDBFilePath (DICTIONARY i_dictionary, DICT_KIND i_kind)
         {
             prefix = hunspellDirectory + "/";
             suffix = ".aff";
-            retval = _findLocalResource(prefix, suffix.c_str());
+            retval = _findLocalResource(prefix, suffix.c_str(), i_locale);
         }
 
         if (i_kind == DICT_HUNSPELL_DIC)
         {
             prefix = hunspellDirectory + "/";
             suffix = ".dic";
-            retval = _findLocalResource(prefix, suffix.c_str());
+            retval = _findLocalResource(prefix, suffix.c_str(), i_locale);
+        }
+
+        if (i_kind == DICT_HUNSPELL_SYM)
+        {
+            prefix = hunspellDirectory + "/";
+            suffix = ".sym";
+            retval = _findLocalResource(prefix, suffix.c_str(), i_locale);
         }
     }
     break;
@@ -456,11 +725,81 @@ string Settings::getDBFilePath (DICTIONARY i_dictionary, DICT_KIND i_kind)
 
     }
     break;
+
+    case (DICT_FREQUENCY) :
+    {
+        prefix = readOnlyDataDir + "/" + directories.m_frequency + "/";
+        suffix = "/" + fileNames.m_frequencydb_name;
+        retval = _findLocalResource(prefix, suffix.c_str(), i_locale);
+    }
+    break;
+    }
+
+    if (!prefix.empty())
+    {
+        o_search_dir = prefix;
+    }
+    else
+    {
+        gchar* p_dir = g_path_get_dirname(retval.c_str());
+        o_search_dir = string(p_dir) + "/";
+        g_free(p_dir);
     }
 
     return (retval);
 }
 
+/**
+* is SymSpell index enabled for current locale?
+*
+* @return bool
+*   true if input language (or language + country) is in symSpellLocales list
+*/
+bool Settings::isSymSpellEnabled (void) const
+{
+    return(isSymSpellEnabled(localeSettings));
+}
+
+/**
+* is SymSpell index enabled for the locale?
+*
+* @param i_locale
+*   locale settings
+*
+* @return bool
+*   true if input language (or language + country) is in symSpellLocales list
+*/
+bool Settings::isSymSpellEnabled (const LocaleSettings& i_locale) const
+{
+    std::string list = symSpellLocales;
+    std::transform(list.begin(), list.end(), list.begin(), ::tolower);
+
+    std::string language = i_locale.m_inputLanguage;
+    std::transform(language.begin(), language.end(), language.begin(), ::tolower);
+
+    std::string locale = i_locale.getLanguageCountryLocale();
+    std::transform(locale.begin(), locale.end(), locale.begin(), ::tolower);
+
+    size_t start = 0;
+    while (start <= list.length())
+    {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos)
+            end = list.length();
+
+        std::string item = list.substr(start, end - start);
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+
+        if (!item.empty() && (item == "*" || item == language || item == locale))
+            return true;
+
+        start = end + 1;
+    }
+
+    return false;
+}
+
 /**
 * load settings from the configuration file
 *
@@ -499,6 +838,26 @@ bool Settings::load (const std::string& settingsFile)
     reader.ReadString( "General", "userdbName", p_settings->fileNames.m_userdb_name );
     reader.ReadString( "General", "contextdbName", p_settings->fileNames.m_contextdb_name );
 
+    reader.ReadString( "General", "frequencydbPath", p_settings->directories.m_frequency );
+    reader.ReadString( "General", "frequencydbName", p_settings->fileNames.m_frequencydb_name );
+
+    reader.ReadInteger( "General", "spellCacheSize", p_settings->spellCacheSize );
+    reader.ReadInteger( "General", "suggestBudgetMs", p_settings->suggestBudgetMs );
+    reader.ReadInteger( "General", "batchBudgetMs", p_settings->batchBudgetMs );
+    reader.ReadString( "General", "symSpellLocales", p_settings->symSpellLocales );
+    reader.ReadString( "General", "extraLocales", p_settings->extraLocales );
+    reader.ReadInteger( "General", "workerThreads", p_settings->workerThreads );
+    reader.ReadInteger( "General", "saveDelayMs", p_settings->saveDelayMs );
+    reader.ReadInteger( "General", "syncPolicy", p_settings->syncPolicy );
+    reader.ReadInteger( "General", "localePoolSize", p_settings->localePoolSize );
+    reader.ReadInteger( "General", "localePoolMemoryKb", p_settings->localePoolMemoryKb );
+
+    //data directories may be changed, resolve paths again
+    g_mutex_lock(&p_settings->m_paths_mutex);
+    p_settings->m_resolved_paths.clear();
+    p_settings->m_watch_started = false;
+    g_mutex_unlock(&p_settings->m_paths_mutex);
+
     return true;
 }
 
@@ -20,6 +20,7 @@
 #define SMKY_SETTINGS_H
 
 #include <glib.h>
+#include <map>
 #include <string>
 
 namespace SmartKey
@@ -80,6 +81,9 @@ struct DictionariesFileNames
     //user db (context) file name
     string m_contextdb_name;
 
+    //word frequency list file name
+    string m_frequencydb_name;
+
     DictionariesFileNames (void);
 };
 
@@ -106,6 +110,9 @@ struct DictionariesRelativePaths
     //relative path to user dictionaries (user and context)
     string m_user;
 
+    //relative path to locale specific word frequency lists
+    string m_frequency;
+
     DictionariesRelativePaths (void);
 };
 
@@ -125,6 +132,7 @@ public:
         ,DICT_HUNSPELL
         ,DICT_USER
         ,DICT_USER_CONTEXT
+        ,DICT_FREQUENCY
     };
 
     enum DICT_KIND
@@ -133,6 +141,7 @@ public:
         ,DICT_LOCALE_DEPEND
         ,DICT_HUNSPELL_AFF
         ,DICT_HUNSPELL_DIC
+        ,DICT_HUNSPELL_SYM
     };
 
 public:
@@ -155,6 +164,37 @@ public:
     //all our dictionaries file names
     DictionariesFileNames fileNames;
 
+    //max number of spell check results kept in the cache (0 - disabled)
+    int spellCacheSize;
+
+    //default time budget (ms) for suggestions of a single request (0 - no limit)
+    int suggestBudgetMs;
+
+    //time budget (ms) of all words of a searchBatch or checkText request (0 - no limit)
+    int batchBudgetMs;
+
+    //comma separated list of locales ("en_us") or languages ("en") which use SymSpell index for suggestions
+    string symSpellLocales;
+
+    //multi-language mode: comma separated list of locales ("en_us") or languages ("en") checked after the current one,
+    //with optional weight (1-100, default 50) of their guesses ("hu_hu:70,en"), word is good if any of them accepts it
+    string extraLocales;
+
+    //number of threads serving search/getCompletion/processTaps requests (0 - process them on the main loop)
+    int workerThreads;
+
+    //delay (ms) of saving changed user dictionaries, changes made meanwhile are saved at once (0 - save immediately)
+    int saveDelayMs;
+
+    //fsync of saved user dictionaries: 0 - never, 1 - rewritten dictionary files, 2 - also every journal append
+    int syncPolicy;
+
+    //number of recently used locales whose dictionaries are kept in memory, including the current one (1 - only the current one)
+    int localePoolSize;
+
+    //memory budget (KB) of dictionaries kept for locales other than the current one (0 - no limit)
+    int localePoolMemoryKb;
+
 public:
     static Settings* getInstance(void)
     {
@@ -165,10 +205,42 @@ public:
     //load settings from the configuration file
     bool load (const std::string& settingsFile);
 
-    //get complete path + filename of requested db
+    //get complete path + filename of requested db (resolved paths are cached until data directories are changed)
     string getDBFilePath  (DICTIONARY i_dictionary, DICT_KIND i_kind = DICT_LOCALE_INDEPEND);
 
+    //get complete path + filename of requested db for the given locale
+    string getDBFilePath  (DICTIONARY i_dictionary, DICT_KIND i_kind, const LocaleSettings& i_locale);
+
+    //is SymSpell index enabled for current locale?
+    bool isSymSpellEnabled (void) const;
+
+    //is SymSpell index enabled for the given locale?
+    bool isSymSpellEnabled (const LocaleSettings& i_locale) const;
+
 private:
+    enum
+    {
+        WATCH_DEPTH = 3     ///< levels of subdirectories of data directories watched for changes
+    };
+
+    //(locale, (dictionary, kind))
+    typedef std::pair<string, std::pair<int, int> > PathKey;
+    //(path, directory searched for the file)
+    typedef std::pair<string, string> ResolvedPath;
+    typedef std::map<PathKey, ResolvedPath> PathsMap;
+
+    //resolved paths of all locales used so far
+    PathsMap m_resolved_paths;
+
+    //inotify descriptor watching data directories (-1 - not watched, paths are not cached)
+    int m_watch_fd;
+    bool m_watch_started;
+
+    //watched directories by watch descriptor
+    std::map<int, string> m_watched_dirs;
+
+    //paths are resolved by worker threads too
+    GMutex m_paths_mutex;
 
     Settings (void);
     Settings (Settings const&);       // don't implement
@@ -176,7 +248,22 @@ private:
     void operator& (Settings const&); // don't implement
 
     //find locale resource
-    std::string _findLocalResource (const std::string& pathPrefix, const char * pathSuffix) const;
+    std::string _findLocalResource (const std::string& pathPrefix, const char * pathSuffix, const LocaleSettings& i_locale) const;
+
+    //find complete path + filename of requested db (not cached) and directory where it was searched
+    string _resolveDBFilePath (DICTIONARY i_dictionary, DICT_KIND i_kind, const LocaleSettings& i_locale, string& o_search_dir);
+
+    //start watching data directories for changes of dictionary files
+    void _watchDataDirectories (void);
+
+    //watch directory and its subdirectories up to i_depth levels
+    void _watchDirectory (const std::string& i_dir, int i_depth);
+
+    //drop cached paths searched in directories changed since the last call (paths mutex is locked by caller)
+    void _dropChangedPaths (void);
+
+    //is the file written by the service itself (temporary snapshot or journal of a dictionary)?
+    static bool _isServiceFile (const char* ip_name);
 
 };
 
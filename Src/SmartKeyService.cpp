@@ -27,6 +27,7 @@
 #include <glib/gstdio.h>
 #include <lunaservice.h>
 #include <memory>
+#include <map>
 #include <algorithm>
 #include <stdio.h>
 #include <stdlib.h>
@@ -250,6 +251,8 @@ namespace SmartKey
  *
  *  Methods:
  *   - \ref com_palm_smartKey_search
+ *   - \ref com_palm_smartKey_searchBatch
+ *   - \ref com_palm_smartKey_checkText
  *   - \ref com_palm_smartKey_learn
  *   - \ref com_palm_smartKey_addUserWord
  *   - \ref com_palm_smartKey_forget
@@ -266,10 +269,13 @@ namespace SmartKey
  *   - \ref com_palm_smartKey_processTaps
  *   - \ref com_palm_smartKey_getCompletion
  *   - \ref com_palm_smartKey_updateWordUsage
+ *   - \ref com_palm_smartKey_getStats
  */
 static LSMethod serviceMethods[] =
 {
     { "search", SmartKeyService::cmdSearch },
+    { "searchBatch", SmartKeyService::cmdSearchBatch },
+    { "checkText", SmartKeyService::cmdCheckText },
     { "learn", SmartKeyService::cmdAddUserWord },
     { "addUserWord", SmartKeyService::cmdAddUserWord },
     { "forget", SmartKeyService::cmdRemoveUserWord },
@@ -286,6 +292,7 @@ static LSMethod serviceMethods[] =
     { "processTaps", SmartKeyService::cmdProcessTaps },
     { "getCompletion", SmartKeyService::cmdGetCompletion },
     { "updateWordUsage", SmartKeyService::cmdUpdateWordUsage },
+    { "getStats", SmartKeyService::cmdGetStats },
     { 0, 0 },
 };
 
@@ -302,11 +309,23 @@ LSSignal serviceSignals[] =
 SmartKeyService::SmartKeyService(void) :
     m_service(NULL)
     , m_carrierDbWatchToken(0)
+    , m_saveTimer(0)
     , m_mainLoop(NULL)
     , m_isEnabled(false)
     , m_readPeople(false)
+    , m_localeLoad(NULL)
+    , m_localeLoadThread(NULL)
+    , m_localeLoadDone(0)
+    , m_localeLoadAction(LanguageActionNone)
+    , m_pendingAction(LanguageActionNone)
+    , m_pendingWritesSource(0)
+    , m_pendingWritesSince(0)
 {
     m_engine = new SmkySpellCheckEngine();
+
+    //current locale is not kept in the pool
+    Settings* p_settings = Settings::getInstance();
+    m_localePool.configure(std::max(p_settings->localePoolSize - 1, 0), (size_t)std::max(p_settings->localePoolMemoryKb, 0) * 1024);
 //#ifdef TARGET_DESKTOP
 //    m_engine->changedLocaleSettings();
 //#endif
@@ -319,6 +338,19 @@ SmartKeyService::~SmartKeyService()
 {
     cancelCarrierDbSettingsWatch();
 
+    cancelLocaleLoad();
+
+    //requests in progress still use the engine
+    m_requestPool.stop();
+
+    //apply changes which waited for requests
+    {
+        SmkyEngineWriteLock lock(m_engine);
+        runPendingWrites();
+    }
+
+    m_localePool.clear();
+
     delete m_engine;
 }
 
@@ -630,6 +662,12 @@ Exit:
     {
         m_mainLoop = mainLoop;
 
+        m_requestPool.start(Settings::getInstance()->workerThreads);
+
+        //first requests of worker threads don't wait for their copies of hunspell dictionary
+        if (m_requestPool.isRunning())
+            m_engine->startWorkerDictionaries(Settings::getInstance()->workerThreads);
+
         g_message("%s: started service %s", __FUNCTION__, serviceName);
     }
     else
@@ -649,6 +687,20 @@ Exit:
 bool SmartKeyService::stop()
 {
     g_message("%s: stopping service %s", __FUNCTION__, "smartKey");
+
+    //reply to queued requests while we are still registered
+    m_requestPool.stop();
+
+    //apply changes which waited for requests
+    {
+        SmkyEngineWriteLock lock(m_engine);
+        runPendingWrites();
+    }
+
+    cancelLocaleLoad();
+
+    flushDictionaries();
+
     LSError lserror;
     LSErrorInit(&lserror);
 
@@ -698,6 +750,8 @@ static const char* getErrorString (SmartKeyErrorCode err)
         return "No matching words";
     case SKERR_BAD_WORD:
         return "Input word is incorrect";
+    case SKERR_BUSY:
+        return "Service is busy";
     default:
         return "<UNKNOWN>";
     }
@@ -723,6 +777,161 @@ void setReplyResponse (json_object* reply, SmartKeyErrorCode err)
     }
 }
 
+/**
+* queue request to worker threads, process it right away if there are no worker threads.
+* Worker threads own hunspell dictionary (the first one asking takes the engine's one), so while
+* they run requests are never processed on the main loop: that would load another copy of it there.
+*
+* @param handler
+*   request handler
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   true if request is queued or rejected, handler result otherwise
+*/
+bool SmartKeyService::dispatchRequest (SmkyRequestPool::Handler handler, LSHandle* sh, LSMessage* message, void* ctx)
+{
+    SmartKeyService* service = static_cast<SmartKeyService*>(ctx);
+
+    if (!message || !service || !service->m_requestPool.isRunning())
+        return(handler(sh, message, ctx));
+
+    if (service->m_requestPool.push(handler, sh, message, ctx))
+        return true;
+
+    g_warning("%s: request can't be queued, replying busy", __FUNCTION__);
+
+    json_object* replyJson = json_object_new_object();
+    setReplyResponse(replyJson, SKERR_BUSY);
+
+    LSError lserror;
+    LSErrorInit(&lserror);
+
+    if (!LSMessageReply(sh, message, json_object_to_json_string(replyJson), &lserror))
+    {
+        LSErrorPrint(&lserror, stderr);
+        LSErrorFree(&lserror);
+    }
+
+    json_object_put(replyJson);
+
+    return true;
+}
+
+/**
+* change dictionaries right away if no request is running, the main loop is never blocked by
+* requests of worker threads: otherwise the change is queued and retried by timeout
+* (see pendingWritesCallback). Changes are applied in order.
+*
+* @param handler
+*   handler changing dictionaries (called with engine locked exclusively)
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   true if change is queued, handler result otherwise
+*/
+bool SmartKeyService::dispatchWrite (SmkyRequestPool::Handler handler, LSHandle* sh, LSMessage* message, void* ctx)
+{
+    SmartKeyService* service = static_cast<SmartKeyService*>(ctx);
+
+    //requests are processed on the main loop, nothing to wait for
+    if (!message || !service || !service->m_engine || !service->m_requestPool.isRunning())
+    {
+        SmkyEngineWriteLock lock(service ? service->m_engine : NULL);
+        return(handler(sh, message, ctx));
+    }
+
+    if (service->m_pendingWrites.empty() && service->m_engine->tryLockExclusive())
+    {
+        bool result = handler(sh, message, ctx);
+        service->m_engine->unlockExclusive();
+        return(result);
+    }
+
+    LSMessageRef(message);
+
+    PendingWrite write = { handler, sh, message };
+    service->m_pendingWrites.push_back(write);
+
+    if (service->m_pendingWritesSource == 0)
+    {
+        service->m_pendingWritesSince = g_get_monotonic_time();
+        service->m_pendingWritesSource = g_timeout_add(SMK_WRITE_RETRY_MS, pendingWritesCallback, service);
+    }
+
+    return true;
+}
+
+/**
+* apply queued dictionary changes once no request is running. Requests hold the engine for one word
+* at most, the lock is waited for if changes are pending for SMK_MAX_WRITE_DELAY_MS already, so a
+* stream of requests can't starve them.
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return gboolean
+*   TRUE if requests are still running (callback is repeated)
+*/
+gboolean SmartKeyService::pendingWritesCallback (gpointer ctx)
+{
+    SmartKeyService* service = static_cast<SmartKeyService*>(ctx);
+
+    if (!service->m_engine->tryLockExclusive())
+    {
+        if (g_get_monotonic_time() - service->m_pendingWritesSince < (gint64)SMK_MAX_WRITE_DELAY_MS * 1000)
+            return TRUE;
+
+        g_debug("%s: changes are pending for %d msec, waiting for requests", __FUNCTION__, SMK_MAX_WRITE_DELAY_MS);
+        service->m_engine->lockExclusive();
+    }
+
+    //source is removed by returning FALSE
+    service->m_pendingWritesSource = 0;
+
+    service->runPendingWrites();
+    service->m_engine->unlockExclusive();
+
+    return FALSE;
+}
+
+/**
+* apply queued dictionary changes, engine must be locked exclusively
+*/
+void SmartKeyService::runPendingWrites (void)
+{
+    if (m_pendingWritesSource)
+    {
+        g_source_remove(m_pendingWritesSource);
+        m_pendingWritesSource = 0;
+    }
+
+    while (!m_pendingWrites.empty())
+    {
+        PendingWrite write = m_pendingWrites.front();
+        m_pendingWrites.pop_front();
+
+        write.handler(write.sh, write.message, this);
+        LSMessageUnref(write.message);
+    }
+}
+
 /**
 * Determine if a word looks enough like a URL to not be spell checked.
 *
@@ -968,6 +1177,9 @@ search the candidate substitution word for the query word.
 	"quick": boolean
 	"extended" : boolean
 	"max": int
+	"budget": int
+	"sessionId": string
+	"seq": int
 }
 \endcode
 
@@ -976,11 +1188,17 @@ search the candidate substitution word for the query word.
 \param quick If set as true, engine will use checkSpelling, which is much faster but not as smart as autoCorrect which use reginal information
 \param extended If set as true, engine will generate more suggestions in output (=60). Can be ommited.
 \param max Maximum number of words for output result, by default is 10. This parameter have priority over parameter 'extended'. Can be ommited.
+\param budget Time budget in milliseconds for generating suggestions, 0 means no limit. By default 'suggestBudgetMs' from smartkey.conf is used. Can be ommited.
+\param sessionId Id of the client session (e.g. keyboard instance). Used together with 'seq'. Can be ommited.
+\param seq Sequence number of the request, growing within the session. A request with a bigger number supersedes all older requests of the session which are still queued or running. Can be ommited.
 
 \subsection com_palm_smartKey_service_reply Reply:
 \code
 {
     "spelledCorrectly" : boolean
+    "partial" : boolean
+    "superseded" : boolean
+    "seq" : int
 	"guesses : [
 		{
         "str" : string
@@ -995,6 +1213,9 @@ search the candidate substitution word for the query word.
 }
 \endcode
 \param spelledCorrectly Set as true, if there is no error, otherwise false. Required
+\param partial Set as true, if time budget was spent and guesses were made without full dictionary search. Optional
+\param superseded Set as true, if a newer request of the same session was received; there are no guesses in the reply then. Optional
+\param seq Sequence number of the request, if it was given. Optional
 \param guesses a array of guess object which contain the substitution string. Optional
 \param str The actual guess of the word.
 \param sp  true if guess is a result of a spelling correction
@@ -1040,6 +1261,45 @@ luna-send -n 1 -f palm://com.palm.smartKey/search '{ "query": "oul", "context":
 \endcode
 */
 bool SmartKeyService::cmdSearch (LSHandle* sh, LSMessage* message, void* ctx)
+{
+    SmartKeyService* service = static_cast<SmartKeyService*>(ctx);
+
+    // A newer request of the session supersedes older ones, it has to be registered in the order
+    // of arrival (before it is queued) so workers can skip requests nobody waits for.
+    if (message && service)
+    {
+        json_object* json = json_tokener_parse(LSMessageGetPayload(message));
+        if (ValidJsonObject(json))
+        {
+            std::string session;
+            int seq = 0;
+
+            if (getRequestSeq(json, session, seq) && !service->m_sessions.start(session, seq))
+                g_debug("%s: request %d of session '%s' is already superseded", __FUNCTION__, seq, session.c_str());
+
+            json_object_put(json);
+        }
+    }
+
+    return(dispatchRequest(doSearch, sh, message, ctx));
+}
+
+/**
+* spell check word, runs in worker thread (or on main loop if there are no worker threads)
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   false if payload is not valid
+*/
+bool SmartKeyService::doSearch (LSHandle* sh, LSMessage* message, void* ctx)
 {
     if (!message)
     {
@@ -1053,6 +1313,7 @@ bool SmartKeyService::cmdSearch (LSHandle* sh, LSMessage* message, void* ctx)
     g_debug("%s: received '%s'", __FUNCTION__, payload);
 
     SmartKeyService* service = static_cast<SmartKeyService*>(ctx);
+    SmkyEngineReadLock lock(service->m_engine);
 
     LSError lserror;
     LSErrorInit(&lserror);
@@ -1066,7 +1327,20 @@ bool SmartKeyService::cmdSearch (LSHandle* sh, LSMessage* message, void* ctx)
     json_object* replyJson = json_object_new_object();
     SmartKeyErrorCode err = SKERR_SUCCESS;
 
-    if (service->isEnabled())
+    std::string session;
+    int seq = 0;
+    bool hasSeq = getRequestSeq(json, session, seq);
+
+    SmkyRequestTicket ticket;
+    if (hasSeq)
+        ticket = service->m_sessions.getTicket(session, seq);
+
+    if (ticket.isSuperseded())
+    {
+        // nobody waits for the guesses, a newer request of the session is queued already
+        json_object_object_add(replyJson, "superseded", json_object_new_boolean(true));
+    }
+    else if (service->isEnabled())
     {
         SpellCheckWordInfo	result;
 
@@ -1089,127 +1363,41 @@ bool SmartKeyService::cmdSearch (LSHandle* sh, LSMessage* message, void* ctx)
             maxGuesses = json_object_get_int(limitValue);
         }
 
-        json_object* value = json_object_object_get(json, "query");
-        if (ValidJsonObject(value))
+        int budgetMs = -1;
+        json_object* budgetValue = json_object_object_get(json, "budget");
+        if (ValidJsonObject(budgetValue))
         {
-            std::string query = json_object_get_string(value);
-
-            if (query.empty() || wordIsAllPunctuation(query))
-            {
-                err = SKERR_BAD_PARAM;
-                result.inDictionary = false;
-            }
-            else if (wordIsUrl(query))
-            {
-                // It's not really in the dictionary, but this will keep these things from
-                // being underlined or auto-corrected.
-                result.inDictionary = true;
-            }
-            else
-            {
-                if (!isGoodWord(query))
-                {
-                    err = SKERR_BAD_WORD;
-                    result.inDictionary = false;
-                }
-                else
-                {
-                    // Before we spell check let's first check to see if the query (with any punctuation)
-                    // matches an auto-replace entry. If so we'll do that first. Else spell-check.
-                    SmkyAutoSubDatabase* autosubdatabase = service->m_engine->getAutoSubDatabase();
-                    std::string substitution;
-                    if (autosubdatabase)
-                        substitution = autosubdatabase->findEntry(query);
-
-                    if (!substitution.empty())
-                    {
-                        result.inDictionary = true;
-                        if (query != substitution)  	// Only happens for ASDB entries that differ only by case (i->I)
-                        {
-                            //g_debug("'%s' found in auto-sub db. Returning as valid.", query.c_str());
-                            result.guesses.push_back(WordGuess(query));	// First result is always input word.
-
-                            WordGuess guess(substitution);
-                            guess.autoReplace = true;
-                            guess.autoAccept = true;
-                            result.guesses.push_back(guess);
-                        }
-                    }
-                    else
-                    {
-                        std::string leadingChars, trailingChars;
-                        std::string strippedQuery = stripPunctuation(query, leadingChars, trailingChars);
-                        std::string strippedContext;
-                        if (context.length())
-                        {
-                            std::string leadingChars, trailingChars;
-                            strippedContext = stripPunctuation(context, leadingChars, trailingChars);
-                        }
+            budgetMs = json_object_get_int(budgetValue);
+        }
 
     #if USE_KEY_LOCALITY
-                        // "quick" will tell us if we should force the use of checkSpelling, which is much faster, but not as smart as autoCorrect which uses key regional information
-                        bool	useAutoCorrect = true;
-                        json_object * autorequest = json_object_object_get(json, "quick");
-                        if (autorequest && ValidJsonObject(autorequest) && json_object_get_boolean(autorequest))
-                            useAutoCorrect = false;
-
-                        if (useAutoCorrect)
-                            err = service->m_engine->autoCorrect(strippedQuery, strippedContext, result, maxGuesses);
-                        else
-                            err = service->m_engine->checkSpelling(strippedQuery, result, maxGuesses);
+        // "quick" will tell us if we should force the use of checkSpelling, which is much faster, but not as smart as autoCorrect which uses key regional information
+        bool	useAutoCorrect = true;
+        json_object * autorequest = json_object_object_get(json, "quick");
+        if (autorequest && ValidJsonObject(autorequest) && json_object_get_boolean(autorequest))
+            useAutoCorrect = false;
     #else
-                        err = service->m_engine->checkSpelling(strippedQuery, result, maxGuesses);
+        bool	useAutoCorrect = false;
     #endif
-                        if (!leadingChars.empty() || !trailingChars.empty())
-                        {
-                            std::vector<WordGuess>::iterator gi;
-                            for (gi = result.guesses.begin(); gi != result.guesses.end(); ++gi)
-                            {
-                                // Add the same punctuation to the guess to match the query word.
-                                gi->guess = restorePunctuation(gi->guess, leadingChars, trailingChars);
-                            }
-                        }
-                    }
-                }
-            }
+
+        json_object* value = json_object_object_get(json, "query");
+        if (ValidJsonObject(value))
+        {
+            err = service->searchWord(json_object_get_string(value), context, useAutoCorrect, maxGuesses, budgetMs, ticket, result);
         }
         else
         {
             g_debug("Can't find query param.");
         }
 
-        if (err == SKERR_SUCCESS)
+        if (err == SKERR_SUCCESS && ticket.isSuperseded())
         {
-            json_object_object_add(replyJson, "spelledCorrectly", json_object_new_boolean(result.inDictionary));
-
-            json_object* guessesJson = json_object_new_array();
-            if (guessesJson)
-            {
-                std::vector<WordGuess>::const_iterator i;
-                for (i = result.guesses.begin(); i != result.guesses.end(); ++i)
-                {
-                    json_object* wordReplyJson = json_object_new_object();
-                    if (wordReplyJson)
-                    {
-                        json_object_object_add(wordReplyJson, "str", json_object_new_string(i->guess.c_str()) );
-                        json_object_object_add(wordReplyJson, "sp", json_object_new_boolean(i->spellCorrection) );
-                        if (i->autoReplace)
-                        {
-                            // default assumed to be false so will only set property if not the default
-                            json_object_object_add(wordReplyJson, "auto-replace", json_object_new_boolean(i->autoReplace) );
-                        }
-
-                        if (i->autoAccept)
-                        {
-                            // default assumed to be false so will only set property if not the default
-                            json_object_object_add(wordReplyJson, "auto-accept", json_object_new_boolean(i->autoAccept) );
-                        }
-
-                        json_object_array_add( guessesJson, wordReplyJson );
-                    }
-                }
-                json_object_object_add( replyJson, const_cast<char*>("guesses"), guessesJson );
-            }
+            // guesses were cut short by a newer request of the session
+            json_object_object_add(replyJson, "superseded", json_object_new_boolean(true));
+        }
+        else if (err == SKERR_SUCCESS)
+        {
+            addSearchResult(replyJson, result);
         }
     }
     else
@@ -1217,6 +1405,9 @@ bool SmartKeyService::cmdSearch (LSHandle* sh, LSMessage* message, void* ctx)
         err = SKERR_DISABLED;
     }
 
+    if (hasSeq)
+        json_object_object_add(replyJson, "seq", json_object_new_int(seq));
+
     setReplyResponse(replyJson, err);
     const char * replyString = json_object_to_json_string(replyJson);
 
@@ -1233,49 +1424,885 @@ bool SmartKeyService::cmdSearch (LSHandle* sh, LSMessage* message, void* ctx)
 }
 
 /**
-* notify user db change
+* spell check single word of search request: auto-replace entries first, then the engine
 *
-* @param eAction
-*   input: DbAction
+* @param query
+*   word to check, may have leading/trailing punctuation
 *
-* @param word
-*   word
+* @param context
+*   the word prior to query (used by autoCorrect only)
 *
-* @return bool
-*   true if succeed
+* @param useAutoCorrect
+*   use autoCorrect (smarter, regional information of keys) instead of checkSpelling
+*
+* @param maxGuesses
+*   number of words in result
+*
+* @param budgetMs
+*   time budget (ms) for suggestions, < 0 - default from settings, 0 - no limit
+*
+* @param ticket
+*   request ticket, suggestions are cut short when request is superseded
+*
+* @param result
+*   output: result
+*
+* @return SmartKeyErrorCode
+*   SKERR_SUCCESS if done
 */
-bool SmartKeyService::notifyUserDbChange (DbAction eAction, const std::string& word)
+SmartKeyErrorCode SmartKeyService::searchWord (const std::string& query, const std::string& context, bool useAutoCorrect, int maxGuesses, int budgetMs, const SmkyRequestTicket& ticket, SpellCheckWordInfo& result)
 {
-    if (word.empty())
-        return false;
+    SmartKeyErrorCode err = SKERR_SUCCESS;
+    std::string word = query;
 
-    LSError lsError;
+    if (word.empty() || wordIsAllPunctuation(word))
+    {
+        err = SKERR_BAD_PARAM;
+        result.inDictionary = false;
+    }
+    else if (wordIsUrl(word))
+    {
+        // It's not really in the dictionary, but this will keep these things from
+        // being underlined or auto-corrected.
+        result.inDictionary = true;
+    }
+    else if (!isGoodWord(word))
+    {
+        err = SKERR_BAD_WORD;
+        result.inDictionary = false;
+    }
+    else
+    {
+        // Before we spell check let's first check to see if the query (with any punctuation)
+        // matches an auto-replace entry. If so we'll do that first. Else spell-check.
+        SmkyAutoSubDatabase* autosubdatabase = m_engine->getAutoSubDatabase();
+        std::string substitution;
+        if (autosubdatabase)
+            substitution = autosubdatabase->findEntry(word);
 
-    LSErrorInit(&lsError);
+        if (!substitution.empty())
+        {
+            result.inDictionary = true;
+            if (word != substitution)  	// Only happens for ASDB entries that differ only by case (i->I)
+            {
+                //g_debug("'%s' found in auto-sub db. Returning as valid.", word.c_str());
+                result.guesses.push_back(WordGuess(word));	// First result is always input word.
 
-    json_object* json = json_object_new_object();
-    json_object_object_add(json, "database", json_object_new_string("user"));
-    json_object_object_add(json, "action",
-                           json_object_new_string(eAction == AddedToDatabase ? "added" : "removed"));
-    json_object_object_add(json, "word", json_object_new_string(word.c_str()));
+                WordGuess guess(substitution);
+                guess.autoReplace = true;
+                guess.autoAccept = true;
+                result.guesses.push_back(guess);
+            }
+        }
+        else
+        {
+            std::string leadingChars, trailingChars;
+            std::string strippedQuery = stripPunctuation(word, leadingChars, trailingChars);
+            std::string strippedContext;
+            if (context.length())
+            {
+                std::string leadingChars, trailingChars;
+                strippedContext = stripPunctuation(context, leadingChars, trailingChars);
+            }
 
-    bool succeeded = LSSignalSend(m_service, dbModSignalName, json_object_to_json_string(json), &lsError);
-    if (!succeeded)
-    {
-        LSErrorPrint(&lsError, stderr);
-        LSErrorFree(&lsError);
-    }
+            if (useAutoCorrect)
+                err = m_engine->autoCorrect(strippedQuery, strippedContext, result, maxGuesses, budgetMs, ticket);
+            else
+                err = m_engine->checkSpelling(strippedQuery, result, maxGuesses, budgetMs, ticket);
 
-    json_object_put(json);
+            if (!leadingChars.empty() || !trailingChars.empty())
+            {
+                std::vector<WordGuess>::iterator gi;
+                for (gi = result.guesses.begin(); gi != result.guesses.end(); ++gi)
+                {
+                    // Add the same punctuation to the guess to match the query word.
+                    gi->guess = restorePunctuation(gi->guess, leadingChars, trailingChars);
+                }
+            }
+        }
+    }
 
-    return succeeded;
+    return err;
 }
 
 /**
-* notify volatile db change
+* add search result ('spelledCorrectly', 'partial' and 'guesses' properties) to reply
 *
-* @param eAction
-*   input: DbAction
+* @param replyJson
+*   reply object
+*
+* @param result
+*   result of searchWord
+*/
+void SmartKeyService::addSearchResult (json_object* replyJson, const SpellCheckWordInfo& result)
+{
+    json_object_object_add(replyJson, "spelledCorrectly", json_object_new_boolean(result.inDictionary));
+
+    if (result.partial)
+    {
+        // default assumed to be false so will only set property if not the default
+        json_object_object_add(replyJson, "partial", json_object_new_boolean(result.partial));
+    }
+
+    json_object* guessesJson = json_object_new_array();
+    if (guessesJson)
+    {
+        std::vector<WordGuess>::const_iterator i;
+        for (i = result.guesses.begin(); i != result.guesses.end(); ++i)
+        {
+            json_object* wordReplyJson = json_object_new_object();
+            if (wordReplyJson)
+            {
+                json_object_object_add(wordReplyJson, "str", json_object_new_string(i->guess.c_str()) );
+                json_object_object_add(wordReplyJson, "sp", json_object_new_boolean(i->spellCorrection) );
+                if (i->autoReplace)
+                {
+                    // default assumed to be false so will only set property if not the default
+                    json_object_object_add(wordReplyJson, "auto-replace", json_object_new_boolean(i->autoReplace) );
+                }
+
+                if (i->autoAccept)
+                {
+                    // default assumed to be false so will only set property if not the default
+                    json_object_object_add(wordReplyJson, "auto-accept", json_object_new_boolean(i->autoAccept) );
+                }
+
+                json_object_array_add( guessesJson, wordReplyJson );
+            }
+        }
+        json_object_object_add( replyJson, const_cast<char*>("guesses"), guessesJson );
+    }
+}
+
+/*! \page  com_palm_smartKey_service
+\n
+\section  com_palm_smartKey_searchBatch searchBatch
+
+com_palm_smartKey_service/searchBatch
+
+search the candidate substitution words for many query words in one call.
+
+\subsection com_palm_smartKey_service_syntax Syntax:
+\code
+{
+	"words": [
+		string
+		or
+		{
+		"query": string,
+		"context": string
+		}
+	]
+	"quick": boolean
+	"extended" : boolean
+	"max": int
+	"budget": int
+}
+\endcode
+
+\param words Array of words to correct, every item is either the word or an object with the word and the context word prior to it. Required. At most 200 words.
+\param query The word to correct. Required.
+\param context The context word prior to the word to correct. Optional.
+\param quick If set as true, engine will use checkSpelling for all words. Can be ommited.
+\param extended If set as true, engine will generate more suggestions in output (=60). Can be ommited.
+\param max Maximum number of guesses for every word, by default is 10. This parameter have priority over parameter 'extended'. Can be ommited.
+\param budget Time budget in milliseconds for generating suggestions of every word, at most (and by default) 'suggestBudgetMs' from smartkey.conf. All words share 'batchBudgetMs' from smartkey.conf, words checked after it was spent get partial results. Can be ommited.
+
+\subsection com_palm_smartKey_service_reply Reply:
+\code
+{
+	"results": [
+		{
+		"query" : string
+		"spelledCorrectly" : boolean
+		"partial" : boolean
+		"guesses" : [ ... ]
+		"errorCode": int
+		"errorText": string
+		}
+	]
+    "returnValue": boolean
+    "errorCode": int
+    "errorText": string
+}
+\endcode
+\param results Array of results in the order of 'words', each one is the same as reply of 'search' for the word. Repeated words are checked only once.
+\param query The word as it was given.
+\param errorCode the error code if the word can't be checked, there are no other properties then. Optional
+\param errorText the error text if the word can't be checked. Optional
+\param returnValue true (success) or false (failure). Required
+\param errorCode the error code of error if there is error. Optional
+\param errorText the error text of error if there is error. Optional
+
+\subsection com_palm_smartKey_service_examples Examples:
+\code
+
+luna-send -n 1 -f palm://com.palm.smartKey/searchBatch '{ "words": [ "helo", { "query": "wrold", "context": "helo" }, "helo" ], "quick": true, "max": 2 }'
+{
+    "results": [
+        {
+            "query": "helo",
+            "spelledCorrectly": false,
+            "guesses": [
+                {
+                    "str": "hello",
+                    "sp": true
+                },
+                {
+                    "str": "help",
+                    "sp": true
+                }
+            ]
+        },
+        {
+            "query": "wrold",
+            "spelledCorrectly": false,
+            "guesses": [
+                {
+                    "str": "world",
+                    "sp": true
+                }
+            ]
+        },
+        {
+            "query": "helo",
+            "spelledCorrectly": false,
+            "guesses": [
+                {
+                    "str": "hello",
+                    "sp": true
+                },
+                {
+                    "str": "help",
+                    "sp": true
+                }
+            ]
+        }
+    ],
+    "returnValue": true
+}
+
+\endcode
+*/
+bool SmartKeyService::cmdSearchBatch (LSHandle* sh, LSMessage* message, void* ctx)
+{
+    return(dispatchRequest(doSearchBatch, sh, message, ctx));
+}
+
+/**
+* spell check many words, runs in worker thread (or on main loop if there are no worker threads)
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   false if payload is not valid
+*/
+bool SmartKeyService::doSearchBatch (LSHandle* sh, LSMessage* message, void* ctx)
+{
+    if (!message)
+    {
+        return true;
+    }
+
+    double start = getTime();
+
+    const char* payload = LSMessageGetPayload(message);
+
+    g_debug("%s: received '%s'", __FUNCTION__, payload);
+
+    SmartKeyService* service = static_cast<SmartKeyService*>(ctx);
+
+    LSError lserror;
+    LSErrorInit(&lserror);
+
+    json_object* json = json_tokener_parse(payload);
+    if (!ValidJsonObject(json))
+    {
+        return false;
+    }
+
+    json_object* replyJson = json_object_new_object();
+    SmartKeyErrorCode err = SKERR_SUCCESS;
+
+    json_object* wordsValue = json_object_object_get(json, "words");
+
+    if (!service->isEnabled())
+    {
+        err = SKERR_DISABLED;
+    }
+    else if (!ValidJsonObject(wordsValue) || !json_object_is_type(wordsValue, json_type_array))
+    {
+        err = SKERR_MISSING_PARAM;
+    }
+    else if (json_object_array_length(wordsValue) > SMK_MAX_BATCH_WORDS)
+    {
+        err = SKERR_BAD_PARAM;
+    }
+    else
+    {
+        int maxGuesses = SMK_MIN_GUESSES;
+
+        json_object* extendedValue = json_object_object_get(json, "extended");
+        if( ValidJsonObject(extendedValue) && json_object_get_boolean(extendedValue) )
+        {
+            maxGuesses = SMK_MAX_GUESSES;
+        }
+
+        json_object* limitValue = json_object_object_get(json, "max");
+        if (ValidJsonObject(limitValue))
+        {
+            maxGuesses = json_object_get_int(limitValue);
+        }
+
+        int budgetMs = -1;
+        json_object* budgetValue = json_object_object_get(json, "budget");
+        if (ValidJsonObject(budgetValue))
+        {
+            budgetMs = json_object_get_int(budgetValue);
+        }
+
+    #if USE_KEY_LOCALITY
+        bool	useAutoCorrect = true;
+        json_object * autorequest = json_object_object_get(json, "quick");
+        if (autorequest && ValidJsonObject(autorequest) && json_object_get_boolean(autorequest))
+            useAutoCorrect = false;
+    #else
+        bool	useAutoCorrect = false;
+    #endif
+
+        int count = json_object_array_length(wordsValue);
+
+        // all words share one budget, the engine is unlocked between words, so dictionary changes don't wait for the whole batch
+        SmkyDeadline batchDeadline(Settings::getInstance()->batchBudgetMs);
+
+        std::vector<SpellCheckWordInfo> results(count);
+        std::vector<SmartKeyErrorCode> errors(count, SKERR_SUCCESS);
+        std::vector<std::string> queries(count);
+
+        // repeated words (with the same context for autoCorrect) are checked once: key -> index of the first one
+        std::map<std::string, int> checked;
+
+        for (int i = 0; i < count; ++i)
+        {
+            json_object* item = json_object_array_get_idx(wordsValue, i);
+            std::string context;
+
+            if (ValidJsonObject(item) && json_object_is_type(item, json_type_object))
+            {
+                json_object* value = json_object_object_get(item, "query");
+                if (ValidJsonObject(value))
+                    queries[i] = json_object_get_string(value);
+
+                value = json_object_object_get(item, "context");
+                if (ValidJsonObject(value))
+                    context = json_object_get_string(value);
+            }
+            else if (ValidJsonObject(item))
+            {
+                queries[i] = json_object_get_string(item);
+            }
+
+            std::string key = useAutoCorrect ? queries[i] + '\x1f' + context : queries[i];
+            std::map<std::string, int>::iterator it = checked.find(key);
+
+            if (it != checked.end())
+            {
+                results[i] = results[it->second];
+                errors[i] = errors[it->second];
+            }
+            else
+            {
+                SmkyEngineReadLock lock(service->m_engine);
+                errors[i] = service->searchWord(queries[i], context, useAutoCorrect, maxGuesses, getBatchWordBudgetMs(budgetMs, batchDeadline), SmkyRequestTicket(), results[i]);
+                checked[key] = i;
+            }
+        }
+
+        json_object* resultsJson = json_object_new_array();
+
+        for (int i = 0; i < count; ++i)
+        {
+            json_object* resultJson = json_object_new_object();
+
+            json_object_object_add(resultJson, "query", json_object_new_string(queries[i].c_str()));
+
+            if (errors[i] == SKERR_SUCCESS)
+            {
+                addSearchResult(resultJson, results[i]);
+            }
+            else
+            {
+                json_object_object_add(resultJson, "errorCode", json_object_new_int(errors[i]));
+                json_object_object_add(resultJson, "errorText", json_object_new_string(getErrorString(errors[i])));
+            }
+
+            json_object_array_add(resultsJson, resultJson);
+        }
+
+        json_object_object_add(replyJson, "results", resultsJson);
+
+        g_debug("%s: %d words, %u checked", __FUNCTION__, count, (unsigned int)checked.size());
+    }
+
+    setReplyResponse(replyJson, err);
+    const char * replyString = json_object_to_json_string(replyJson);
+
+    if (!LSMessageReply(sh, message, replyString, &lserror))
+    {
+        LSErrorPrint(&lserror, stderr);
+        LSErrorFree(&lserror);
+    }
+    g_debug("%s: %g msec to return '%s'", __FUNCTION__, (getTime()-start) * 1000.0, replyString);
+    json_object_put(replyJson);
+    json_object_put(json);
+
+    return true;
+}
+
+/*! \page  com_palm_smartKey_service
+\n
+\section  com_palm_smartKey_checkText checkText
+
+com_palm_smartKey_service/checkText
+
+find misspelled words in the text. Text is split into words by white spaces, every word is checked as 'search' with "quick" option does.
+
+\subsection com_palm_smartKey_service_syntax Syntax:
+\code
+{
+	"text": string,
+	"documentId": string,
+	"closed": boolean,
+	"max": int
+	"budget": int
+}
+\endcode
+
+\param text The text to check. Required. At most 65536 bytes.
+\param documentId Id of the document the text belongs to. Results of words are kept for the document, so next checks of the same document check only words which were not in it before (edited words are new words). Everything is checked if there is no documentId. Optional.
+\param closed The document is closed, its results are dropped after this check (text may be empty). Optional.
+\param max Maximum number of guesses for every misspelled word, by default is 10. Can be ommited.
+\param budget Time budget in milliseconds for generating suggestions of every word, at most (and by default) 'suggestBudgetMs' from smartkey.conf. All words share 'batchBudgetMs' from smartkey.conf, words checked after it was spent get partial results. Can be ommited.
+
+\subsection com_palm_smartKey_service_reply Reply:
+\code
+{
+	"misspelled": [
+		{
+		"offset" : int
+		"length" : int
+		"str" : string
+		"spelledCorrectly" : boolean
+		"partial" : boolean
+		"guesses" : [ ... ]
+		}
+	]
+    "returnValue": boolean
+    "errorCode": int
+    "errorText": string
+}
+\endcode
+\param misspelled Array of misspelled words in the order of the text.
+\param offset Offset of the word in the text (in characters).
+\param length Length of the word (in characters), leading and trailing punctuation included.
+\param str The word.
+\param spelledCorrectly Always false.
+\param partial Set as true, if time budget was spent and guesses were made without full dictionary search. Optional
+\param guesses a array of guess object, the same as in reply of 'search'.
+\param returnValue true (success) or false (failure). Required
+\param errorCode the error code of error if there is error. Optional
+\param errorText the error text of error if there is error. Optional
+
+\subsection com_palm_smartKey_service_examples Examples:
+\code
+
+luna-send -n 1 -f palm://com.palm.smartKey/checkText '{ "text": "Helo wrold, hello!", "documentId": "mail-1", "max": 1 }'
+{
+    "misspelled": [
+        {
+            "offset": 0,
+            "length": 4,
+            "str": "Helo",
+            "spelledCorrectly": false,
+            "guesses": [
+                {
+                    "str": "Hello",
+                    "sp": true
+                }
+            ]
+        },
+        {
+            "offset": 5,
+            "length": 6,
+            "str": "wrold,",
+            "spelledCorrectly": false,
+            "guesses": [
+                {
+                    "str": "world,",
+                    "sp": true
+                }
+            ]
+        }
+    ],
+    "returnValue": true
+}
+
+luna-send -n 1 -f palm://com.palm.smartKey/checkText '{ "text": "Hello wrold, hello!", "documentId": "mail-1", "max": 1 }'
+{
+    "misspelled": [
+        {
+            "offset": 6,
+            "length": 6,
+            "str": "wrold,",
+            "spelledCorrectly": false,
+            "guesses": [
+                {
+                    "str": "world,",
+                    "sp": true
+                }
+            ]
+        }
+    ],
+    "returnValue": true
+}
+
+luna-send -n 1 -f palm://com.palm.smartKey/checkText '{ "text": "", "documentId": "mail-1", "closed": true }'
+{
+    "misspelled": [
+    ],
+    "returnValue": true
+}
+
+\endcode
+*/
+bool SmartKeyService::cmdCheckText (LSHandle* sh, LSMessage* message, void* ctx)
+{
+    return(dispatchRequest(doCheckText, sh, message, ctx));
+}
+
+/**
+* find misspelled words in the text, runs in worker thread (or on main loop if there are no worker threads)
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   false if payload is not valid
+*/
+bool SmartKeyService::doCheckText (LSHandle* sh, LSMessage* message, void* ctx)
+{
+    if (!message)
+    {
+        return true;
+    }
+
+    double start = getTime();
+
+    const char* payload = LSMessageGetPayload(message);
+
+    g_debug("%s: received '%s'", __FUNCTION__, payload);
+
+    SmartKeyService* service = static_cast<SmartKeyService*>(ctx);
+
+    LSError lserror;
+    LSErrorInit(&lserror);
+
+    json_object* json = json_tokener_parse(payload);
+    if (!ValidJsonObject(json))
+    {
+        return false;
+    }
+
+    json_object* replyJson = json_object_new_object();
+    SmartKeyErrorCode err = SKERR_SUCCESS;
+
+    json_object* textValue = json_object_object_get(json, "text");
+    std::string text;
+    if (ValidJsonObject(textValue))
+        text = json_object_get_string(textValue);
+
+    if (!service->isEnabled())
+    {
+        err = SKERR_DISABLED;
+    }
+    else if (!ValidJsonObject(textValue))
+    {
+        err = SKERR_MISSING_PARAM;
+    }
+    else if (text.length() > SMK_MAX_TEXT_LENGTH || !g_utf8_validate(text.c_str(), text.length(), NULL))
+    {
+        err = SKERR_BAD_PARAM;
+    }
+    else
+    {
+        int maxGuesses = SMK_MIN_GUESSES;
+        json_object* limitValue = json_object_object_get(json, "max");
+        if (ValidJsonObject(limitValue))
+        {
+            maxGuesses = json_object_get_int(limitValue);
+        }
+
+        int budgetMs = -1;
+        json_object* budgetValue = json_object_object_get(json, "budget");
+        if (ValidJsonObject(budgetValue))
+        {
+            budgetMs = json_object_get_int(budgetValue);
+        }
+
+        std::string document;
+        json_object* documentValue = json_object_object_get(json, "documentId");
+        if (ValidJsonObject(documentValue))
+            document = json_object_get_string(documentValue);
+
+        json_object* closedValue = json_object_object_get(json, "closed");
+        bool closed = ValidJsonObject(closedValue) && json_object_get_boolean(closedValue);
+
+        std::vector<TextToken> tokens;
+        tokenizeText(text, tokens);
+
+        // all words share one budget, the engine is unlocked between words, so dictionary changes don't wait for the whole text
+        SmkyDeadline batchDeadline(Settings::getInstance()->batchBudgetMs);
+
+        int checked = 0;
+        json_object* misspelledJson = json_object_new_array();
+
+        for (size_t i = 0; i < tokens.size(); ++i)
+        {
+            const TextToken& token = tokens[i];
+            std::string word = text.substr(token.start, token.length);
+            SpellCheckWordInfo result;
+
+            SmkyEngineReadLock lock(service->m_engine);
+
+            // results of the document depend on locale and number of guesses, locale may change between words
+            std::string options = string_printf("%s\x1f%d", Settings::getInstance()->localeSettings.getFullLocale().c_str(), maxGuesses);
+
+            // results are kept per word, not per position, so an edited word is looked up as a new one
+            if (document.empty() || !service->m_documents.lookup(document, options, word, result))
+            {
+                // numbers, urls and words with punctuation inside are not checked
+                if (service->searchWord(word, "", false, maxGuesses, getBatchWordBudgetMs(budgetMs, batchDeadline), SmkyRequestTicket(), result) != SKERR_SUCCESS)
+                    result.clear();
+
+                //partial results depend on timing, don't keep them
+                if (!document.empty() && !result.partial)
+                    service->m_documents.store(document, options, word, result);
+
+                checked++;
+            }
+
+            if (!result.inDictionary)
+            {
+                json_object* wordJson = json_object_new_object();
+
+                json_object_object_add(wordJson, "offset", json_object_new_int(token.offset));
+                json_object_object_add(wordJson, "length", json_object_new_int(token.chars));
+                json_object_object_add(wordJson, "str", json_object_new_string(word.c_str()));
+                addSearchResult(wordJson, result);
+
+                json_object_array_add(misspelledJson, wordJson);
+            }
+        }
+
+        json_object_object_add(replyJson, "misspelled", misspelledJson);
+
+        if (closed && !document.empty())
+            service->m_documents.remove(document);
+
+        g_debug("%s: %u words, %d checked", __FUNCTION__, (unsigned int)tokens.size(), checked);
+    }
+
+    setReplyResponse(replyJson, err);
+    const char * replyString = json_object_to_json_string(replyJson);
+
+    if (!LSMessageReply(sh, message, replyString, &lserror))
+    {
+        LSErrorPrint(&lserror, stderr);
+        LSErrorFree(&lserror);
+    }
+    g_debug("%s: %g msec to return '%s'", __FUNCTION__, (getTime()-start) * 1000.0, replyString);
+    json_object_put(replyJson);
+    json_object_put(json);
+
+    return true;
+}
+
+/**
+* get time budget of a word of searchBatch or checkText request: requested budget is limited by
+* suggestBudgetMs (0 in request doesn't lift the limit) and by the rest of the budget of the whole request
+*
+* @param budgetMs
+*   budget requested for every word, < 0 - not requested
+*
+* @param batchDeadline
+*   budget of the whole request
+*
+* @return int
+*   budget of the word (ms), 0 - no limit
+*/
+int SmartKeyService::getBatchWordBudgetMs (int budgetMs, const SmkyDeadline& batchDeadline)
+{
+    int limit = Settings::getInstance()->suggestBudgetMs;
+
+    if (limit > 0 && (budgetMs <= 0 || budgetMs > limit))
+        budgetMs = limit;
+    else if (budgetMs < 0)
+        budgetMs = limit;
+
+    if (batchDeadline.isLimited())
+    {
+        // words after the budget was spent still get a minimal one, their guesses are partial
+        int rest = (int)std::max<gint64>(batchDeadline.getRemainingUs() / 1000, 1);
+
+        if (budgetMs <= 0 || budgetMs > rest)
+            budgetMs = rest;
+    }
+
+    return budgetMs;
+}
+
+/**
+* split text into words by white spaces
+*
+* @param text
+*   UTF-8 text
+*
+* @param tokens
+*   output: words, in the order of the text
+*/
+void SmartKeyService::tokenizeText (const std::string& text, std::vector<TextToken>& tokens)
+{
+    tokens.clear();
+
+    const gchar* p_begin = text.c_str();
+    const gchar* p_end = p_begin + text.length();
+    const gchar* p = p_begin;
+
+    TextToken token;
+    bool inToken = false;
+    glong offset = 0;
+
+    while (p < p_end)
+    {
+        if (g_unichar_isspace(g_utf8_get_char(p)))
+        {
+            if (inToken)
+            {
+                token.length = (p - p_begin) - token.start;
+                tokens.push_back(token);
+                inToken = false;
+            }
+        }
+        else
+        {
+            if (!inToken)
+            {
+                token.start = p - p_begin;
+                token.offset = offset;
+                token.chars = 0;
+                inToken = true;
+            }
+
+            token.chars++;
+        }
+
+        p = g_utf8_next_char(p);
+        offset++;
+    }
+
+    if (inToken)
+    {
+        token.length = text.length() - token.start;
+        tokens.push_back(token);
+    }
+}
+
+/**
+* get optional session id and sequence number of request
+*
+* @param json
+*   request
+*
+* @param session
+*   output: value of 'sessionId'
+*
+* @param seq
+*   output: value of 'seq'
+*
+* @return bool
+*   true if request has both of them
+*/
+bool SmartKeyService::getRequestSeq (json_object* json, std::string& session, int& seq)
+{
+    json_object* sessionValue = json_object_object_get(json, "sessionId");
+    json_object* seqValue = json_object_object_get(json, "seq");
+
+    if (!ValidJsonObject(sessionValue) || !ValidJsonObject(seqValue))
+        return false;
+
+    session = json_object_get_string(sessionValue);
+    seq = json_object_get_int(seqValue);
+
+    return true;
+}
+
+/**
+* notify user db change
+*
+* @param eAction
+*   input: DbAction
+*
+* @param word
+*   word
+*
+* @return bool
+*   true if succeed
+*/
+bool SmartKeyService::notifyUserDbChange (DbAction eAction, const std::string& word)
+{
+    if (word.empty())
+        return false;
+
+    LSError lsError;
+
+    LSErrorInit(&lsError);
+
+    json_object* json = json_object_new_object();
+    json_object_object_add(json, "database", json_object_new_string("user"));
+    json_object_object_add(json, "action",
+                           json_object_new_string(eAction == AddedToDatabase ? "added" : "removed"));
+    json_object_object_add(json, "word", json_object_new_string(word.c_str()));
+
+    bool succeeded = LSSignalSend(m_service, dbModSignalName, json_object_to_json_string(json), &lsError);
+    if (!succeeded)
+    {
+        LSErrorPrint(&lsError, stderr);
+        LSErrorFree(&lsError);
+    }
+
+    json_object_put(json);
+
+    return succeeded;
+}
+
+/**
+* notify volatile db change
+*
+* @param eAction
+*   input: DbAction
 *
 * @param word
 *   word
@@ -1384,6 +2411,186 @@ bool SmartKeyService::notifyLanguageChanged (LanguageAction eAction)
     return succeeded;
 }
 
+/**
+* get the latest requested locale: changes of preferences are applied to it
+*
+* @return LocaleSettings
+*   pending locale, locale being loaded or current one
+*/
+const LocaleSettings& SmartKeyService::getRequestedLocale (void) const
+{
+    if (m_pendingAction != LanguageActionNone)
+        return m_pendingLocale;
+
+    if (m_localeLoad)
+        return m_localeLoad->locale;
+
+    return Settings::getInstance()->localeSettings;
+}
+
+/**
+* load dictionaries of the locale in background thread, current dictionaries keep serving requests
+* meanwhile. Loaded dictionaries are swapped in on the main loop (see localeLoadDoneCallback).
+* Only one locale is loaded at once, the latest locale requested meanwhile is loaded next.
+* Dictionaries of a recently used locale are taken from the pool and swapped in right away.
+*
+* @param locale
+*   new locale settings
+*
+* @param eAction
+*   what was changed (sent by languageChanged signal after the swap)
+*/
+void SmartKeyService::loadLocale (const LocaleSettings& locale, LanguageAction eAction)
+{
+    if (m_localeLoad)
+    {
+        m_pendingLocale = locale;
+        m_pendingAction = std::max(m_pendingAction, eAction);
+        return;
+    }
+
+    SmkyLocaleDictionaries* p_dicts = m_localePool.take(locale);
+    if (p_dicts)
+    {
+        g_debug("%s: dictionaries of '%s' are kept in the pool", __FUNCTION__, locale.getFullLocale().c_str());
+
+        //preferences not affecting dictionaries may differ, keyboard layout ranks guesses
+        if (p_dicts->locale.m_keyboardLayout != locale.m_keyboardLayout)
+            p_dicts->setKeyboardLayout(locale.m_keyboardLayout);
+
+        p_dicts->locale = locale;
+        p_dicts->loadMs = 0;
+
+        swapLocale(p_dicts, eAction);
+        return;
+    }
+
+    g_debug("%s: loading dictionaries of '%s'", __FUNCTION__, locale.getFullLocale().c_str());
+
+    m_localeLoad = new SmkyLocaleDictionaries(locale);
+    m_localeLoadAction = eAction;
+    m_localeLoadThread = g_thread_new("smartkey-locale", localeLoadThread, this);
+}
+
+/**
+* replace dictionaries of the engine with loaded ones while requests are blocked, then notify
+* clients about the change. Previous dictionaries are kept in the pool for a switch back.
+*
+* @param p_dicts
+*   loaded dictionaries, ownership is taken
+*
+* @param eAction
+*   what was changed (sent by languageChanged signal)
+*/
+void SmartKeyService::swapLocale (SmkyLocaleDictionaries* p_dicts, LanguageAction eAction)
+{
+    double start = getTime();
+    {
+        //locale settings are changed, wait for requests running in worker threads
+        SmkyEngineWriteLock lock(m_engine);
+
+        //queued changes belong to the current locale
+        runPendingWrites();
+
+        //paths of dictionaries depend on locale, pending changes belong to the current one
+        flushDictionaries();
+
+        LocaleSettings previous = Settings::getInstance()->localeSettings;
+        Settings::getInstance()->localeSettings = p_dicts->locale;
+
+        if (m_engine->swapLocale(*p_dicts))
+            p_dicts->locale = previous;
+    }
+    g_debug("%s: requests were blocked for %g msec", __FUNCTION__, (getTime()-start) * 1000.0);
+
+    //previous dictionaries are released (if pool is full) without blocking requests
+    m_localePool.put(p_dicts);
+
+    notifyLanguageChanged(eAction);
+}
+
+/**
+* stop loading dictionaries of the locale: wait for the loading thread, loaded dictionaries are dropped
+*/
+void SmartKeyService::cancelLocaleLoad (void)
+{
+    if (m_localeLoadThread)
+    {
+        g_thread_join(m_localeLoadThread);
+        m_localeLoadThread = NULL;
+    }
+
+    if (m_localeLoadDone)
+    {
+        g_source_remove(m_localeLoadDone);
+        m_localeLoadDone = 0;
+    }
+
+    delete m_localeLoad;
+    m_localeLoad = NULL;
+    m_pendingAction = LanguageActionNone;
+}
+
+/**
+* load dictionaries of the locale, then let the main loop swap them in
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return gpointer
+*   NULL
+*/
+gpointer SmartKeyService::localeLoadThread (gpointer ctx)
+{
+    SmartKeyService* service = static_cast<SmartKeyService*>(ctx);
+
+    SmkySpellCheckEngine::loadLocale(*service->m_localeLoad);
+
+    service->m_localeLoadDone = g_idle_add(localeLoadDoneCallback, service);
+
+    return NULL;
+}
+
+/**
+* swap loaded dictionaries in while requests are blocked, then notify clients about the change,
+* dictionaries are kept in the pool if another locale was requested meanwhile
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return gboolean
+*   FALSE, callback is not repeated
+*/
+gboolean SmartKeyService::localeLoadDoneCallback (gpointer ctx)
+{
+    SmartKeyService* service = static_cast<SmartKeyService*>(ctx);
+
+    //thread has set m_localeLoadDone before it finished
+    g_thread_join(service->m_localeLoadThread);
+    service->m_localeLoadThread = NULL;
+    service->m_localeLoadDone = 0;
+
+    SmkyLocaleDictionaries* p_dicts = service->m_localeLoad;
+    LanguageAction action = service->m_localeLoadAction;
+    service->m_localeLoad = NULL;
+
+    if (service->m_pendingAction != LanguageActionNone)
+    {
+        LanguageAction pending = std::max(service->m_pendingAction, action);
+        service->m_pendingAction = LanguageActionNone;
+
+        //loaded dictionaries may be needed soon
+        service->m_localePool.put(p_dicts);
+        service->loadLocale(service->m_pendingLocale, pending);
+
+        return FALSE;
+    }
+
+    service->swapLocale(p_dicts, action);
+
+    return FALSE;
+}
+
 /*! \page  com_palm_smartKey_service
 \n
 \section  com_palm_smartKey_addUserWord addUserWord
@@ -1433,7 +2640,27 @@ luna-send -n 1 -f palm://com.palm.smartKey/learn '{"word": "Oulu"}'
 }
 \endcode
 */
-bool SmartKeyService::cmdAddUserWord(LSHandle* sh, LSMessage* message, void* ctx)
+bool SmartKeyService::cmdAddUserWord(LSHandle* sh, LSMessage* message, void* ctx)
+{
+    return(dispatchWrite(doAddUserWord, sh, message, ctx));
+}
+
+/**
+* add user word, runs while requests are blocked (see dispatchWrite)
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   see cmdAddUserWord
+*/
+bool SmartKeyService::doAddUserWord(LSHandle* sh, LSMessage* message, void* ctx)
 {
     if (!message)
         return true;
@@ -1482,7 +2709,7 @@ bool SmartKeyService::cmdAddUserWord(LSHandle* sh, LSMessage* message, void* ctx
 
     if (err == SKERR_SUCCESS)
     {
-        service->m_engine->getUserDatabase()->save();
+        service->scheduleSave();
     }
 
     json_object* replyJson = json_object_new_object();
@@ -1792,6 +3019,26 @@ luna-send -n 1 -f palm://com.palm.smartKey/addAutoReplace '{ "shortcut":"OuluU",
 \endcode
 */
 bool SmartKeyService::cmdAddAutoReplace(LSHandle* sh, LSMessage* message, void* ctx)
+{
+    return(dispatchWrite(doAddAutoReplace, sh, message, ctx));
+}
+
+/**
+* add auto replace entry, runs while requests are blocked (see dispatchWrite)
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   see cmdAddAutoReplace
+*/
+bool SmartKeyService::doAddAutoReplace(LSHandle* sh, LSMessage* message, void* ctx)
 {
     if (!message)
         return true;
@@ -1832,7 +3079,7 @@ bool SmartKeyService::cmdAddAutoReplace(LSHandle* sh, LSMessage* message, void*
                 if (isGoodWord(entry.shortcut) && isGoodWord(entry.substitution))
                 {
                     err = autosubdatabase->addEntry(entry);
-                    autosubdatabase->save();
+                    service->scheduleSave();
                 }
                 else
                 {
@@ -1912,6 +3159,26 @@ luna-send -n 1 -f palm://com.palm.smartKey/removeAutoReplace '{"shortcut": "Oulu
 \endcode
 */
 bool SmartKeyService::cmdRemoveAutoReplace(LSHandle* sh, LSMessage* message, void* ctx)
+{
+    return(dispatchWrite(doRemoveAutoReplace, sh, message, ctx));
+}
+
+/**
+* remove auto replace entry, runs while requests are blocked (see dispatchWrite)
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   see cmdRemoveAutoReplace
+*/
+bool SmartKeyService::doRemoveAutoReplace(LSHandle* sh, LSMessage* message, void* ctx)
 {
     if (!message)
         return true;
@@ -1945,7 +3212,7 @@ bool SmartKeyService::cmdRemoveAutoReplace(LSHandle* sh, LSMessage* message, voi
 
             if(autosubdatabase->forgetWord(shortcut))
             {
-                autosubdatabase->save();
+                service->scheduleSave();
                 err = SKERR_SUCCESS;
             }
             else
@@ -2287,6 +3554,26 @@ luna-send -n 1 -f palm://com.palm.smartKey/addPerson '[{"familyName":"Sun","give
 */
 //{Igor: relinked to user database, GF-1374}
 bool SmartKeyService::cmdAddPerson(LSHandle* sh, LSMessage* message, void* ctx)
+{
+    return(dispatchWrite(doAddPerson, sh, message, ctx));
+}
+
+/**
+* add person, runs while requests are blocked (see dispatchWrite)
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   see cmdAddPerson
+*/
+bool SmartKeyService::doAddPerson(LSHandle* sh, LSMessage* message, void* ctx)
 {
     if (!message)
         return true;
@@ -2405,6 +3692,26 @@ luna-send -n 1 -f palm://com.palm.smartKey/removePerson '[{"familyName":"Sun", "
 */
 //{Igor: relinked to user database, GF-1374}
 bool SmartKeyService::cmdRemovePerson(LSHandle* sh, LSMessage* message, void* ctx)
+{
+    return(dispatchWrite(doRemovePerson, sh, message, ctx));
+}
+
+/**
+* remove person, runs while requests are blocked (see dispatchWrite)
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   see cmdRemovePerson
+*/
+bool SmartKeyService::doRemovePerson(LSHandle* sh, LSMessage* message, void* ctx)
 {
     if (!message)
         return true;
@@ -2454,7 +3761,7 @@ bool SmartKeyService::cmdRemovePerson(LSHandle* sh, LSMessage* message, void* ct
 
     if (allNames.size())
     {
-        db->save();
+        service->scheduleSave();
     }
 
     json_object* replyJson = json_object_new_object();
@@ -2533,6 +3840,26 @@ luna-send -n 1 -f palm://com.palm.smartKey/forget '{ "word": "oulu"}'
 \endcode
 */
 bool SmartKeyService::cmdRemoveUserWord(LSHandle* sh, LSMessage* message, void* ctx)
+{
+    return(dispatchWrite(doRemoveUserWord, sh, message, ctx));
+}
+
+/**
+* remove user word, runs while requests are blocked (see dispatchWrite)
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   see cmdRemoveUserWord
+*/
+bool SmartKeyService::doRemoveUserWord(LSHandle* sh, LSMessage* message, void* ctx)
 {
     if (!message)
         return true;
@@ -2563,7 +3890,7 @@ bool SmartKeyService::cmdRemoveUserWord(LSHandle* sh, LSMessage* message, void*
 
         if(service->m_engine->getUserDatabase()->forgetWord(word))
         {
-            service->m_engine->getUserDatabase()->save();
+            service->scheduleSave();
             err = SKERR_SUCCESS;
         }
         else
@@ -2783,6 +4110,66 @@ bool SmartKeyService::carrierDbWatchCallback (LSHandle *sh, LSMessage *message,
     return true;
 }
 
+/**
+* save changed user, context and auto-replace dictionaries later: every save rewrites the whole file,
+* so changes made within 'saveDelayMs' are written at once
+*/
+void SmartKeyService::scheduleSave (void)
+{
+    int delayMs = Settings::getInstance()->saveDelayMs;
+
+    if (delayMs <= 0)
+    {
+        flushDictionaries();
+    }
+    else if (m_saveTimer == 0)
+    {
+        m_saveTimer = g_timeout_add(delayMs, saveTimerCallback, this);
+    }
+}
+
+/**
+* save changed dictionaries now (unchanged ones are not written)
+*/
+void SmartKeyService::flushDictionaries (void)
+{
+    if (m_saveTimer)
+    {
+        g_source_remove(m_saveTimer);
+        m_saveTimer = 0;
+    }
+
+    if (m_engine)
+    {
+        double start = getTime();
+
+        m_engine->getUserDatabase()->save();
+        m_engine->getAutoSubDatabase()->save();
+        m_engine->getManufacturerDatabase()->save();
+
+        g_debug("%s: %g msec", __FUNCTION__, (getTime()-start) * 1000.0);
+    }
+}
+
+/**
+* save timer callback
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return gboolean
+*   FALSE, timer is not repeated
+*/
+gboolean SmartKeyService::saveTimerCallback (gpointer ctx)
+{
+    SmartKeyService* service = static_cast<SmartKeyService*>(ctx);
+
+    service->m_saveTimer = 0;
+    service->flushDictionaries();
+
+    return FALSE;
+}
+
 /**
 * cancel carrier db settings watch
 *
@@ -2974,9 +4361,11 @@ bool SmartKeyService::queryPreferencesCallback (LSHandle *sh, LSMessage *message
         return false;
     }
 
-    Settings* p_settings = Settings::getInstance();
     SmartKeyService* service = static_cast<SmartKeyService*>(ctx);
 
+    //changes are applied to the latest requested locale, it becomes current when its dictionaries are loaded
+    LocaleSettings locale = service->getRequestedLocale();
+
     LSError error;
     LSErrorInit(&error);
 
@@ -2993,22 +4382,22 @@ bool SmartKeyService::queryPreferencesCallback (LSHandle *sh, LSMessage *message
         str = json_object_get_string(label);
         if (str)
         {
-            p_settings->localeSettings.m_keyboardLayout = str;
-            p_settings->localeSettings.m_hasVirtualKeyboard = true;
+            locale.m_keyboardLayout = str;
+            locale.m_hasVirtualKeyboard = true;
         }
 
         label = json_object_object_get(payload, "language");
         str = json_object_get_string(label);
         if (str)
         {
-            p_settings->localeSettings.m_inputLanguage = str;
+            locale.m_inputLanguage = str;
         }
 
         json_object_put(payload);
 
         languageAction = LanguageActionKeyboardChanged;
 
-        g_debug("Virtual keyboard layout: '%s', auto-correction: '%s'.", p_settings->localeSettings.m_keyboardLayout.c_str(), p_settings->localeSettings.m_inputLanguage.c_str());
+        g_debug("Virtual keyboard layout: '%s', auto-correction: '%s'.", locale.m_keyboardLayout.c_str(), locale.m_inputLanguage.c_str());
     }
 
     json_object* localeValue = json_object_object_get(json, "locale");
@@ -3017,21 +4406,20 @@ bool SmartKeyService::queryPreferencesCallback (LSHandle *sh, LSMessage *message
 
         json_object* label = json_object_object_get(localeValue, "languageCode");
         if (ValidJsonObject(label))
-            p_settings->localeSettings.m_deviceLanguage = json_object_get_string(label);
+            locale.m_deviceLanguage = json_object_get_string(label);
 
         label = json_object_object_get(localeValue, "countryCode");
         if (ValidJsonObject(label))
-            p_settings->localeSettings.m_deviceCountry = json_object_get_string(label);
+            locale.m_deviceCountry = json_object_get_string(label);
 
         languageAction = LanguageActionLocaleChanged;
     }
 
     if (languageAction != LanguageActionNone)
     {
-        g_debug("SmartKeyService::queryPreferencesCallback: Locale settings: %s", p_settings->localeSettings.getFullLocale().c_str());
+        g_debug("SmartKeyService::queryPreferencesCallback: Locale settings: %s", locale.getFullLocale().c_str());
 
         // adjust locale settings for various fallback behaviors...
-        LocaleSettings& locale = p_settings->localeSettings;
 
         if (locale.m_deviceLanguage.size() != 2)
         {
@@ -3049,8 +4437,9 @@ bool SmartKeyService::queryPreferencesCallback (LSHandle *sh, LSMessage *message
         if (locale.m_keyboardLayout.size() == 0)
             locale.m_keyboardLayout = "qwerty";
 
-        service->m_engine->changedLocaleSettings();
-        service->notifyLanguageChanged(languageAction);
+        //current dictionaries keep serving requests while the new ones are loaded,
+        //languageChanged is sent when they are swapped in
+        service->loadLocale(locale, languageAction);
     }
 
     json_object* textInput = json_object_object_get(json, "x_palm_textinput");
@@ -3351,6 +4740,26 @@ bool SmartKeyService::parseName (json_object* objName, Name& name )
 *   return always true
 */
 bool SmartKeyService::queryPersonsCallback (LSHandle *sh, LSMessage *message, void *ctx)
+{
+    return(dispatchWrite(doQueryPersons, sh, message, ctx));
+}
+
+/**
+* add persons found by query, runs while requests are blocked (see dispatchWrite)
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   see queryPersonsCallback
+*/
+bool SmartKeyService::doQueryPersons (LSHandle *sh, LSMessage *message, void *ctx)
 {
     if (!message)
         return true;
@@ -3445,6 +4854,26 @@ bool SmartKeyService::queryPersonsCallback (LSHandle *sh, LSMessage *message, vo
 *   return always true
 */
 bool SmartKeyService::queryCountPersonCallback (LSHandle *sh, LSMessage *message, void *ctx)
+{
+    return(dispatchWrite(doQueryCountPerson, sh, message, ctx));
+}
+
+/**
+* handle count of persons, runs while requests are blocked (see dispatchWrite)
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   see queryCountPersonCallback
+*/
+bool SmartKeyService::doQueryCountPerson (LSHandle *sh, LSMessage *message, void *ctx)
 {
     if (!message)
         return true;
@@ -3556,6 +4985,26 @@ luna-send -n 1 -f palm://com.palm.smartKey/processTaps '{ "taps":[100,630,0,1,33
 \endcode
 */
 bool SmartKeyService::cmdProcessTaps(LSHandle* sh, LSMessage* message, void* ctx)
+{
+    return(dispatchRequest(doProcessTaps, sh, message, ctx));
+}
+
+/**
+* process taps, runs in worker thread (or on main loop if there are no worker threads)
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   false if payload is not valid
+*/
+bool SmartKeyService::doProcessTaps (LSHandle* sh, LSMessage* message, void* ctx)
 {
     double start = getTime();
 
@@ -3566,6 +5015,7 @@ bool SmartKeyService::cmdProcessTaps(LSHandle* sh, LSMessage* message, void* ctx
     //g_debug("%s: received '%s'", __FUNCTION__, payload);
 
     SmartKeyService* service = static_cast<SmartKeyService*>(ctx);
+    SmkyEngineReadLock lock(service->m_engine);
     SmartKeyErrorCode err = SKERR_SUCCESS;
 
     json_object* json = json_tokener_parse(payload);
@@ -3728,22 +5178,26 @@ com_palm_smartKey_service/getCompletion
 \code
 {
     "prefix": string
+    "max": int
 }
 
 \endcode
 \param prefix The prefix to try to complete Required
+\param max Maximum number of completions in 'completions', by default is 1, up to 20. Can be ommited.
 
 \subsection com_palm_smartKey_service_reply Reply:
 \code
 {
     "com": string
+    "completions": array
     "exact": boolean
     "returnValue": boolean
     "errorCode": int
     "errorText": string
 }
 \endcode
-\param com The completed word based on the prefix. Required
+\param com The completed word based on the prefix (the best one). Required
+\param completions Completions ranked by dictionary (auto replace, user, manufacturer, locale) and word frequency, the best first. Required
 \param exact true if com is empty
 \param returnValue true (success) or false (failure). Required
 \param errorCode the error code of error if there is error. Optional
@@ -3754,12 +5208,41 @@ com_palm_smartKey_service/getCompletion
 luna-send -n 1 -f palm://com.palm.smartKey/getCompletion '{"prefix":"pre"}'
 {
     "comp": "",
+    "completions": [ ],
     "exact": true,
     "returnValue": true
 }
+
+luna-send -n 1 -f palm://com.palm.smartKey/getCompletion '{"prefix":"th","max":3}'
+{
+    "comp": "the",
+    "completions": [ "the", "that", "this" ],
+    "exact": false,
+    "returnValue": true
+}
 \endcode
 */
 bool SmartKeyService::cmdGetCompletion(LSHandle* sh, LSMessage* message, void* ctx)
+{
+    return(dispatchRequest(doGetCompletion, sh, message, ctx));
+}
+
+/**
+* get completions, runs in worker thread (or on main loop if there are no worker threads)
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   false if payload is not valid
+*/
+bool SmartKeyService::doGetCompletion (LSHandle* sh, LSMessage* message, void* ctx)
 {
     double start = getTime();
 
@@ -3770,6 +5253,7 @@ bool SmartKeyService::cmdGetCompletion(LSHandle* sh, LSMessage* message, void* c
     g_debug("%s: received '%s'", __FUNCTION__, payload);
 
     SmartKeyService* service = static_cast<SmartKeyService*>(ctx);
+    SmkyEngineReadLock lock(service->m_engine);
     SmartKeyErrorCode err = SKERR_SUCCESS;
 
     json_object* json = json_tokener_parse(payload);
@@ -3781,19 +5265,35 @@ bool SmartKeyService::cmdGetCompletion(LSHandle* sh, LSMessage* message, void* c
     if (service->isEnabled())
     {
 
-        std::string prefix, result;
+        std::string prefix;
+        std::vector<std::string> results;
         json_object* prop = json_object_object_get(json, "prefix");
         if (prop && json_object_is_type(prop, json_type_string))
         {
             prefix = json_object_get_string(prop);
         }
 
-        err = service->m_engine->getCompletion(prefix, result);
+        int maxResults = 1;
+        json_object* limitValue = json_object_object_get(json, "max");
+        if (ValidJsonObject(limitValue))
+        {
+            maxResults = std::min(json_object_get_int(limitValue), SMK_MAX_COMPLETIONS);
+        }
+
+        err = maxResults > 0 ? service->m_engine->getCompletions(prefix, maxResults, results) : SKERR_BAD_PARAM;
 
         if (err == SKERR_SUCCESS)
         {
+            std::string result = results.empty() ? "" : results[0];
+            json_object* completionsJson = json_object_new_array();
+
+            for (size_t i = 0; i < results.size(); ++i)
+            {
+                json_object_array_add( completionsJson, json_object_new_string(results[i].c_str()) );
+            }
 
             json_object_object_add(replyJson, "comp", json_object_new_string(result.c_str()));
+            json_object_object_add(replyJson, "completions", completionsJson);
             json_object_object_add(replyJson, "exact", json_object_new_boolean(result.empty()));
         }
     }
@@ -3858,6 +5358,26 @@ luna-send -n 1 -f palm://com.palm.smartKey/updateWordUsage '{"word":"oulu"}'
 \endcode
 */
 bool SmartKeyService::cmdUpdateWordUsage(LSHandle* sh, LSMessage* message, void* ctx)
+{
+    return(dispatchWrite(doUpdateWordUsage, sh, message, ctx));
+}
+
+/**
+* update word usage, runs while requests are blocked (see dispatchWrite)
+*
+* @param sh
+*   luna handle
+*
+* @param message
+*   request message
+*
+* @param ctx
+*   SmartKeyService
+*
+* @return bool
+*   see cmdUpdateWordUsage
+*/
+bool SmartKeyService::doUpdateWordUsage(LSHandle* sh, LSMessage* message, void* ctx)
 {
     double start = getTime();
 
@@ -3911,6 +5431,148 @@ bool SmartKeyService::cmdUpdateWordUsage(LSHandle* sh, LSMessage* message, void*
     return true;
 }
 
+/*! \page  com_palm_smartKey_service
+\n
+\section  com_palm_smartKey_getStats getStats
+
+com_palm_smartKey_service/getStats
+
+Get memory usage and load time of every dictionary and cache, resident memory of the service
+and duration of the last locale change. Byte counts are approximate: keys and values are strings
+copied into memory, overhead is hash tables, indexes, images built in memory and unused storage,
+mapped is memory mapped compiled files. Hunspell doesn't report its memory, it is estimated by
+size of its .aff and .dic files and reported as overhead, every worker thread has its own copy of it.
+Byte counts are 64 bit integers.
+
+\subsection com_palm_smartKey_service_syntax Syntax:
+\code
+{
+}
+\endcode
+
+\subsection com_palm_smartKey_service_reply Reply:
+\code
+{
+    "dictionaries": [
+        {
+            "name": string
+            "entries": int
+            "keyBytes": int
+            "valueBytes": int
+            "overheadBytes": int
+            "mappedBytes": int
+            "loadMs": double
+        }
+    ]
+    "hunspellCopies": int
+    "residentBytes": int
+    "localeSwitchMs": double
+    "pooledLocales": int
+    "pooledBytes": int
+    "returnValue": boolean
+    "errorCode": int
+    "errorText": string
+}
+\endcode
+\param dictionaries statistics of dictionaries and caches. Required
+\param hunspellCopies number of hunspell dictionaries loaded for worker threads. Required
+\param residentBytes resident memory of the service process. Required
+\param localeSwitchMs duration of the last locale change (0 if dictionaries were kept in memory). Required
+\param pooledLocales number of recently used locales whose dictionaries are kept in memory. Required
+\param pooledBytes estimated memory of dictionaries of recently used locales. Required
+\param returnValue true (success) or false (failure). Required
+\param errorCode the error code of error if there is error. Optional
+\param errorText the error text of error if there is error. Optional
+
+\subsection com_palm_smartKey_service_examples Examples:
+\code
+luna-send -n 1 -f palm://com.palm.smartKey/getStats '{}'
+{
+    "dictionaries": [
+        { "name": "user", "entries": 2, "keyBytes": 11, "valueBytes": 0, "overheadBytes": 65632, "mappedBytes": 0, "loadMs": 0.21 },
+        { "name": "hunspell", "entries": 62156, "keyBytes": 0, "valueBytes": 0, "overheadBytes": 748823, "mappedBytes": 0, "loadMs": 182.4 },
+        ...
+    ],
+    "hunspellCopies": 1,
+    "residentBytes": 21483520,
+    "localeSwitchMs": 214.7,
+    "pooledLocales": 1,
+    "pooledBytes": 1826304,
+    "returnValue": true
+}
+\endcode
+*/
+bool SmartKeyService::cmdGetStats(LSHandle* sh, LSMessage* message, void* ctx)
+{
+    if (!message)
+        return true;
+
+    const char* payload = LSMessageGetPayload(message);
+
+    SmartKeyService* service = static_cast<SmartKeyService*>(ctx);
+
+    if (!service || !service->isEnabled())
+    {
+        g_message("%s: service is not enabled", __FUNCTION__);
+        return true;
+    }
+
+    json_object* json = json_tokener_parse(payload);
+    if (!ValidJsonObject(json))
+    {
+        return false;
+    }
+
+    std::vector<DictionaryStats> stats;
+    {
+        SmkyEngineReadLock lock(service->m_engine);
+        service->m_engine->getStats(stats);
+    }
+
+    DictionaryStats documents;
+    documents.name = "document-cache";
+    service->m_documents.getStats(documents);
+    stats.push_back(documents);
+
+    json_object* replyJson = json_object_new_object();
+
+    setReplyResponse(replyJson, SKERR_SUCCESS);
+
+    json_object* dictionaries = json_object_new_array();
+    for (std::vector<DictionaryStats>::const_iterator it = stats.begin(); it != stats.end(); ++it)
+    {
+        json_object* item = json_object_new_object();
+        json_object_object_add(item, "name", json_object_new_string(it->name.c_str()));
+        json_object_object_add(item, "entries", json_object_new_int(it->entries));
+        json_object_object_add(item, "keyBytes", json_object_new_int64(it->keyBytes));
+        json_object_object_add(item, "valueBytes", json_object_new_int64(it->valueBytes));
+        json_object_object_add(item, "overheadBytes", json_object_new_int64(it->overheadBytes));
+        json_object_object_add(item, "mappedBytes", json_object_new_int64(it->mappedBytes));
+        json_object_object_add(item, "loadMs", json_object_new_double(it->loadMs));
+        json_object_array_add(dictionaries, item);
+    }
+    json_object_object_add(replyJson, "dictionaries", dictionaries);
+
+    json_object_object_add(replyJson, "hunspellCopies", json_object_new_int(service->m_engine->getWorkerDictionaries()));
+    json_object_object_add(replyJson, "residentBytes", json_object_new_int64(getResidentMemory()));
+    json_object_object_add(replyJson, "localeSwitchMs", json_object_new_double(service->m_engine->getLocaleSwitchMs()));
+    json_object_object_add(replyJson, "pooledLocales", json_object_new_int(service->m_localePool.size()));
+    json_object_object_add(replyJson, "pooledBytes", json_object_new_int64(service->m_localePool.memoryUsed()));
+
+    LSError lserror;
+    LSErrorInit(&lserror);
+
+    if (!LSMessageReply(sh, message, json_object_to_json_string(replyJson), &lserror))
+    {
+        LSErrorPrint(&lserror, stderr);
+        LSErrorFree(&lserror);
+    }
+    json_object_put(replyJson);
+    json_object_put(json);
+
+    return true;
+}
+
 /**
 * query persons
 *
@@ -4003,6 +5665,29 @@ double SmartKeyService::getTime (void)
            static_cast<double>(curTime.tv_nsec) / 1000000000.0f;
 }
 
+/**
+* get resident memory of the process
+*
+* @return size_t
+*   bytes, 0 if it is not known
+*/
+size_t SmartKeyService::getResidentMemory (void)
+{
+    size_t pages = 0;
+    size_t resident = 0;
+
+    FILE* p_file = fopen("/proc/self/statm", "r");
+    if (p_file)
+    {
+        if (fscanf(p_file, "%zu %zu", &pages, &resident) != 2)
+            resident = 0;
+
+        fclose(p_file);
+    }
+
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
 }
 
 
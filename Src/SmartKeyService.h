@@ -28,15 +28,25 @@
 
 #include "lunaservice.h"
 
+#include <deque>
 #include <string>
 #include <vector>
 
 #include "Settings.h"
+#include "SmkyDocumentCache.h"
+#include "SmkyLocalePool.h"
+#include "SmkyRequestPool.h"
+#include "SmkyRequestSessions.h"
 #include "SmkySpellCheckEngine.h"
 #include "StringUtils.h"
 
 #define SMK_MIN_GUESSES 10
 #define SMK_MAX_GUESSES 60
+#define SMK_MAX_COMPLETIONS 20
+#define SMK_MAX_BATCH_WORDS 200
+#define SMK_MAX_TEXT_LENGTH 65536
+#define SMK_WRITE_RETRY_MS 10
+#define SMK_MAX_WRITE_DELAY_MS 1000
 
 namespace SmartKey
 {
@@ -48,8 +58,12 @@ class SmartKeyService
 private:
     LSHandle* m_service;
     LSMessageToken m_carrierDbWatchToken;
+    guint m_saveTimer; ///< Pending save of changed dictionaries
     GMainLoop* m_mainLoop;
     SmkySpellCheckEngine* m_engine;
+    SmkyRequestPool m_requestPool; ///< Threads serving spell check requests
+    SmkyRequestSessions m_sessions; ///< Latest search request of every client session
+    SmkyDocumentCache m_documents; ///< Results of checkText per document
     bool m_isEnabled;
     bool m_readPeople; ///< Have all people (AKA contacts) been read yet?
     std::string m_currTextInputPrefs;
@@ -61,6 +75,12 @@ public:
     //search
     static bool cmdSearch(LSHandle* sh, LSMessage* message, void* ctx);
 
+    //search many words at once
+    static bool cmdSearchBatch(LSHandle* sh, LSMessage* message, void* ctx);
+
+    //find misspelled words in the text
+    static bool cmdCheckText(LSHandle* sh, LSMessage* message, void* ctx);
+
     //add a new word to user dictionary
     static bool cmdAddUserWord(LSHandle* sh, LSMessage* message, void* ctx);
 
@@ -103,6 +123,9 @@ public:
     // -- not used
     static bool cmdUpdateWordUsage(LSHandle* sh, LSMessage* message, void* ctx);
 
+    //get memory usage and load time of dictionaries
+    static bool cmdGetStats(LSHandle* sh, LSMessage* message, void* ctx);
+
     //start service
     bool start(GMainLoop* mainLoop, const char* name);
 
@@ -139,6 +162,9 @@ public:
     // --
     static double getTime(void);
 
+    //resident memory of the process (bytes)
+    static size_t getResidentMemory(void);
+
     // --
     static bool copyFileFromDirToDir(const std::string& fname, const std::string& srcDir, const std::string& dstDir);
 
@@ -157,6 +183,33 @@ private:
         LanguageActionLocaleChanged
     };
 
+    SmkyLocaleDictionaries* m_localeLoad; ///< Dictionaries of the locale being loaded in background
+    GThread* m_localeLoadThread;
+    guint m_localeLoadDone; ///< Idle source swapping loaded dictionaries in
+    LanguageAction m_localeLoadAction;
+    LocaleSettings m_pendingLocale; ///< Locale requested while another one was being loaded
+    LanguageAction m_pendingAction; ///< LanguageActionNone if there is no pending locale
+    SmkyLocalePool m_localePool; ///< Dictionaries of recently used locales
+
+    struct PendingWrite
+    {
+        SmkyRequestPool::Handler handler;
+        LSHandle* sh;
+        LSMessage* message; ///< referenced while queued
+    };
+
+    std::deque<PendingWrite> m_pendingWrites; ///< Dictionary changes waiting for running requests
+    guint m_pendingWritesSource; ///< Timeout source retrying pending dictionary changes
+    gint64 m_pendingWritesSince; ///< Monotonic time (us) the oldest pending change was queued
+
+    struct TextToken
+    {
+        size_t start;   ///< position in the text (bytes)
+        size_t length;  ///< length (bytes)
+        glong  offset;  ///< position in the text (characters)
+        glong  chars;   ///< length (characters)
+    };
+
     struct Name
     {
 
@@ -194,9 +247,36 @@ private:
     //notify language changed
     bool notifyLanguageChanged (LanguageAction eAction);
 
+    //get the latest requested locale (pending, being loaded or current one)
+    const LocaleSettings& getRequestedLocale (void) const;
+
+    //load dictionaries of the locale in background, they replace the current ones when loaded
+    void loadLocale (const LocaleSettings& locale, LanguageAction eAction);
+
+    //replace dictionaries of the engine with loaded ones and notify clients, previous ones are kept in the pool
+    void swapLocale (SmkyLocaleDictionaries* p_dicts, LanguageAction eAction);
+
+    //stop loading dictionaries of the locale
+    void cancelLocaleLoad (void);
+
+    //load dictionaries of the locale (background thread)
+    static gpointer localeLoadThread (gpointer ctx);
+
+    //swap loaded dictionaries in (main loop)
+    static gboolean localeLoadDoneCallback (gpointer ctx);
+
     //disable spelling auto correction
     void disableSpellingAutoCorrection (void);
 
+    //save changed dictionaries later, on the main loop
+    void scheduleSave (void);
+
+    //save changed dictionaries now
+    void flushDictionaries (void);
+
+    //save timer callback
+    static gboolean saveTimerCallback (gpointer ctx);
+
     //query carrier db settings
     bool queryCarrierDbSettings (void);
 
@@ -209,6 +289,48 @@ private:
     //copy file
     static bool copyFile (const std::string& src, const std::string& dst);
 
+    //queue request to worker threads or process it right away
+    static bool dispatchRequest (SmkyRequestPool::Handler handler, LSHandle* sh, LSMessage* message, void* ctx);
+
+    //change dictionaries now if no request is running, queue the change otherwise
+    static bool dispatchWrite (SmkyRequestPool::Handler handler, LSHandle* sh, LSMessage* message, void* ctx);
+
+    //retry queued dictionary changes
+    static gboolean pendingWritesCallback (gpointer ctx);
+
+    //apply queued dictionary changes (engine is locked exclusively)
+    void runPendingWrites (void);
+
+    //get optional session id and sequence number of request
+    static bool getRequestSeq (struct json_object* json, std::string& session, int& seq);
+
+    //search (worker thread)
+    static bool doSearch (LSHandle* sh, LSMessage* message, void* ctx);
+
+    //search many words (worker thread)
+    static bool doSearchBatch (LSHandle* sh, LSMessage* message, void* ctx);
+
+    //spell check single word of search request
+    SmartKeyErrorCode searchWord (const std::string& query, const std::string& context, bool useAutoCorrect, int maxGuesses, int budgetMs, const SmkyRequestTicket& ticket, SpellCheckWordInfo& result);
+
+    //time budget of a word of searchBatch or checkText request
+    static int getBatchWordBudgetMs (int budgetMs, const SmkyDeadline& batchDeadline);
+
+    //add search result to reply
+    static void addSearchResult (struct json_object* replyJson, const SpellCheckWordInfo& result);
+
+    //find misspelled words (worker thread)
+    static bool doCheckText (LSHandle* sh, LSMessage* message, void* ctx);
+
+    //split text into words
+    static void tokenizeText (const std::string& text, std::vector<TextToken>& tokens);
+
+    //taps (worker thread)
+    static bool doProcessTaps (LSHandle* sh, LSMessage* message, void* ctx);
+
+    //get completion (worker thread)
+    static bool doGetCompletion (LSHandle* sh, LSMessage* message, void* ctx);
+
     //system service status callback
     static bool systemServiceStatusCallback (LSHandle *sh, LSMessage *message, void *ctx);
 
@@ -230,6 +352,17 @@ private:
     //query count person callback
     static bool queryCountPersonCallback (LSHandle *sh, LSMessage *message, void *ctx);
 
+    //dictionary changes (engine is locked exclusively, see dispatchWrite)
+    static bool doAddUserWord (LSHandle* sh, LSMessage* message, void* ctx);
+    static bool doRemoveUserWord (LSHandle* sh, LSMessage* message, void* ctx);
+    static bool doAddAutoReplace (LSHandle* sh, LSMessage* message, void* ctx);
+    static bool doRemoveAutoReplace (LSHandle* sh, LSMessage* message, void* ctx);
+    static bool doAddPerson (LSHandle* sh, LSMessage* message, void* ctx);
+    static bool doRemovePerson (LSHandle* sh, LSMessage* message, void* ctx);
+    static bool doUpdateWordUsage (LSHandle* sh, LSMessage* message, void* ctx);
+    static bool doQueryPersons (LSHandle *sh, LSMessage *message, void *ctx);
+    static bool doQueryCountPerson (LSHandle *sh, LSMessage *message, void *ctx);
+
     //set prefs callback
     static bool setPrefsCallback (LSHandle *sh, LSMessage *message, void *ctx);
 
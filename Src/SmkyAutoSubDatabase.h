@@ -78,6 +78,18 @@ public:
     //find word by prefix
     virtual std::string findWordByPrefix (const std::string& prefix);
 
+    //find up to max words by prefix, append them to o_words
+    virtual void findWordsByPrefix (const std::string& prefix, size_t max, std::list<std::string>& o_words);
+
+    //export pointers to shortcuts of all entries, they are valid until the database is changed
+    void exportShortcuts (std::vector<const char*>& o_shortcuts);
+
+    //append shortcuts added since the last call, return false if exported shortcuts became stale meanwhile
+    bool takeAddedShortcuts (std::vector<const char*>& o_shortcuts);
+
+    //append memory usage and load time of the dictionaries
+    void getStats (std::vector<DictionaryStats>& o_stats) const;
+
     //get ldb substitution
     std::string getLdbSubstitution (std::string& shortcut);
 
@@ -181,6 +193,75 @@ inline std::string SmkyAutoSubDatabase::findWordByPrefix (const std::string& pre
     return( m_autosub_hc_dictionary.find_by_prefix(prefix) );
 }
 
+/**
+* find words with prefix in auto substitution database (editable substitutions first, then hardcoded ones)
+*
+* @param prefix
+*   prefix to search
+*
+* @param max
+*   limit number of words
+*
+* @param o_words
+*   output: found words are appended
+*/
+inline void SmkyAutoSubDatabase::findWordsByPrefix (const std::string& prefix, size_t max, std::list<std::string>& o_words)
+{
+    size_t count = o_words.size();
+    m_autosub_dictionary.find_all_by_prefix(prefix, max, o_words);
+
+    count = o_words.size() - count;
+    if (count < max)
+        m_autosub_hc_dictionary.find_all_by_prefix(prefix, max - count, o_words);
+}
+
+/**
+* export shortcuts of editable and hardcoded entries
+*
+* @param o_shortcuts
+*   output: shortcuts are appended
+*/
+inline void SmkyAutoSubDatabase::exportShortcuts (std::vector<const char*>& o_shortcuts)
+{
+    m_autosub_dictionary.exportKeys(o_shortcuts);
+    m_autosub_hc_dictionary.exportKeys(o_shortcuts);
+}
+
+/**
+* append shortcuts added to editable and hardcoded entries since the last call
+*
+* @param o_shortcuts
+*   output: added shortcuts are appended
+*
+* @return bool
+*   false if shortcuts exported before are stale, all of them must be exported again
+*/
+inline bool SmkyAutoSubDatabase::takeAddedShortcuts (std::vector<const char*>& o_shortcuts)
+{
+    //both dictionaries forget their changes
+    bool valid = m_autosub_dictionary.takeAddedKeys(o_shortcuts);
+    return(m_autosub_hc_dictionary.takeAddedKeys(o_shortcuts) && valid);
+}
+
+/**
+* append memory usage and load time of editable and hardcoded dictionaries
+*
+* @param o_stats
+*   output: statistics are appended
+*/
+inline void SmkyAutoSubDatabase::getStats (std::vector<DictionaryStats>& o_stats) const
+{
+    DictionaryStats stats;
+
+    stats.name = "autoreplace";
+    m_autosub_dictionary.getStats(stats);
+    o_stats.push_back(stats);
+
+    stats.name = "autoreplace-hc";
+    m_autosub_hc_dictionary.getStats(stats);
+    o_stats.push_back(stats);
+}
+
 /**
 * add word
 *
@@ -0,0 +1,120 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "SmkyBloomFilter.h"
+
+using namespace SmartKey;
+
+/**
+* SmkyBloomFilter: empty filter contains nothing
+*/
+SmkyBloomFilter::SmkyBloomFilter (void)
+    : m_num_bits(0)
+{
+}
+
+/**
+* drop content and size the filter for expected number of keys
+*
+* @param i_expected_keys
+*   number of keys which will be added
+*/
+void SmkyBloomFilter::reset (size_t i_expected_keys)
+{
+    size_t words = (i_expected_keys * BITS_PER_KEY + 63) / 64;
+
+    if (words == 0)
+        words = 1;
+
+    m_bits.assign(words, 0);
+    m_num_bits = (uint32_t)(words * 64);
+}
+
+/**
+* FNV-1a hash of the key
+*
+* @param i_key
+*   key
+*
+* @param i_length
+*   length of the key
+*
+* @return uint64_t
+*   hash
+*/
+uint64_t SmkyBloomFilter::hash (const char* i_key, size_t i_length)
+{
+    uint64_t h = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < i_length; ++i)
+    {
+        h ^= (unsigned char)i_key[i];
+        h *= 1099511628211ULL;
+    }
+
+    return(h);
+}
+
+/**
+* set bits of the key
+*
+* @param i_hash
+*   hash of the key
+*/
+void SmkyBloomFilter::_add (uint64_t i_hash)
+{
+    if (m_num_bits == 0)
+        return;
+
+    uint32_t h1 = (uint32_t)i_hash;
+    uint32_t h2 = (uint32_t)(i_hash >> 32) | 1;
+
+    for (int i = 0; i < NUM_PROBES; ++i)
+    {
+        uint32_t bit = (h1 + i * h2) % m_num_bits;
+        m_bits[bit / 64] |= (uint64_t)1 << (bit % 64);
+    }
+}
+
+/**
+* test bits of the key
+*
+* @param i_hash
+*   hash of the key
+*
+* @return bool
+*   false if the key surely wasn't added
+*/
+bool SmkyBloomFilter::_mayContain (uint64_t i_hash) const
+{
+    if (m_num_bits == 0)
+        return(false);
+
+    uint32_t h1 = (uint32_t)i_hash;
+    uint32_t h2 = (uint32_t)(i_hash >> 32) | 1;
+
+    for (int i = 0; i < NUM_PROBES; ++i)
+    {
+        uint32_t bit = (h1 + i * h2) % m_num_bits;
+
+        if (!(m_bits[bit / 64] & ((uint64_t)1 << (bit % 64))))
+            return(false);
+    }
+
+    return(true);
+}
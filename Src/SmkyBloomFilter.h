@@ -0,0 +1,98 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SMKY_BLOOM_FILTER_H
+#define SMKY_BLOOM_FILTER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace SmartKey
+{
+
+/**
+ * Bloom filter over strings: answers "surely not present" or "maybe present".
+ * A single 64-bit hash of the string gives all probe positions (double hashing).
+ */
+class SmkyBloomFilter
+{
+private:
+    enum
+    {
+        BITS_PER_KEY = 10,  ///< ~1% false positives
+        NUM_PROBES = 7
+    };
+
+    std::vector<uint64_t> m_bits;
+    uint32_t m_num_bits;
+
+public:
+    SmkyBloomFilter (void);
+
+    //drop content and size filter for expected number of keys
+    void reset (size_t i_expected_keys);
+
+    //add key
+    void add (const std::string& i_key);
+    void add (const char* i_key, size_t i_length);
+
+    //is key possibly present ? false means it was never added
+    bool mayContain (const std::string& i_key) const;
+
+    //get hash of the key
+    static uint64_t hash (const char* i_key, size_t i_length);
+
+    //bytes allocated for the bits
+    size_t memoryUsed (void) const { return(m_bits.capacity() * sizeof(uint64_t)); }
+
+private:
+    //add key by hash
+    void _add (uint64_t i_hash);
+
+    //test key by hash
+    bool _mayContain (uint64_t i_hash) const;
+};
+
+/**
+* add key
+*/
+inline void SmkyBloomFilter::add (const std::string& i_key)
+{
+    _add(hash(i_key.data(), i_key.length()));
+}
+
+/**
+* add key
+*/
+inline void SmkyBloomFilter::add (const char* i_key, size_t i_length)
+{
+    _add(hash(i_key, i_length));
+}
+
+/**
+* is key possibly present ?
+*/
+inline bool SmkyBloomFilter::mayContain (const std::string& i_key) const
+{
+    return(_mayContain(hash(i_key.data(), i_key.length())));
+}
+
+}
+
+#endif
@@ -0,0 +1,824 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "SmkyCompiledDictionary.h"
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <algorithm>
+#include <fstream>
+#include <vector>
+#include <boost/tokenizer.hpp>
+
+using namespace SmartKey;
+using namespace std;
+
+typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
+
+static const char     k_magic[4] = { 'S', 'M', 'K', 'D' };
+static const uint32_t k_version = 2;
+static const char*    k_compiled_ext = ".bin";
+
+/**
+* compare compiled entries by key (strcmp order), used by std::lower_bound
+*/
+class SmkyCompiledKeyLess
+{
+public:
+    SmkyCompiledKeyLess (const char* ip_pool) : mp_pool(ip_pool) {}
+
+    bool operator()(uint32_t i_offset, const std::string& i_key) const
+    {
+        return (i_key.compare(mp_pool + i_offset) > 0);
+    }
+
+private:
+    const char* mp_pool;
+};
+
+/**
+* compare compiled entries by value (strcmp order), used by std::lower_bound
+*/
+class SmkyCompiledValueLess
+{
+public:
+    SmkyCompiledValueLess (const char* ip_pool, const uint32_t* ip_values) : mp_pool(ip_pool), mp_values(ip_values) {}
+
+    bool operator()(uint32_t i_index, const std::string& i_value) const
+    {
+        return (i_value.compare(mp_pool + mp_values[i_index]) > 0);
+    }
+
+private:
+    const char*     mp_pool;
+    const uint32_t* mp_values;
+};
+
+/**
+* entry of text dictionary
+*/
+struct SmkyCompiledEntry
+{
+    SmkyCompiledEntry (void) : frequency(0) {}
+
+    std::string key;
+    std::string value;
+    uint32_t    frequency;
+};
+
+/**
+* order entries by key only, so stable sort keeps the first occurrence of duplicated keys first
+*/
+static bool compare_entry_keys (const SmkyCompiledEntry& first, const SmkyCompiledEntry& second)
+{
+    return (first.key.compare(second.key) < 0);
+}
+
+/**
+* equality of entries by key only
+*/
+static bool equal_entry_keys (const SmkyCompiledEntry& first, const SmkyCompiledEntry& second)
+{
+    return (first.key == second.key);
+}
+
+/**
+* SmkyCompiledDictionary
+*/
+SmkyCompiledDictionary::SmkyCompiledDictionary (void)
+    : mp_map(NULL)
+    , m_map_size(0)
+    , mp_header(NULL)
+    , mp_keys(NULL)
+    , mp_values(NULL)
+    , mp_value_order(NULL)
+    , mp_frequencies(NULL)
+    , mp_pool(NULL)
+{
+}
+
+/**
+* ~SmkyCompiledDictionary
+*/
+SmkyCompiledDictionary::~SmkyCompiledDictionary (void)
+{
+    close();
+}
+
+/**
+* map compiled file into memory
+*
+* @param i_compiled_file
+*   path + filename of compiled dictionary
+*
+* @return bool
+*   true if file was mapped and looks valid
+*/
+bool SmkyCompiledDictionary::open (const std::string& i_compiled_file)
+{
+    close();
+
+    int fd = ::open(i_compiled_file.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return(false);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(Header))
+    {
+        mp_map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mp_map == MAP_FAILED)
+        {
+            mp_map = NULL;
+        }
+        else
+        {
+            m_map_size = st.st_size;
+        }
+    }
+
+    ::close(fd);
+
+    if (!mp_map)
+    {
+        g_debug("CompiledDB: can't map dictionary file: %s", i_compiled_file.c_str());
+        return(false);
+    }
+
+    if (!_attach(static_cast<const char*>(mp_map), m_map_size))
+    {
+        g_warning("CompiledDB: invalid dictionary file: %s", i_compiled_file.c_str());
+        close();
+        return(false);
+    }
+
+    g_debug("CompiledDB: mapped %u entries from %s", mp_header->count, i_compiled_file.c_str());
+
+    return(true);
+}
+
+/**
+* build image of text dictionary in memory (when there is no compiled file)
+*
+* @param i_text_file
+*   path + filename of text dictionary
+*
+* @param i_format
+*   format of text dictionary
+*
+* @return bool
+*   true if built
+*/
+bool SmkyCompiledDictionary::build (const std::string& i_text_file, SourceFormat i_format)
+{
+    close();
+
+    if (!_makeImage(i_text_file, i_format, m_image) || !_attach(m_image.data(), m_image.size()))
+    {
+        close();
+        return(false);
+    }
+
+    g_debug("CompiledDB: built %u entries from %s", mp_header->count, i_text_file.c_str());
+
+    return(true);
+}
+
+/**
+* set up tables of the image
+*
+* @param ip_base
+*   image (mapped file or memory)
+*
+* @param i_size
+*   size of image
+*
+* @return bool
+*   true if image is valid
+*/
+bool SmkyCompiledDictionary::_attach (const char* ip_base, size_t i_size)
+{
+    if (i_size < sizeof(Header) || !_validate(ip_base, i_size))
+        return(false);
+
+    mp_header = reinterpret_cast<const Header*>(ip_base);
+    mp_keys = reinterpret_cast<const uint32_t*>(ip_base + mp_header->keys_offset);
+    mp_pool = ip_base + mp_header->pool_offset;
+
+    if (mp_header->flags & FLAG_HAS_VALUES)
+    {
+        mp_values = reinterpret_cast<const uint32_t*>(ip_base + mp_header->values_offset);
+        mp_value_order = reinterpret_cast<const uint32_t*>(ip_base + mp_header->value_order_offset);
+    }
+
+    if (mp_header->flags & FLAG_HAS_FREQUENCIES)
+    {
+        mp_frequencies = reinterpret_cast<const uint32_t*>(ip_base + mp_header->frequencies_offset);
+    }
+
+    return(true);
+}
+
+/**
+* unmap file
+*/
+void SmkyCompiledDictionary::close (void)
+{
+    if (mp_map)
+    {
+        munmap(mp_map, m_map_size);
+    }
+
+    mp_map = NULL;
+    m_map_size = 0;
+    m_image.clear();
+    mp_header = NULL;
+    mp_keys = NULL;
+    mp_values = NULL;
+    mp_value_order = NULL;
+    mp_frequencies = NULL;
+    mp_pool = NULL;
+}
+
+/**
+* validate header and tables against the size of image, and every offset of the tables against
+* the string pool, so that lookups never read outside of the image
+*
+* @param ip_base
+*   image (mapped file or memory)
+*
+* @param i_size
+*   size of image
+*
+* @return bool
+*   true if valid
+*/
+bool SmkyCompiledDictionary::_validate (const char* ip_base, size_t i_size) const
+{
+    const Header* p_header = reinterpret_cast<const Header*>(ip_base);
+
+    if (memcmp(p_header->magic, k_magic, sizeof(k_magic)) != 0 || p_header->version != k_version)
+        return(false);
+
+    uint64_t table_size = (uint64_t)p_header->count * sizeof(uint32_t);
+
+    if (p_header->keys_offset + table_size > i_size)
+        return(false);
+
+    if (p_header->flags & FLAG_HAS_VALUES)
+    {
+        if (p_header->values_offset + table_size > i_size ||
+            p_header->value_order_offset + table_size > i_size)
+            return(false);
+    }
+
+    if (p_header->flags & FLAG_HAS_FREQUENCIES)
+    {
+        if (p_header->frequencies_offset + table_size > i_size)
+            return(false);
+    }
+
+    if (p_header->pool_size == 0 || (uint64_t)p_header->pool_offset + p_header->pool_size > i_size)
+        return(false);
+
+    //tables are read as uint32_t in place
+    if ((p_header->keys_offset | p_header->values_offset | p_header->value_order_offset | p_header->frequencies_offset) % sizeof(uint32_t) != 0)
+        return(false);
+
+    //all the strings must be terminated inside of the pool
+    const char* p_pool = ip_base + p_header->pool_offset;
+    if (p_pool[p_header->pool_size - 1] != '\0')
+        return(false);
+
+    const uint32_t* p_keys = reinterpret_cast<const uint32_t*>(ip_base + p_header->keys_offset);
+    for (uint32_t i = 0; i < p_header->count; ++i)
+    {
+        if (p_keys[i] >= p_header->pool_size)
+            return(false);
+    }
+
+    if (p_header->flags & FLAG_HAS_VALUES)
+    {
+        const uint32_t* p_values = reinterpret_cast<const uint32_t*>(ip_base + p_header->values_offset);
+        const uint32_t* p_value_order = reinterpret_cast<const uint32_t*>(ip_base + p_header->value_order_offset);
+
+        for (uint32_t i = 0; i < p_header->count; ++i)
+        {
+            if (p_values[i] >= p_header->pool_size || p_value_order[i] >= p_header->count)
+                return(false);
+        }
+    }
+
+    return(true);
+}
+
+/**
+* find entry by key
+*
+* @param ip_key
+*   key to find
+*
+* @return int
+*   index of entry, -1 if not found
+*/
+int SmkyCompiledDictionary::find (const char* ip_key) const
+{
+    if (!isOpen())
+        return(-1);
+
+    std::string key(ip_key);
+    const uint32_t* p_end = mp_keys + mp_header->count;
+    const uint32_t* p_it = std::lower_bound(mp_keys, p_end, key, SmkyCompiledKeyLess(mp_pool));
+
+    if (p_it != p_end && key.compare(mp_pool + *p_it) == 0)
+    {
+        return(p_it - mp_keys);
+    }
+
+    return(-1);
+}
+
+/**
+* find first key (in sorted order) starting with prefix
+*
+* @param prefix
+*   prefix to search
+*
+* @return const char*
+*   NULL if nothing found
+*/
+const char* SmkyCompiledDictionary::findKeyByPrefix (const std::string& prefix) const
+{
+    if (!isOpen())
+        return(NULL);
+
+    const uint32_t* p_end = mp_keys + mp_header->count;
+    const uint32_t* p_it = std::lower_bound(mp_keys, p_end, prefix, SmkyCompiledKeyLess(mp_pool));
+
+    if (p_it != p_end && strncmp(mp_pool + *p_it, prefix.c_str(), prefix.length()) == 0)
+    {
+        return(mp_pool + *p_it);
+    }
+
+    return(NULL);
+}
+
+/**
+* find first value (in sorted order) starting with prefix
+*
+* @param prefix
+*   prefix to search
+*
+* @return const char*
+*   NULL if nothing found
+*/
+const char* SmkyCompiledDictionary::findValueByPrefix (const std::string& prefix) const
+{
+    if (!isOpen() || !hasValues())
+        return(NULL);
+
+    const uint32_t* p_end = mp_value_order + mp_header->count;
+    const uint32_t* p_it = std::lower_bound(mp_value_order, p_end, prefix, SmkyCompiledValueLess(mp_pool, mp_values));
+
+    if (p_it != p_end && strncmp(mp_pool + mp_values[*p_it], prefix.c_str(), prefix.length()) == 0)
+    {
+        return(mp_pool + mp_values[*p_it]);
+    }
+
+    return(NULL);
+}
+
+/**
+* find the most frequent key starting with prefix, the first one (in sorted order) wins if there are
+* no frequencies or they are equal
+*
+* @param prefix
+*   prefix to search
+*
+* @return int
+*   index of entry, -1 if nothing found
+*/
+int SmkyCompiledDictionary::findBestKeyByPrefix (const std::string& prefix) const
+{
+    if (!isOpen())
+        return(-1);
+
+    const uint32_t* p_end = mp_keys + mp_header->count;
+    const uint32_t* p_it = std::lower_bound(mp_keys, p_end, prefix, SmkyCompiledKeyLess(mp_pool));
+    int best = -1;
+
+    //keys with the same prefix are adjacent
+    for (; p_it != p_end && strncmp(mp_pool + *p_it, prefix.c_str(), prefix.length()) == 0; ++p_it)
+    {
+        int index = p_it - mp_keys;
+
+        if (best < 0 || frequencyAt(index) > frequencyAt(best))
+        {
+            best = index;
+        }
+
+        if (!mp_frequencies)
+            break;
+    }
+
+    return(best);
+}
+
+/**
+* find keys starting with prefix: one seek and a step per key
+*
+* @param prefix
+*   prefix to search
+*
+* @param i_max
+*   limit number of keys
+*
+* @param o_keys
+*   output: found keys are appended in sorted order
+*/
+void SmkyCompiledDictionary::findKeysByPrefix (const std::string& prefix, size_t i_max, std::list<std::string>& o_keys) const
+{
+    if (!isOpen())
+        return;
+
+    const uint32_t* p_end = mp_keys + mp_header->count;
+    const uint32_t* p_it = std::lower_bound(mp_keys, p_end, prefix, SmkyCompiledKeyLess(mp_pool));
+
+    for (size_t found = 0; p_it != p_end && found < i_max; ++p_it, ++found)
+    {
+        if (strncmp(mp_pool + *p_it, prefix.c_str(), prefix.length()) != 0)
+            break;
+
+        o_keys.push_back(mp_pool + *p_it);
+    }
+}
+
+/**
+* find values starting with prefix: one seek and a step per value, equal values are reported once
+*
+* @param prefix
+*   prefix to search
+*
+* @param i_max
+*   limit number of values
+*
+* @param o_values
+*   output: found values are appended in sorted order
+*/
+void SmkyCompiledDictionary::findValuesByPrefix (const std::string& prefix, size_t i_max, std::list<std::string>& o_values) const
+{
+    if (!isOpen() || !hasValues())
+        return;
+
+    const uint32_t* p_end = mp_value_order + mp_header->count;
+    const uint32_t* p_it = std::lower_bound(mp_value_order, p_end, prefix, SmkyCompiledValueLess(mp_pool, mp_values));
+    const char* p_last = NULL;
+    size_t found = 0;
+
+    for (; p_it != p_end && found < i_max; ++p_it)
+    {
+        const char* p_value = mp_pool + mp_values[*p_it];
+
+        if (strncmp(p_value, prefix.c_str(), prefix.length()) != 0)
+            break;
+
+        if (p_last && strcmp(p_last, p_value) == 0)
+            continue;
+
+        o_values.push_back(p_value);
+        p_last = p_value;
+        found++;
+    }
+}
+
+/**
+* order (frequency, index) pairs: more frequent first, then in sorted order of keys
+*/
+static bool compare_frequent_first (const std::pair<uint32_t, uint32_t>& first, const std::pair<uint32_t, uint32_t>& second)
+{
+    return (first.first > second.first || (first.first == second.first && first.second < second.second));
+}
+
+/**
+* find the most frequent keys starting with prefix, the whole range of keys is scanned,
+* so it is cheap only for the frequency lists (numbers only)
+*
+* @param prefix
+*   prefix to search
+*
+* @param i_max
+*   limit number of keys
+*
+* @param o_keys
+*   output: found keys are appended, the most frequent first
+*/
+void SmkyCompiledDictionary::findBestKeysByPrefix (const std::string& prefix, size_t i_max, std::list<std::string>& o_keys) const
+{
+    if (!isOpen() || i_max == 0)
+        return;
+
+    if (!mp_frequencies)
+    {
+        findKeysByPrefix(prefix, i_max, o_keys);
+        return;
+    }
+
+    const uint32_t* p_end = mp_keys + mp_header->count;
+    const uint32_t* p_it = std::lower_bound(mp_keys, p_end, prefix, SmkyCompiledKeyLess(mp_pool));
+    std::vector< std::pair<uint32_t, uint32_t> > range;
+
+    for (; p_it != p_end && strncmp(mp_pool + *p_it, prefix.c_str(), prefix.length()) == 0; ++p_it)
+    {
+        uint32_t index = p_it - mp_keys;
+        range.push_back(std::make_pair(mp_frequencies[index], index));
+    }
+
+    size_t count = std::min(i_max, range.size());
+    std::partial_sort(range.begin(), range.begin() + count, range.end(), compare_frequent_first);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        o_keys.push_back(keyAt(range[i].second));
+    }
+}
+
+/**
+* get path of compiled file for the text dictionary
+*
+* @param i_text_file
+*   path + filename of text dictionary
+*
+* @return std::string
+*   path + filename of compiled dictionary
+*/
+std::string SmkyCompiledDictionary::getCompiledPath (const std::string& i_text_file)
+{
+    return(i_text_file + k_compiled_ext);
+}
+
+/**
+* compiled file can be used instead of text file if it is not older than text file
+* (or text file doesn't exist at all)
+*
+* @param i_text_file
+*   path + filename of text dictionary
+*
+* @param i_compiled_file
+*   path + filename of compiled dictionary
+*
+* @return bool
+*   true if compiled file is up to date
+*/
+bool SmkyCompiledDictionary::isFresh (const std::string& i_text_file, const std::string& i_compiled_file)
+{
+    struct stat compiled_st;
+    if (stat(i_compiled_file.c_str(), &compiled_st) != 0)
+        return(false);
+
+    struct stat text_st;
+    if (stat(i_text_file.c_str(), &text_st) != 0)
+        return(true);
+
+    return(compiled_st.st_mtime >= text_st.st_mtime);
+}
+
+/**
+* compile text dictionary into binary format
+*
+* @param i_text_file
+*   path + filename of text dictionary
+*
+* @param i_compiled_file
+*   path + filename of compiled dictionary
+*
+* @param i_format
+*   format of text dictionary
+*
+* @return bool
+*   true if compiled
+*/
+bool SmkyCompiledDictionary::compile (const std::string& i_text_file, const std::string& i_compiled_file, SourceFormat i_format)
+{
+    std::string image;
+
+    if (!_makeImage(i_text_file, i_format, image))
+        return(false);
+
+    FILE* f = fopen(i_compiled_file.c_str(), "wb");
+    if (!f)
+    {
+        g_warning("CompiledDB: can't create compiled file: %s", i_compiled_file.c_str());
+        return(false);
+    }
+
+    bool written = fwrite(image.data(), 1, image.size(), f) == image.size();
+    written = (fclose(f) == 0) && written;
+
+    if (!written)
+    {
+        g_warning("CompiledDB: failed to write compiled file: %s", i_compiled_file.c_str());
+        unlink(i_compiled_file.c_str());
+    }
+
+    return(written);
+}
+
+/**
+* make binary image of text dictionary
+*
+* @param i_text_file
+*   path + filename of text dictionary
+*
+* @param i_format
+*   format of text dictionary
+*
+* @param o_image
+*   output: image (compiled file content)
+*
+* @return bool
+*   true if done
+*/
+bool SmkyCompiledDictionary::_makeImage (const std::string& i_text_file, SourceFormat i_format, std::string& o_image)
+{
+    ifstream fin(i_text_file.c_str());
+
+    if (!fin.is_open())
+    {
+        g_warning("CompiledDB: can't open dictionary file: %s", i_text_file.c_str());
+        return(false);
+    }
+
+    bool pairs = (i_format == SOURCE_PAIRS);
+    bool frequencies = (i_format == SOURCE_FREQUENCIES);
+
+    //read entries the same way as SmkyFileKeywords/SmkyFilePairs do
+    std::vector<SmkyCompiledEntry> entries;
+    boost::char_separator<char> sep("|");
+    std::string line;
+    SmkyCompiledEntry entry;
+
+    while ( !fin.eof() )
+    {
+        getline(fin, line);
+
+        if (line.empty())
+            continue;
+
+        if (pairs)
+        {
+            tokenizer tokens(line, sep);
+            tokenizer::iterator tok_iter = tokens.begin();
+
+            if (tok_iter == tokens.end())
+                continue;
+
+            entry.key = *tok_iter;
+            ++tok_iter;
+
+            if (tok_iter != tokens.end())
+            {
+                entry.value = *tok_iter;
+                entries.push_back(entry);
+            }
+        }
+        else if (frequencies)
+        {
+            //'word count', count is separated by the last space or tab
+            size_t pos = line.find_last_of(" \t");
+
+            if (pos == std::string::npos || pos == 0)
+                continue;
+
+            entry.key = line.substr(0, line.find_last_not_of(" \t", pos) + 1);
+            entry.frequency = strtoul(line.c_str() + pos + 1, NULL, 10);
+            entries.push_back(entry);
+        }
+        else
+        {
+            entry.key = line;
+            entries.push_back(entry);
+        }
+    }
+
+    //sort by key, the first occurrence of the key wins (like hash_map::insert)
+    std::stable_sort(entries.begin(), entries.end(), compare_entry_keys);
+    entries.erase(std::unique(entries.begin(), entries.end(), equal_entry_keys), entries.end());
+
+    uint32_t count = entries.size();
+    std::vector<uint32_t> keys(count);
+    std::vector<uint32_t> values(pairs ? count : 0);
+    std::vector<uint32_t> value_order(pairs ? count : 0);
+    std::vector<uint32_t> counts(frequencies ? count : 0);
+    std::string pool;
+
+    //first byte of the pool is an empty string
+    pool.push_back('\0');
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        keys[i] = pool.size();
+        pool.append(entries[i].key);
+        pool.push_back('\0');
+
+        if (pairs)
+        {
+            values[i] = pool.size();
+            pool.append(entries[i].value);
+            pool.push_back('\0');
+            value_order[i] = i;
+        }
+
+        if (frequencies)
+        {
+            counts[i] = entries[i].frequency;
+        }
+    }
+
+    if (pairs)
+    {
+        std::vector< std::pair<std::string, uint32_t> > by_value(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            by_value[i] = std::pair<std::string, uint32_t>(entries[i].value, i);
+        }
+
+        std::sort(by_value.begin(), by_value.end());
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            value_order[i] = by_value[i].second;
+        }
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, k_magic, sizeof(k_magic));
+    header.version = k_version;
+    header.count = count;
+    header.flags = (pairs ? FLAG_HAS_VALUES : 0) | (frequencies ? FLAG_HAS_FREQUENCIES : 0);
+    header.keys_offset = sizeof(Header);
+
+    uint32_t offset = header.keys_offset + count * sizeof(uint32_t);
+    if (pairs)
+    {
+        header.values_offset = offset;
+        offset += count * sizeof(uint32_t);
+        header.value_order_offset = offset;
+        offset += count * sizeof(uint32_t);
+    }
+
+    if (frequencies)
+    {
+        header.frequencies_offset = offset;
+        offset += count * sizeof(uint32_t);
+    }
+
+    header.pool_offset = offset;
+    header.pool_size = pool.size();
+
+    o_image.clear();
+    o_image.reserve(offset + pool.size());
+    o_image.append(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (count > 0)
+    {
+        o_image.append(reinterpret_cast<const char*>(&keys[0]), count * sizeof(uint32_t));
+
+        if (pairs)
+        {
+            o_image.append(reinterpret_cast<const char*>(&values[0]), count * sizeof(uint32_t));
+            o_image.append(reinterpret_cast<const char*>(&value_order[0]), count * sizeof(uint32_t));
+        }
+
+        if (frequencies)
+        {
+            o_image.append(reinterpret_cast<const char*>(&counts[0]), count * sizeof(uint32_t));
+        }
+    }
+
+    o_image.append(pool);
+
+    return(true);
+}
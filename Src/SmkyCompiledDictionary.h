@@ -0,0 +1,243 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SMKY_COMPILED_DICTIONARY_H
+#define SMKY_COMPILED_DICTIONARY_H
+
+#include <stdint.h>
+#include <string>
+#include <list>
+
+namespace SmartKey
+{
+
+/**
+ * Read-only dictionary compiled from the text dictionaries (see Tools/DictionaryCompiler.cpp)
+ * and mapped into memory as is, so loading costs no parsing and pages are shared between processes.
+ * The same image can be built in memory from the text file when there is no compiled file.
+ *
+ * File layout (native byte order):
+ *   Header
+ *   uint32_t keys[count]         offsets of keys in the string pool, sorted by key (strcmp order)
+ *   uint32_t values[count]       offsets of values, aligned with keys (pairs only)
+ *   uint32_t value_order[count]  entry indexes sorted by value (pairs only)
+ *   uint32_t frequencies[count]  usage counts, aligned with keys (frequency lists only)
+ *   char     pool[pool_size]     zero terminated strings
+ */
+class SmkyCompiledDictionary
+{
+public:
+    struct Header
+    {
+        char     magic[4];
+        uint32_t version;
+        uint32_t count;
+        uint32_t flags;
+        uint32_t keys_offset;
+        uint32_t values_offset;
+        uint32_t value_order_offset;
+        uint32_t frequencies_offset;
+        uint32_t pool_offset;
+        uint32_t pool_size;
+    };
+
+    enum
+    {
+        FLAG_HAS_VALUES = 1
+        ,FLAG_HAS_FREQUENCIES = 2
+    };
+
+    //format of text dictionary
+    enum SourceFormat
+    {
+        SOURCE_WORDS = 0        //one word per line
+        ,SOURCE_PAIRS           //'key|value' per line
+        ,SOURCE_FREQUENCIES     //'word count' per line
+    };
+
+private:
+    void*          mp_map;
+    size_t         m_map_size;
+
+    //image built in memory from text file
+    std::string    m_image;
+
+    const Header*   mp_header;
+    const uint32_t* mp_keys;
+    const uint32_t* mp_values;
+    const uint32_t* mp_value_order;
+    const uint32_t* mp_frequencies;
+    const char*     mp_pool;
+
+public:
+
+    SmkyCompiledDictionary (void);
+    virtual ~SmkyCompiledDictionary (void);
+
+    //map compiled file into memory
+    bool open (const std::string& i_compiled_file);
+
+    //build image from text dictionary in memory
+    bool build (const std::string& i_text_file, SourceFormat i_format);
+
+    //unmap file
+    void close (void);
+
+    //is file mapped (or built)?
+    bool isOpen (void) const;
+
+    //number of entries
+    uint32_t size (void) const;
+
+    //bytes of mapped file
+    size_t mappedSize (void) const;
+
+    //bytes of image built in memory
+    size_t memoryUsed (void) const;
+
+    //are there values (compiled from pairs dictionary)?
+    bool hasValues (void) const;
+
+    //key of entry
+    const char* keyAt (uint32_t i_index) const;
+
+    //value of entry
+    const char* valueAt (uint32_t i_index) const;
+
+    //are there frequencies (compiled from frequency list)?
+    bool hasFrequencies (void) const;
+
+    //frequency of entry, 0 if there are no frequencies
+    uint32_t frequencyAt (uint32_t i_index) const;
+
+    //find entry by key, return -1 if not found
+    int find (const char* ip_key) const;
+
+    //find first key starting with prefix
+    const char* findKeyByPrefix (const std::string& prefix) const;
+
+    //find first value starting with prefix
+    const char* findValueByPrefix (const std::string& prefix) const;
+
+    //find the most frequent key starting with prefix, return -1 if not found
+    int findBestKeyByPrefix (const std::string& prefix) const;
+
+    //find up to i_max keys starting with prefix (in sorted order)
+    void findKeysByPrefix (const std::string& prefix, size_t i_max, std::list<std::string>& o_keys) const;
+
+    //find up to i_max different values starting with prefix (in sorted order)
+    void findValuesByPrefix (const std::string& prefix, size_t i_max, std::list<std::string>& o_values) const;
+
+    //find up to i_max the most frequent keys starting with prefix (the most frequent first)
+    void findBestKeysByPrefix (const std::string& prefix, size_t i_max, std::list<std::string>& o_keys) const;
+
+    //get path of compiled file for the text dictionary
+    static std::string getCompiledPath (const std::string& i_text_file);
+
+    //is compiled file exist and not older than text dictionary?
+    static bool isFresh (const std::string& i_text_file, const std::string& i_compiled_file);
+
+    //compile text dictionary
+    static bool compile (const std::string& i_text_file, const std::string& i_compiled_file, SourceFormat i_format);
+
+private:
+    //make binary image of text dictionary
+    static bool _makeImage (const std::string& i_text_file, SourceFormat i_format, std::string& o_image);
+
+    //set up tables of the image
+    bool _attach (const char* ip_base, size_t i_size);
+
+    //validate image data
+    bool _validate (const char* ip_base, size_t i_size) const;
+};
+
+/**
+* is file mapped (or built)?
+*/
+inline bool SmkyCompiledDictionary::isOpen (void) const
+{
+    return(mp_header != NULL);
+}
+
+/**
+* number of entries
+*/
+inline uint32_t SmkyCompiledDictionary::size (void) const
+{
+    return(mp_header ? mp_header->count : 0);
+}
+
+/**
+* bytes of mapped file
+*/
+inline size_t SmkyCompiledDictionary::mappedSize (void) const
+{
+    return(m_map_size);
+}
+
+/**
+* bytes of image built in memory
+*/
+inline size_t SmkyCompiledDictionary::memoryUsed (void) const
+{
+    return(m_image.capacity());
+}
+
+/**
+* are there values (compiled from pairs dictionary)?
+*/
+inline bool SmkyCompiledDictionary::hasValues (void) const
+{
+    return(mp_values != NULL);
+}
+
+/**
+* key of entry
+*/
+inline const char* SmkyCompiledDictionary::keyAt (uint32_t i_index) const
+{
+    return(mp_pool + mp_keys[i_index]);
+}
+
+/**
+* value of entry
+*/
+inline const char* SmkyCompiledDictionary::valueAt (uint32_t i_index) const
+{
+    return(mp_values ? mp_pool + mp_values[i_index] : "");
+}
+
+/**
+* are there frequencies (compiled from frequency list)?
+*/
+inline bool SmkyCompiledDictionary::hasFrequencies (void) const
+{
+    return(mp_frequencies != NULL);
+}
+
+/**
+* frequency of entry
+*/
+inline uint32_t SmkyCompiledDictionary::frequencyAt (uint32_t i_index) const
+{
+    return(mp_frequencies ? mp_frequencies[i_index] : 0);
+}
+
+}
+
+#endif
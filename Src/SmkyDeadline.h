@@ -0,0 +1,273 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SMKY_DEADLINE_H
+#define SMKY_DEADLINE_H
+
+#include <glib.h>
+
+namespace SmartKey
+{
+
+/**
+ * Latest request sequence number of a client session, shared by SmkyRequestSessions and
+ * tickets of the session: it is released with the last reference, so a session may be
+ * dropped while its requests are still running.
+ */
+struct SmkySessionState
+{
+    volatile gint latest;   ///< Sequence number of the latest request.
+    volatile gint refs;     ///< References of the sessions list and tickets.
+};
+
+/**
+ * Identifies request in the session of a client: request is superseded as soon as
+ * a newer one of the same session is started (see SmkyRequestSessions).
+ * Default ticket is never superseded.
+ */
+class SmkyRequestTicket
+{
+private:
+    //state of the session (referenced), NULL if request has no session
+    SmkySessionState* mp_state;
+
+    //sequence number of the request
+    gint m_seq;
+
+public:
+
+    SmkyRequestTicket (void);
+    SmkyRequestTicket (SmkySessionState* ip_state, gint i_seq);
+    SmkyRequestTicket (const SmkyRequestTicket& i_other);
+    ~SmkyRequestTicket (void);
+
+    SmkyRequestTicket& operator= (const SmkyRequestTicket& i_other);
+
+    //was a newer request of the session started?
+    bool isSuperseded (void) const;
+
+    //add reference of the session state
+    static SmkySessionState* ref (SmkySessionState* ip_state);
+
+    //drop reference of the session state, it is released with the last one
+    static void unref (SmkySessionState* ip_state);
+};
+
+/**
+ * Time budget of a single request, measured with the monotonic clock.
+ * Budget <= 0 means "no limit". Budget is treated as spent once request is superseded.
+ */
+class SmkyDeadline
+{
+private:
+    //start time (microseconds)
+    gint64 m_start;
+
+    //expiration time (microseconds), 0 if there is no limit
+    gint64 m_expires;
+
+    //request which owns the budget
+    SmkyRequestTicket m_ticket;
+
+public:
+
+    SmkyDeadline (int i_budgetMs, const SmkyRequestTicket& i_ticket = SmkyRequestTicket());
+
+    //is there a limit at all?
+    bool isLimited (void) const;
+
+    //is budget spent?
+    bool isExpired (void) const;
+
+    //is request superseded by a newer one?
+    bool isCancelled (void) const;
+
+    //time left (microseconds), G_MAXINT64 if there is no limit
+    gint64 getRemainingUs (void) const;
+
+    //time spent since start (microseconds)
+    gint64 getElapsedUs (void) const;
+};
+
+/**
+* SmkyRequestTicket
+*/
+inline SmkyRequestTicket::SmkyRequestTicket (void)
+    : mp_state(NULL)
+    , m_seq(0)
+{
+}
+
+/**
+* SmkyRequestTicket
+*
+* @param ip_state
+*   state of the session, it is referenced
+*
+* @param i_seq
+*   sequence number of the request
+*/
+inline SmkyRequestTicket::SmkyRequestTicket (SmkySessionState* ip_state, gint i_seq)
+    : mp_state(ref(ip_state))
+    , m_seq(i_seq)
+{
+}
+
+/**
+* SmkyRequestTicket
+*
+* @param i_other
+*   ticket to copy
+*/
+inline SmkyRequestTicket::SmkyRequestTicket (const SmkyRequestTicket& i_other)
+    : mp_state(ref(i_other.mp_state))
+    , m_seq(i_other.m_seq)
+{
+}
+
+/**
+* ~SmkyRequestTicket
+*/
+inline SmkyRequestTicket::~SmkyRequestTicket (void)
+{
+    unref(mp_state);
+}
+
+/**
+* copy ticket
+*
+* @param i_other
+*   ticket to copy
+*
+* @return SmkyRequestTicket&
+*   this ticket
+*/
+inline SmkyRequestTicket& SmkyRequestTicket::operator= (const SmkyRequestTicket& i_other)
+{
+    //referenced first, the state may be the same
+    SmkySessionState* p_state = ref(i_other.mp_state);
+    unref(mp_state);
+
+    mp_state = p_state;
+    m_seq = i_other.m_seq;
+
+    return(*this);
+}
+
+/**
+* was a newer request of the session started?
+*/
+inline bool SmkyRequestTicket::isSuperseded (void) const
+{
+    return(mp_state != NULL && g_atomic_int_get(&mp_state->latest) > m_seq);
+}
+
+/**
+* add reference of the session state
+*
+* @param ip_state
+*   state, may be NULL
+*
+* @return SmkySessionState*
+*   ip_state
+*/
+inline SmkySessionState* SmkyRequestTicket::ref (SmkySessionState* ip_state)
+{
+    if (ip_state)
+        g_atomic_int_inc(&ip_state->refs);
+
+    return(ip_state);
+}
+
+/**
+* drop reference of the session state, it is released with the last one
+*
+* @param ip_state
+*   state, may be NULL
+*/
+inline void SmkyRequestTicket::unref (SmkySessionState* ip_state)
+{
+    if (ip_state && g_atomic_int_dec_and_test(&ip_state->refs))
+        delete ip_state;
+}
+
+/**
+* SmkyDeadline
+*
+* @param i_budgetMs
+*   budget in milliseconds, <= 0 - no limit
+*
+* @param i_ticket
+*   request which owns the budget
+*/
+inline SmkyDeadline::SmkyDeadline (int i_budgetMs, const SmkyRequestTicket& i_ticket)
+    : m_start(g_get_monotonic_time())
+    , m_expires(0)
+    , m_ticket(i_ticket)
+{
+    if (i_budgetMs > 0)
+        m_expires = m_start + (gint64)i_budgetMs * 1000;
+}
+
+/**
+* is there a limit at all?
+*/
+inline bool SmkyDeadline::isLimited (void) const
+{
+    return(m_expires != 0);
+}
+
+/**
+* is budget spent?
+*/
+inline bool SmkyDeadline::isExpired (void) const
+{
+    return((m_expires != 0 && g_get_monotonic_time() >= m_expires) || isCancelled());
+}
+
+/**
+* is request superseded by a newer one?
+*/
+inline bool SmkyDeadline::isCancelled (void) const
+{
+    return(m_ticket.isSuperseded());
+}
+
+/**
+* time left (microseconds)
+*/
+inline gint64 SmkyDeadline::getRemainingUs (void) const
+{
+    if (m_expires == 0)
+        return(G_MAXINT64);
+
+    gint64 remaining = m_expires - g_get_monotonic_time();
+    return(remaining > 0 ? remaining : 0);
+}
+
+/**
+* time spent since start (microseconds)
+*/
+inline gint64 SmkyDeadline::getElapsedUs (void) const
+{
+    return(g_get_monotonic_time() - m_start);
+}
+
+}
+
+#endif
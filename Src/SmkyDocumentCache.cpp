@@ -0,0 +1,221 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "Database.h"
+#include "SmkyDocumentCache.h"
+#include "SmkySpellCheckCache.h"
+
+using namespace SmartKey;
+
+/**
+* SmkyDocumentCache
+*/
+SmkyDocumentCache::SmkyDocumentCache (void)
+    : m_clock(0)
+{
+    g_mutex_init(&m_mutex);
+}
+
+/**
+* ~SmkyDocumentCache
+*/
+SmkyDocumentCache::~SmkyDocumentCache (void)
+{
+    m_documents.clear();
+    g_mutex_clear(&m_mutex);
+}
+
+/**
+* get valid results of the document, mutex is locked by caller
+*
+* @param i_document
+*   document id
+*
+* @param i_options
+*   options of the check (results of other options are dropped)
+*
+* @param i_create
+*   create document if there is no such one
+*
+* @return Document*
+*   document, NULL if not found and i_create is false
+*/
+SmkyDocumentCache::Document* SmkyDocumentCache::_getDocument (const std::string& i_document, const std::string& i_options, bool i_create)
+{
+    gint generation = getDictionaryGeneration();
+    DocumentsMap::iterator it = m_documents.find(i_document);
+
+    if (it == m_documents.end())
+    {
+        if (!i_create)
+            return(NULL);
+
+        //drop least recently used document
+        if (m_documents.size() >= MAX_DOCUMENTS)
+        {
+            DocumentsMap::iterator oldest = m_documents.begin();
+            for (DocumentsMap::iterator doc = m_documents.begin(); doc != m_documents.end(); ++doc)
+            {
+                if (doc->second.used < oldest->second.used)
+                    oldest = doc;
+            }
+
+            g_debug("DocumentCache: dropping document '%s'", oldest->first.c_str());
+            m_documents.erase(oldest);
+        }
+
+        it = m_documents.insert(std::make_pair(i_document, Document())).first;
+        it->second.options = i_options;
+        it->second.generation = generation;
+    }
+
+    Document& document = it->second;
+
+    if (document.generation != generation || document.options != i_options)
+    {
+        document.results.clear();
+        document.options = i_options;
+        document.generation = generation;
+    }
+
+    document.used = ++m_clock;
+
+    return(&document);
+}
+
+/**
+* find result of the word in the document
+*
+* @param i_document
+*   document id
+*
+* @param i_options
+*   options of the check
+*
+* @param i_word
+*   word (with context if it matters)
+*
+* @param o_result
+*   output: result
+*
+* @return bool
+*   true if found
+*/
+bool SmkyDocumentCache::lookup (const std::string& i_document, const std::string& i_options, const std::string& i_word, SpellCheckWordInfo& o_result)
+{
+    bool found = false;
+
+    g_mutex_lock(&m_mutex);
+
+    Document* p_document = _getDocument(i_document, i_options, false);
+    if (p_document)
+    {
+        ResultsMap::iterator it = p_document->results.find(i_word);
+        if (it != p_document->results.end())
+        {
+            o_result = it->second;
+            found = true;
+        }
+    }
+
+    g_mutex_unlock(&m_mutex);
+
+    return(found);
+}
+
+/**
+* remember result of the word in the document
+*
+* @param i_document
+*   document id
+*
+* @param i_options
+*   options of the check
+*
+* @param i_word
+*   word (with context if it matters)
+*
+* @param i_result
+*   result
+*/
+void SmkyDocumentCache::store (const std::string& i_document, const std::string& i_options, const std::string& i_word, const SpellCheckWordInfo& i_result)
+{
+    g_mutex_lock(&m_mutex);
+
+    Document* p_document = _getDocument(i_document, i_options, true);
+
+    //document is too big, start over
+    if (p_document->results.size() >= MAX_WORDS)
+        p_document->results.clear();
+
+    p_document->results[i_word] = i_result;
+
+    g_mutex_unlock(&m_mutex);
+}
+
+/**
+* forget the document
+*
+* @param i_document
+*   document id
+*/
+void SmkyDocumentCache::remove (const std::string& i_document)
+{
+    g_mutex_lock(&m_mutex);
+    m_documents.erase(i_document);
+    g_mutex_unlock(&m_mutex);
+}
+
+/**
+* get memory usage of results of all documents, keys are words and document ids,
+* node overhead is estimated as one pointer per result node and bucket and three per document node
+*
+* @param o_stats
+*   output: statistics, name is not changed
+*/
+void SmkyDocumentCache::getStats (DictionaryStats& o_stats)
+{
+    g_mutex_lock(&m_mutex);
+
+    o_stats.entries = 0;
+    o_stats.keyBytes = 0;
+    o_stats.valueBytes = 0;
+    o_stats.overheadBytes = 0;
+
+    for (DocumentsMap::const_iterator doc = m_documents.begin(); doc != m_documents.end(); ++doc)
+    {
+        const Document& document = doc->second;
+
+        o_stats.entries += document.results.size();
+        o_stats.keyBytes += doc->first.capacity() + 1;
+        o_stats.overheadBytes += 3 * sizeof(void*) + sizeof(DocumentsMap::value_type) + document.options.capacity() + 1
+            + document.results.bucket_count() * sizeof(void*);
+
+        for (ResultsMap::const_iterator it = document.results.begin(); it != document.results.end(); ++it)
+        {
+            o_stats.keyBytes += it->first.capacity() + 1;
+            o_stats.valueBytes += SmkySpellCheckCache::resultBytes(it->second);
+            o_stats.overheadBytes += sizeof(void*) + sizeof(ResultsMap::value_type);
+        }
+    }
+
+    o_stats.mappedBytes = 0;
+    o_stats.loadMs = 0;
+
+    g_mutex_unlock(&m_mutex);
+}
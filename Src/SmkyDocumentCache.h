@@ -0,0 +1,89 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SMKY_DOCUMENT_CACHE_H
+#define SMKY_DOCUMENT_CACHE_H
+
+#include <ext/hash_map> //I know about replacement to <unordered_map>, but not sure yet about c++11 support for this project
+#include <map>
+#include <string>
+#include <glib.h>
+#include "SmkyFileKeywords.h"
+#include "SpellCheckClient.h"
+
+namespace SmartKey
+{
+
+/**
+ * Results of checkText per document (client supplied id), keyed by word, so only words which are
+ * new in the document (e.g. edited ones) have to be checked again. Results of a document are dropped
+ * when any dictionary is changed (see getDictionaryGeneration()) or document is checked with other
+ * options (locale, mode, ...). Document is dropped when client closes it (checkText "closed"), or as
+ * the least recently used one when there are too many of them.
+ */
+class SmkyDocumentCache
+{
+public:
+    enum
+    {
+        MAX_DOCUMENTS = 16
+        ,MAX_WORDS = 4096
+    };
+
+private:
+    typedef hash_map<std::string, SpellCheckWordInfo, SmkyHasher, SmkyComparator> ResultsMap;
+
+    struct Document
+    {
+        ResultsMap  results;
+        std::string options;
+        gint        generation;
+        guint64     used;
+    };
+
+    typedef std::map<std::string, Document> DocumentsMap;
+
+    DocumentsMap m_documents;
+    guint64      m_clock;
+    GMutex       m_mutex;
+
+public:
+
+    SmkyDocumentCache (void);
+    virtual ~SmkyDocumentCache (void);
+
+    //find result of the word in the document, return true if found
+    bool lookup (const std::string& i_document, const std::string& i_options, const std::string& i_word, SpellCheckWordInfo& o_result);
+
+    //remember result of the word in the document
+    void store (const std::string& i_document, const std::string& i_options, const std::string& i_word, const SpellCheckWordInfo& i_result);
+
+    //forget the document
+    void remove (const std::string& i_document);
+
+    //get memory usage of results of all documents (name is not set)
+    void getStats (DictionaryStats& o_stats);
+
+private:
+    //get valid results of the document (mutex is locked by caller), NULL if there is no such document
+    Document* _getDocument (const std::string& i_document, const std::string& i_options, bool i_create);
+};
+
+}
+
+#endif
@@ -0,0 +1,505 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#include <stdlib.h>
+#include <algorithm>
+#include <set>
+#include "SmkyExtraLocales.h"
+
+using namespace SmartKey;
+
+/**
+ * Guesses of one word being found in extra locales, tasks are run by pool threads
+ * (or by caller if they can't be queued), the last finished task signals the caller.
+ */
+struct SmkyExtraLocales::Search
+{
+    std::string         word;
+    int                 maxGuesses;
+    const SmkyDeadline* deadline;
+    bool                rankByKeys;
+    std::vector<Task>   tasks;
+    int                 pending;    ///< Tasks not finished yet.
+    GMutex              mutex;
+    GCond               done;
+};
+
+/**
+ * Guess of a locale scored for merging: weight of the locale divided by position of the guess
+ */
+struct ScoredGuess
+{
+    double           score;
+    const WordGuess* guess;
+};
+
+/**
+* order merged guesses: higher score first (guesses of the same score keep order of locales)
+*/
+static bool compare_scored_guess (const ScoredGuess& first, const ScoredGuess& second)
+{
+    return(first.score > second.score);
+}
+
+/**
+* score guesses of a locale and add them to the list for merging
+*
+* @param i_guesses
+*   guesses of the locale, the best first
+*
+* @param i_weight
+*   weight of the locale
+*
+* @param io_scored
+*   output: scored guesses are appended
+*/
+static void add_scored_guesses (const std::vector<WordGuess>& i_guesses, int i_weight, std::vector<ScoredGuess>& io_scored)
+{
+    for (size_t i = 0; i < i_guesses.size(); ++i)
+    {
+        ScoredGuess scored;
+        scored.score = (double)i_weight / (i + 1);
+        scored.guess = &i_guesses[i];
+        io_scored.push_back(scored);
+    }
+}
+
+/**
+* SmkyExtraLocales
+*/
+SmkyExtraLocales::SmkyExtraLocales (void)
+    : mp_pool(NULL)
+{
+}
+
+/**
+* ~SmkyExtraLocales
+*/
+SmkyExtraLocales::~SmkyExtraLocales (void)
+{
+    _clean();
+}
+
+/**
+* release all dictionaries, pool threads are stopped first
+*/
+void SmkyExtraLocales::_clean (void)
+{
+    if (mp_pool)
+    {
+        g_thread_pool_free(mp_pool, FALSE, TRUE);
+        mp_pool = NULL;
+    }
+
+    for (std::vector<Locale*>::iterator it = m_locales.begin(); it != m_locales.end(); ++it)
+    {
+        for (size_t i = 0; i < (*it)->dbs.size(); ++i)
+            delete (*it)->dbs[i];
+
+        g_mutex_clear(&(*it)->mutex);
+        g_cond_clear(&(*it)->released);
+        delete *it;
+    }
+
+    m_locales.clear();
+}
+
+/**
+* load hunspell dictionaries of the locales, locales without a dictionary are skipped
+*
+* @param i_list
+*   comma separated list of locales ("en_us") or languages ("en") with optional weight (1-100) of their guesses ("en_us:70")
+*
+* @param i_current
+*   settings of the current locale (keyboard layout is used by all locales)
+*/
+void SmkyExtraLocales::load (const std::string& i_list, const LocaleSettings& i_current)
+{
+    _clean();
+
+    size_t start = 0;
+    while (start <= i_list.length())
+    {
+        size_t end = i_list.find(',', start);
+        if (end == std::string::npos)
+            end = i_list.length();
+
+        std::string item = i_list.substr(start, end - start);
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+
+        start = end + 1;
+
+        if (item.empty())
+            continue;
+
+        int weight = DEFAULT_WEIGHT;
+        size_t colon = item.find(':');
+        if (colon != std::string::npos)
+        {
+            weight = std::min(std::max(atoi(item.c_str() + colon + 1), 1), (int)PRIMARY_WEIGHT);
+            item.erase(colon);
+        }
+
+        LocaleSettings settings = i_current;
+        size_t underscore = item.find('_');
+        settings.m_inputLanguage = item.substr(0, underscore);
+        settings.m_deviceCountry = (underscore != std::string::npos) ? item.substr(underscore + 1) : "";
+
+        SmkyHunspellDatabase* p_db = new SmkyHunspellDatabase(settings);
+        if (!p_db->isLoaded())
+        {
+            g_warning("ExtraLocales: there is no dictionary for '%s'", item.c_str());
+            delete p_db;
+            continue;
+        }
+
+        Locale* p_locale = new Locale;
+        p_locale->name = item;
+        p_locale->language = settings.m_inputLanguage;
+        p_locale->weight = weight;
+        p_locale->settings = settings;
+        p_locale->dbs.push_back(p_db);
+        p_locale->idle.push_back(p_db);
+        p_locale->loading = 0;
+        p_locale->maxCopies = std::max(Settings::getInstance()->workerThreads, 1);
+        g_mutex_init(&p_locale->mutex);
+        g_cond_init(&p_locale->released);
+
+        m_locales.push_back(p_locale);
+
+        g_message("ExtraLocales: words are checked also in '%s' (weight %d)", item.c_str(), weight);
+    }
+
+    if (m_locales.empty())
+        return;
+
+    //one thread per locale for every worker thread, so guesses of all locales are found at once
+    //and searches of concurrent requests don't queue behind each other
+    int threads = m_locales.size() * std::max(Settings::getInstance()->workerThreads, 1);
+    GError* p_error = NULL;
+    mp_pool = g_thread_pool_new(_run, NULL, threads, TRUE, &p_error);
+
+    if (!mp_pool)
+    {
+        g_warning("ExtraLocales: failed to start threads (%s), guesses are found one locale after another", p_error ? p_error->message : "unknown error");
+        if (p_error)
+            g_error_free(p_error);
+    }
+}
+
+/**
+* is word accepted by any extra locale? Locales are checked in order, the first one accepting the word ends the check.
+*
+* @param i_word
+*   word to check
+*
+* @param i_skipLanguage
+*   language of the current locale (it was checked already)
+*
+* @return bool
+*   true if word is good in any locale
+*/
+bool SmkyExtraLocales::findEntry (const std::string& i_word, const std::string& i_skipLanguage)
+{
+    for (std::vector<Locale*>::iterator it = m_locales.begin(); it != m_locales.end(); ++it)
+    {
+        Locale* p_locale = *it;
+
+        if (g_ascii_strcasecmp(p_locale->language.c_str(), i_skipLanguage.c_str()) == 0)
+            continue;
+
+        SmkyHunspellDatabase* p_db = _acquire(p_locale);
+        bool found = p_db->findEntry(i_word);
+        _release(p_locale, p_db);
+
+        if (found)
+        {
+            g_debug("ExtraLocales: '%s' accepted by '%s'", i_word.c_str(), p_locale->name.c_str());
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+/**
+* start finding guesses of the word in extra locales, pool threads find them while caller
+* finds guesses of the current locale, finishGuesses() must be called for every search
+*
+* @param i_word
+*   misspelled word
+*
+* @param i_maxGuesses
+*   limit number of guesses of every locale
+*
+* @param i_deadline
+*   time budget of the request, must outlive the search
+*
+* @param i_rankByKeys
+*   weight edit cost of guesses by keyboard distance
+*
+* @param i_skipLanguage
+*   language of the current locale
+*
+* @return Search*
+*   search in progress
+*/
+SmkyExtraLocales::Search* SmkyExtraLocales::startGuesses (const std::string& i_word, int i_maxGuesses, const SmkyDeadline& i_deadline, bool i_rankByKeys, const std::string& i_skipLanguage)
+{
+    Search* p_search = new Search;
+    p_search->word = i_word;
+    p_search->maxGuesses = i_maxGuesses;
+    p_search->deadline = &i_deadline;
+    p_search->rankByKeys = i_rankByKeys;
+    g_mutex_init(&p_search->mutex);
+    g_cond_init(&p_search->done);
+
+    //tasks are not moved after they are queued
+    for (std::vector<Locale*>::iterator it = m_locales.begin(); it != m_locales.end(); ++it)
+    {
+        if (g_ascii_strcasecmp((*it)->language.c_str(), i_skipLanguage.c_str()) == 0)
+            continue;
+
+        Task task;
+        task.search = p_search;
+        task.locale = *it;
+        p_search->tasks.push_back(task);
+    }
+
+    p_search->pending = p_search->tasks.size();
+
+    for (size_t i = 0; i < p_search->tasks.size(); ++i)
+    {
+        if (!mp_pool || !g_thread_pool_push(mp_pool, &p_search->tasks[i], NULL))
+            _run(&p_search->tasks[i], NULL);
+    }
+
+    return(p_search);
+}
+
+/**
+* wait for guesses of extra locales and merge them with guesses of the current locale:
+* guess is scored by weight of its locale divided by its position, duplicates are skipped
+* and only the best merged guess is auto accepted
+*
+* @param ip_search
+*   search started by startGuesses(), it is released
+*
+* @param io_result
+*   guesses of the current locale, output: merged guesses
+*
+* @param i_maxGuesses
+*   limit number of merged guesses
+*/
+void SmkyExtraLocales::finishGuesses (Search* ip_search, SpellCheckWordInfo& io_result, int i_maxGuesses)
+{
+    if (!ip_search)
+        return;
+
+    g_mutex_lock(&ip_search->mutex);
+    while (ip_search->pending > 0)
+        g_cond_wait(&ip_search->done, &ip_search->mutex);
+    g_mutex_unlock(&ip_search->mutex);
+
+    std::vector<WordGuess> primary;
+    primary.swap(io_result.guesses);
+
+    std::vector<ScoredGuess> scored;
+    add_scored_guesses(primary, PRIMARY_WEIGHT, scored);
+
+    for (size_t i = 0; i < ip_search->tasks.size(); ++i)
+    {
+        const Task& task = ip_search->tasks[i];
+
+        add_scored_guesses(task.result.guesses, task.locale->weight, scored);
+        io_result.partial = io_result.partial || task.result.partial;
+    }
+
+    std::stable_sort(scored.begin(), scored.end(), compare_scored_guess);
+
+    std::set<std::string> unique;
+    for (size_t i = 0; i < scored.size() && (int)io_result.guesses.size() < i_maxGuesses; ++i)
+    {
+        if (!unique.insert(scored[i].guess->guess).second)
+            continue;
+
+        WordGuess guess = *scored[i].guess;
+        guess.autoAccept = guess.autoAccept && io_result.guesses.empty();
+        io_result.guesses.push_back(guess);
+    }
+
+    g_mutex_clear(&ip_search->mutex);
+    g_cond_clear(&ip_search->done);
+    delete ip_search;
+}
+
+/**
+* find guesses of the task in its locale, nothing is searched if the request ran out of time
+* while the task was queued
+*
+* @param io_task
+*   task, output: task.result
+*/
+void SmkyExtraLocales::_findGuesses (Task& io_task)
+{
+    Search* p_search = io_task.search;
+    Locale* p_locale = io_task.locale;
+
+    io_task.result.clear();
+
+    if (p_search->deadline->isExpired())
+    {
+        io_task.result.partial = true;
+        return;
+    }
+
+    SmkyHunspellDatabase* p_db = _acquire(p_locale);
+    p_db->findGuesses(p_search->word, io_task.result, p_search->maxGuesses, *p_search->deadline, p_search->rankByKeys);
+    _release(p_locale, p_db);
+}
+
+/**
+* take idle copy of the dictionary of the locale, a new copy is loaded (without the lock)
+* if all of them are used by other threads, or the thread waits for one if there are
+* Locale::maxCopies of them already
+*
+* @param ip_locale
+*   locale
+*
+* @return SmkyHunspellDatabase*
+*   copy used only by calling thread until _release()
+*/
+SmkyHunspellDatabase* SmkyExtraLocales::_acquire (Locale* ip_locale)
+{
+    g_mutex_lock(&ip_locale->mutex);
+
+    while (ip_locale->idle.empty() && ip_locale->dbs.size() + ip_locale->loading >= ip_locale->maxCopies)
+        g_cond_wait(&ip_locale->released, &ip_locale->mutex);
+
+    if (!ip_locale->idle.empty())
+    {
+        SmkyHunspellDatabase* p_db = ip_locale->idle.back();
+        ip_locale->idle.pop_back();
+        g_mutex_unlock(&ip_locale->mutex);
+        return(p_db);
+    }
+
+    LocaleSettings settings = ip_locale->settings;
+    ip_locale->loading++;
+    g_mutex_unlock(&ip_locale->mutex);
+
+    g_debug("ExtraLocales: loading another copy of '%s'", ip_locale->name.c_str());
+    SmkyHunspellDatabase* p_db = new SmkyHunspellDatabase(settings);
+
+    g_mutex_lock(&ip_locale->mutex);
+    ip_locale->loading--;
+    ip_locale->dbs.push_back(p_db);
+    g_mutex_unlock(&ip_locale->mutex);
+
+    return(p_db);
+}
+
+/**
+* give the copy taken by _acquire() back to idle ones, a thread waiting for it is woken up
+*
+* @param ip_locale
+*   locale
+*
+* @param ip_db
+*   copy of the dictionary
+*/
+void SmkyExtraLocales::_release (Locale* ip_locale, SmkyHunspellDatabase* ip_db)
+{
+    g_mutex_lock(&ip_locale->mutex);
+    ip_locale->idle.push_back(ip_db);
+    g_cond_signal(&ip_locale->released);
+    g_mutex_unlock(&ip_locale->mutex);
+}
+
+/**
+* run task, the last one of the search wakes up the caller
+*
+* @param ip_data
+*   Task
+*
+* @param ip_userData
+*   not used
+*/
+void SmkyExtraLocales::_run (gpointer ip_data, gpointer ip_userData)
+{
+    Task* p_task = static_cast<Task*>(ip_data);
+    Search* p_search = p_task->search;
+
+    _findGuesses(*p_task);
+
+    g_mutex_lock(&p_search->mutex);
+    if (--p_search->pending == 0)
+        g_cond_signal(&p_search->done);
+    g_mutex_unlock(&p_search->mutex);
+}
+
+/**
+* append memory usage and load time of dictionaries, names are suffixed with the locale ("hunspell-en_us").
+* Statistics of the first copy are reported, they only read sizes, so the copy may be in use meanwhile.
+*
+* @param o_stats
+*   output: statistics are appended
+*/
+void SmkyExtraLocales::getStats (std::vector<DictionaryStats>& o_stats)
+{
+    for (std::vector<Locale*>::iterator it = m_locales.begin(); it != m_locales.end(); ++it)
+    {
+        size_t first = o_stats.size();
+
+        g_mutex_lock(&(*it)->mutex);
+        (*it)->dbs[0]->getStats(o_stats);
+        g_mutex_unlock(&(*it)->mutex);
+
+        for (size_t i = first; i < o_stats.size(); ++i)
+            o_stats[i].name += "-" + (*it)->name;
+    }
+}
+
+/**
+* use keyboard layout of the current locale for ranking guesses of all locales, dictionaries are not reloaded.
+* Caller holds the exclusive lock of the engine, so no copy is in use.
+*
+* @param i_layout
+*   name of the layout
+*/
+void SmkyExtraLocales::setKeyboardLayout (const std::string& i_layout)
+{
+    for (std::vector<Locale*>::iterator it = m_locales.begin(); it != m_locales.end(); ++it)
+    {
+        Locale* p_locale = *it;
+
+        g_mutex_lock(&p_locale->mutex);
+
+        if (p_locale->settings.m_keyboardLayout != i_layout)
+        {
+            p_locale->settings.m_keyboardLayout = i_layout;
+
+            for (size_t i = 0; i < p_locale->dbs.size(); ++i)
+                p_locale->dbs[i]->setKeyboardLayout(i_layout);
+        }
+
+        g_mutex_unlock(&p_locale->mutex);
+    }
+}
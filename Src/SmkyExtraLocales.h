@@ -0,0 +1,139 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef SMKY_EXTRA_LOCALES_H
+#define SMKY_EXTRA_LOCALES_H
+
+#include <string>
+#include <vector>
+#include <glib.h>
+#include "Database.h"
+#include "Settings.h"
+#include "SmkyDeadline.h"
+#include "SmkyHunspellDatabase.h"
+#include "SpellCheckClient.h"
+
+namespace SmartKey
+{
+
+/**
+ * Hunspell dictionaries of locales checked in addition to the current one (multi-language mode),
+ * e.g. English technical terms typed by a Hungarian user. A word is good if any locale accepts it,
+ * guesses of misspelled words are found in all locales in parallel and merged by weights of the locales.
+ * Hunspell instance can't be used by several threads at once, so a thread takes an idle copy of the dictionary
+ * and gives it back when done; another copy is loaded only if all of them are in use, up to one copy
+ * per worker thread (each request uses one copy of a locale at once), so requests don't wait for each other.
+ */
+class SmkyExtraLocales
+{
+public:
+    enum
+    {
+        PRIMARY_WEIGHT = 100    ///< Weight of guesses of the current locale.
+        ,DEFAULT_WEIGHT = 50    ///< Weight of guesses of extra locale without explicit weight.
+    };
+
+    //guesses being found in extra locales (see startGuesses())
+    struct Search;
+
+private:
+    struct Locale
+    {
+        std::string                        name;
+        std::string                        language;
+        int                                weight;
+        LocaleSettings                     settings;   ///< Settings of loaded copies.
+        std::vector<SmkyHunspellDatabase*> dbs;        ///< All loaded copies.
+        std::vector<SmkyHunspellDatabase*> idle;       ///< Copies not used by any thread.
+        size_t                             loading;    ///< Copies being loaded.
+        size_t                             maxCopies;  ///< Limit of loaded copies.
+        GMutex                             mutex;      ///< Guards the lists, it isn't held while a copy is used.
+        GCond                              released;   ///< Signalled when a copy becomes idle.
+    };
+
+    struct Task
+    {
+        Search*               search;
+        Locale*               locale;
+        SpellCheckWordInfo    result;
+    };
+
+    //checked in this order after the current locale
+    std::vector<Locale*> m_locales;
+
+    //threads finding guesses of extra locales
+    GThreadPool* mp_pool;
+
+public:
+
+    SmkyExtraLocales (void);
+    virtual ~SmkyExtraLocales (void);
+
+    //load dictionaries of the list of locales ("hu_hu:70,en"), keyboard layout is taken from i_current
+    void load (const std::string& i_list, const LocaleSettings& i_current);
+
+    //are there any extra locales?
+    bool isEmpty (void) const;
+
+    //is word accepted by any extra locale? (locales of i_skipLanguage are skipped, checking stops at the first one accepting it)
+    bool findEntry (const std::string& i_word, const std::string& i_skipLanguage);
+
+    //start finding guesses in extra locales (except of i_skipLanguage) in parallel, deadline must outlive the search
+    Search* startGuesses (const std::string& i_word, int i_maxGuesses, const SmkyDeadline& i_deadline, bool i_rankByKeys, const std::string& i_skipLanguage);
+
+    //wait for guesses of the search and merge them with guesses of the current locale
+    void finishGuesses (Search* ip_search, SpellCheckWordInfo& io_result, int i_maxGuesses);
+
+    //append memory usage and load time of dictionaries ("hunspell-<locale>", ...)
+    void getStats (std::vector<DictionaryStats>& o_stats);
+
+    //use keyboard layout of the current locale (no search may run meanwhile)
+    void setKeyboardLayout (const std::string& i_layout);
+
+private:
+    //release all dictionaries
+    void _clean (void);
+
+    //find guesses of the task (any thread)
+    static void _findGuesses (Task& io_task);
+
+    //take idle copy of the dictionary of the locale, load a new one or wait for one
+    static SmkyHunspellDatabase* _acquire (Locale* ip_locale);
+
+    //give the copy back to idle ones
+    static void _release (Locale* ip_locale, SmkyHunspellDatabase* ip_db);
+
+    //run task in pool thread
+    static void _run (gpointer ip_data, gpointer ip_userData);
+
+    SmkyExtraLocales (const SmkyExtraLocales&);     // don't implement
+    void operator= (const SmkyExtraLocales&);       // don't implement
+};
+
+/**
+* are there any extra locales?
+*/
+inline bool SmkyExtraLocales::isEmpty (void) const
+{
+    return(m_locales.empty());
+}
+
+}
+
+#endif
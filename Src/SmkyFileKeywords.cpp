@@ -18,6 +18,8 @@
 
 #include "SmkyFileKeywords.h"
 #include <glib.h>
+#include "Database.h"
+#include "SmkyJournal.h"
 #include <fstream>
 
 #if 0 // Debug settings
@@ -36,6 +38,9 @@ SmkyFileKeywords::SmkyFileKeywords()
 {
     m_initialized = false;
     m_changed = false;
+    m_journal_size = 0;
+    m_load_ms = 0;
+    m_keys_moved = true;
 }
 
 /**
@@ -55,12 +60,26 @@ void SmkyFileKeywords::_clean (void)
     if (!m_dictionary.empty())
     {
         g_debug("FileKeywordsDB: going to release current dictionary..");
-        m_dictionary.clear();
+        m_prefix_index.clear();
         g_debug("FileKeywordsDB: done, no dictionaries");
     }
 
+    //also releases keys of erased entries
+    m_dictionary.clear();
+
+    m_compiled.close();
+
     m_initialized = false;
     m_changed = false;
+
+    m_journal.clear();
+    m_journal_size = 0;
+    m_journal_file.clear();
+
+    m_added_keys.clear();
+    m_keys_moved = true;
+
+    changeDictionaryGeneration();
 }
 
 /**
@@ -77,10 +96,15 @@ void SmkyFileKeywords::_importFileDB (std::string i_db_file)
     {
         std::string line;
 
+        //all words of the file are stored in one block
+        fin.seekg(0, std::ios::end);
+        m_dictionary.reserveStorage((size_t)fin.tellg() + 1);
+        fin.seekg(0, std::ios::beg);
+
         while ( !fin.eof() )
         {
             getline(fin, line);
-            m_dictionary.insert( line );
+            _insert( line );
         }
     }
     else
@@ -102,34 +126,51 @@ bool SmkyFileKeywords::load (string i_locale_path_file)
         return(false);
     }
 
+    gint64 start = g_get_monotonic_time();
+
     _clean();
 
-    if ( g_file_test( i_locale_path_file.c_str(), G_FILE_TEST_EXISTS ) )
+    std::string compiled_file = SmkyCompiledDictionary::getCompiledPath(i_locale_path_file);
+
+    //image of pairs (stale or misplaced) is not a keyword list, text file is loaded instead
+    if ( SmkyCompiledDictionary::isFresh( i_locale_path_file, compiled_file ) && m_compiled.open( compiled_file ) && !m_compiled.hasValues() )
+    {
+        g_debug("FileKeywordsDB: using compiled dictionary for locale");
+    }
+    else
     {
-        g_debug("FileKeywordsDB: going to load dictionary for locale");
-        _importFileDB( i_locale_path_file );
+        m_compiled.close();
+
+        if ( g_file_test( i_locale_path_file.c_str(), G_FILE_TEST_EXISTS ) )
+        {
+            g_debug("FileKeywordsDB: going to load dictionary for locale");
+            _importFileDB( i_locale_path_file );
+        }
     }
 
-    m_initialized = !m_dictionary.empty();
+    _replayJournal( i_locale_path_file );
+
+    m_initialized = !m_dictionary.empty() || m_compiled.size() > 0;
 
     if (m_initialized)
     {
         g_debug("FileKeywordsDB: dictionary was loaded successfuly.");
     }
 
+    m_load_ms = (g_get_monotonic_time() - start) / 1000.0;
+
     return(m_initialized);
 }
 
 /**
-* save dictionary to file
+* save dictionary to file: changes are appended to the journal,
+* the file is rewritten (and the journal removed) only when the journal grows too long
 *
 * @return bool
 *   true if saved
 */
 bool SmkyFileKeywords::save (std::string i_db_file)
 {
-    bool retval = false;
-
     if(i_db_file.length() == 0)
     {
         return(false);
@@ -140,21 +181,180 @@ bool SmkyFileKeywords::save (std::string i_db_file)
         return(true);
     }
 
-    if ( !m_dictionary.empty() )
+    if ( i_db_file == m_journal_file
+         && m_journal_size + m_journal.size() < SmkyJournal::COMPACT_RECORDS
+         && g_file_test( i_db_file.c_str(), G_FILE_TEST_EXISTS )
+         && SmkyJournal::append( i_db_file, m_journal ) )
+    {
+        m_journal_size += m_journal.size();
+    }
+    else
+    {
+        g_debug("FileKeywordsDB: compacting dictionary, %u journal records", (unsigned int)(m_journal_size + m_journal.size()));
+
+        if ( !_writeSnapshot( i_db_file ) )
+        {
+            return(false);
+        }
+
+        SmkyJournal::remove( i_db_file );
+        m_journal_size = 0;
+        m_journal_file = i_db_file;
+    }
+
+    m_journal.clear();
+    m_changed = false;
+
+    return(true);
+}
+
+/**
+* write all words to the file
+*
+* @param i_db_file
+*   = path + filename
+*
+* @return bool
+*   true if written
+*/
+bool SmkyFileKeywords::_writeSnapshot (const std::string& i_db_file)
+{
+    SmkyHashSet::const_iterator it;
+    std::string data;
+
+    //whole file is written with a single write
+    for ( it = m_dictionary.begin(); it != m_dictionary.end(); ++it )
     {
-        SmkyHashSet::iterator it;
+        data.append( it->key, it->length );
+        data += '\n';
+    }
 
-        std::fstream file(i_db_file.c_str(), std::ios::out);
+    return( SmkyJournal::writeSnapshot( i_db_file, data ) );
+}
 
-        for ( it = m_dictionary.begin(); it != m_dictionary.end(); ++it )
+/**
+* apply journal records on top of the loaded dictionary
+*
+* @param i_db_file
+*   = path + filename
+*/
+void SmkyFileKeywords::_replayJournal (const std::string& i_db_file)
+{
+    std::vector<std::string> records;
+
+    m_journal_file = i_db_file;
+
+    if ( !SmkyJournal::read( i_db_file, records ) || records.empty() )
+    {
+        return;
+    }
+
+    g_debug("FileKeywordsDB: replaying %u journal records", (unsigned int)records.size());
+
+    _materialize();
+
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        if (records[i][0] == SmkyJournal::RECORD_ADD)
         {
-            file << *it << std::endl;
+            _insert( records[i].substr(1) );
         }
+        else
+        {
+            _erase( records[i].substr(1) );
+        }
+    }
+
+    m_journal_size = records.size();
+}
+
+/**
+* insert word into dictionary and prefix index
+*
+* @param i_key
+*   word to insert
+*/
+void SmkyFileKeywords::_insert (const std::string& i_key)
+{
+    size_t relocations = m_dictionary.relocations();
+    std::pair<SmkyHashSet::Entry*, bool> res = m_dictionary.insert( i_key.data(), i_key.length(), SmkyNoValue() );
 
-        retval = true;
+    //storage of erased words was compacted, indexed words moved
+    if (m_dictionary.relocations() != relocations)
+    {
+        _reindex();
     }
+    else if (res.second)
+    {
+        m_prefix_index.insert( res.first->key );
+
+        if (!m_keys_moved)
+        {
+            m_added_keys.push_back( res.first->key );
+        }
+    }
+}
+
+/**
+* rebuild prefix index over all words of m_dictionary
+*/
+void SmkyFileKeywords::_reindex (void)
+{
+    m_keys_moved = true;
+
+    m_prefix_index.clear();
 
-    return(retval);
+    for (SmkyHashSet::const_iterator it = m_dictionary.begin(); it != m_dictionary.end(); ++it)
+    {
+        m_prefix_index.insert( it->key );
+    }
+}
+
+/**
+* compiled dictionary is read-only, so copy it into m_dictionary before the first modification
+*/
+void SmkyFileKeywords::_materialize (void)
+{
+    if (m_compiled.isOpen())
+    {
+        //keys of the image are not valid any more
+        m_keys_moved = true;
+
+        m_dictionary.reserve(m_compiled.size());
+
+        for (uint32_t i = 0; i < m_compiled.size(); ++i)
+        {
+            _insert( m_compiled.keyAt(i) );
+        }
+
+        m_compiled.close();
+    }
+}
+
+/**
+* erase word from dictionary and prefix index
+*
+* @param i_key
+*   word to erase
+*
+* @return bool
+*   true if erased
+*/
+bool SmkyFileKeywords::_erase (const std::string& i_key)
+{
+    SmkyHashSet::Entry* p_entry = m_dictionary.find( i_key.data(), i_key.length() );
+
+    if (!p_entry)
+    {
+        return(false);
+    }
+
+    m_prefix_index.erase( p_entry->key );
+    m_dictionary.erase( p_entry );
+
+    m_keys_moved = true;
+
+    return(true);
 }
 
 /**
@@ -162,8 +362,17 @@ bool SmkyFileKeywords::save (std::string i_db_file)
 */
 void SmkyFileKeywords::add (std::string i_key)
 {
-    m_dictionary.insert( i_key );
+    if ( !SmkyJournal::isValidEntry( i_key ) )
+    {
+        g_warning("SmkyFileKeywords: rejecting word with a line break");
+        return;
+    }
+
+    _materialize();
+    _insert( i_key );
+    m_journal.push_back( SmkyJournal::RECORD_ADD + i_key );
     m_changed = true;
+    changeDictionaryGeneration();
 }
 
 /**
@@ -174,17 +383,14 @@ void SmkyFileKeywords::add (std::string i_key)
 */
 bool SmkyFileKeywords::remove (std::string i_key)
 {
-    if (!m_dictionary.empty())
-    {
-        SmkyHashSet::iterator it;
-        it = m_dictionary.find( i_key );
+    _materialize();
 
-        if (it != m_dictionary.end())
-        {
-            m_dictionary.erase( it );
-            m_changed = true;
-            return(true);
-        }
+    if ( _erase( i_key ) )
+    {
+        m_journal.push_back( SmkyJournal::RECORD_REMOVE + i_key );
+        m_changed = true;
+        changeDictionaryGeneration();
+        return(true);
     }
 
     return(false);
@@ -201,49 +407,59 @@ bool SmkyFileKeywords::remove (std::string i_key)
 */
 bool SmkyFileKeywords::find (const std::string& shortcut)
 {
-    if (!m_dictionary.empty())
+    if (m_compiled.isOpen())
     {
-        SmkyHashSet::iterator it;
-        it = m_dictionary.find(shortcut);
-
-        if (it != m_dictionary.end())
-        {
-            return(true);
-        }
+        return(m_compiled.find(shortcut.c_str()) >= 0);
     }
 
-    return(false);
+    return(m_dictionary.find(shortcut) != NULL);
 }
 
 /**
 * is word with specified prefix exist in dictionary ?
+* lookup is done through the sorted index, so the first word in alphabetical order is returned
 *
-* @param shortcut
-*   key word to search
+* @param prefix
+*   prefix to search
 *
 * @return std::string
-*   word assotiated with prefix word
+*   word starting with prefix
 */
 
 std::string SmkyFileKeywords::find_by_prefix (const std::string& prefix)
 {
-    if (!m_dictionary.empty())
+    if (m_compiled.isOpen())
     {
-        SmkyHashSet::iterator it;
-        std::pair<std::string::const_iterator, std::string::const_iterator> res;
+        const char* p_compiled_word = m_compiled.findKeyByPrefix(prefix);
+        return( p_compiled_word ? p_compiled_word : "" );
+    }
 
-        for (it = m_dictionary.begin(); it != m_dictionary.end(); ++it )
-        {
-            res = std::mismatch(prefix.begin(), prefix.end(), (*it).begin());
+    const char* p_word = m_prefix_index.findFirst(prefix);
 
-            if (res.first == prefix.end())
-            {
-                return(*it);
-            }
-        }
+    return( p_word ? p_word : "" );
+}
+
+/**
+* find words by prefix: one seek in the sorted index and a step per word
+*
+* @param prefix
+*   prefix to search
+*
+* @param max
+*   limit number of words
+*
+* @param o_words
+*   output: found words are appended in sorted order
+*/
+void SmkyFileKeywords::find_all_by_prefix (const std::string& prefix, size_t max, std::list<std::string>& o_words)
+{
+    if (m_compiled.isOpen())
+    {
+        m_compiled.findKeysByPrefix(prefix, max, o_words);
+        return;
     }
 
-    return "";
+    m_prefix_index.findAll(prefix, max, o_words);
 }
 
 /**
@@ -254,14 +470,89 @@ std::string SmkyFileKeywords::find_by_prefix (const std::string& prefix)
 */
 void SmkyFileKeywords::exportToList (std::list<string>& o_entries)
 {
+    for (uint32_t i = 0; i < m_compiled.size(); ++i)
+    {
+        o_entries.push_back(m_compiled.keyAt(i));
+    }
+
     if ( !m_dictionary.empty() )
     {
-        SmkyHashSet::iterator it;
+        SmkyHashSet::const_iterator it;
 
         for ( it = m_dictionary.begin(); it != m_dictionary.end(); ++it )
         {
-            o_entries.push_back(*it);
+            o_entries.push_back(std::string(it->key, it->length));
         }
     }
 }
 
+/**
+* export pointers to all words (no copies), they are valid until the dictionary is changed or reloaded
+*
+* @param o_keys
+*   output: words are appended
+*/
+void SmkyFileKeywords::exportKeys (std::vector<const char*>& o_keys)
+{
+    for (uint32_t i = 0; i < m_compiled.size(); ++i)
+    {
+        o_keys.push_back(m_compiled.keyAt(i));
+    }
+
+    SmkyHashSet::const_iterator it;
+
+    for ( it = m_dictionary.begin(); it != m_dictionary.end(); ++it )
+    {
+        o_keys.push_back(it->key);
+    }
+}
+
+/**
+* append keys added since the last call: they extend keys exported before, unless
+* any key was erased or moved meanwhile (e.g. storage was compacted)
+*
+* @param o_keys
+*   output: added keys are appended
+*
+* @return bool
+*   false if keys exported before are stale, all of them must be exported again
+*/
+bool SmkyFileKeywords::takeAddedKeys (std::vector<const char*>& o_keys)
+{
+    bool valid = !m_keys_moved;
+
+    if (valid)
+    {
+        o_keys.insert(o_keys.end(), m_added_keys.begin(), m_added_keys.end());
+    }
+
+    m_added_keys.clear();
+    m_keys_moved = false;
+
+    return(valid);
+}
+
+/**
+* get memory usage and load time of the dictionary, words of compiled dictionary
+* are counted as mapped (or as overhead when the image was built in memory)
+*
+* @param o_stats
+*   output: statistics, name is not changed
+*/
+void SmkyFileKeywords::getStats (DictionaryStats& o_stats) const
+{
+    o_stats.entries = m_compiled.size() + m_dictionary.size();
+    o_stats.keyBytes = 0;
+    o_stats.valueBytes = 0;
+
+    SmkyHashSet::const_iterator it;
+
+    for ( it = m_dictionary.begin(); it != m_dictionary.end(); ++it )
+    {
+        o_stats.keyBytes += it->length + 1;
+    }
+
+    o_stats.overheadBytes = m_dictionary.memoryUsed() - o_stats.keyBytes + m_prefix_index.memoryUsed() + m_compiled.memoryUsed();
+    o_stats.mappedBytes = m_compiled.mappedSize();
+    o_stats.loadMs = m_load_ms;
+}
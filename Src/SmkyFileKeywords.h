@@ -22,12 +22,17 @@
 #include <ext/hash_set> //I know about replacement to <unordered_set>, but not sure yet about c++11 support for this project
 #include <string>
 #include <list>
+#include <vector>
+#include "Database.h"
+#include "SmkyFlatTable.h"
+#include "SmkyPrefixIndex.h"
+#include "SmkyCompiledDictionary.h"
 
 namespace SmartKey
 {
 using namespace __gnu_cxx;
 
-#define SmkyHashSet hash_set<std::string, SmkyHasher, SmkyComparator>
+#define SmkyHashSet SmkyFlatTable<SmkyNoValue>
 
 class SmkyHasher
 {
@@ -51,7 +56,8 @@ public:
 };
 
 /**
- * Read/write dictionary with words stored into text file (one per line).
+ * Read/write dictionary with words stored into text file (one per line),
+ * changes are appended to the journal of the file (see SmkyJournal).
  */
 class SmkyFileKeywords
 {
@@ -62,6 +68,28 @@ private:
 
     SmkyHashSet m_dictionary;
 
+    //sorted index over m_dictionary for prefix lookups
+    SmkyPrefixIndex m_prefix_index;
+
+    //read-only compiled dictionary, used instead of m_dictionary until the first change
+    SmkyCompiledDictionary m_compiled;
+
+    //changes not saved yet (see SmkyJournal)
+    std::vector<std::string> m_journal;
+
+    //number of records in journal file of m_journal_file
+    size_t m_journal_size;
+    std::string m_journal_file;
+
+    //duration of the last load (ms)
+    double m_load_ms;
+
+    //keys added since the last takeAddedKeys(), not collected while m_keys_moved is set
+    std::vector<const char*> m_added_keys;
+
+    //keys were erased or moved since the last takeAddedKeys(), exported pointers are stale
+    bool m_keys_moved;
+
 public:
 
     SmkyFileKeywords (void);
@@ -91,9 +119,21 @@ public:
     //find by prefix
     virtual std::string find_by_prefix (const std::string& prefix);
 
+    //find up to max words by prefix (in sorted order), append them to o_words
+    virtual void find_all_by_prefix (const std::string& prefix, size_t max, std::list<std::string>& o_words);
+
     //export all strings from the dictionary to list
     virtual void exportToList (std::list<std::string>& o_entries);
 
+    //export pointers to all strings, they are valid until the dictionary is changed
+    void exportKeys (std::vector<const char*>& o_keys);
+
+    //append keys added since the last call, return false if exported keys became stale meanwhile (export all again)
+    bool takeAddedKeys (std::vector<const char*>& o_keys);
+
+    //get memory usage and load time (name is not set)
+    void getStats (DictionaryStats& o_stats) const;
+
 protected:
     //release all allocated objects
     void _clean (void);
@@ -101,6 +141,24 @@ protected:
     //read pairs from text file and add them to m_dictionary
     void _importFileDB (std::string i_db_file);
 
+    //insert word into m_dictionary and m_prefix_index
+    void _insert (const std::string& i_key);
+
+    //rebuild m_prefix_index after keys or values of m_dictionary were moved
+    void _reindex (void);
+
+    //erase word from m_dictionary and m_prefix_index
+    bool _erase (const std::string& i_key);
+
+    //apply journal of the dictionary file
+    void _replayJournal (const std::string& i_db_file);
+
+    //write all words to the dictionary file
+    bool _writeSnapshot (const std::string& i_db_file);
+
+    //copy compiled dictionary into m_dictionary before modification
+    void _materialize (void);
+
 };
 
 /**
@@ -116,6 +174,9 @@ inline bool SmkyFileKeywords::isInitialized (void)
 */
 inline int SmkyFileKeywords::size (void)
 {
+    if (m_compiled.isOpen())
+        return m_compiled.size();
+
     return m_dictionary.empty() ? 0 : m_dictionary.size();
 }
 
@@ -18,6 +18,7 @@
 
 #include "SmkyFilePairs.h"
 #include <glib.h>
+#include "SmkyJournal.h"
 #include <fstream>
 #include <boost/tokenizer.hpp>
 
@@ -39,6 +40,9 @@ SmkyFilePairs::SmkyFilePairs()
 {
     m_initialized = false;
     m_changed = false;
+    m_journal_size = 0;
+    m_load_ms = 0;
+    m_keys_moved = true;
 }
 
 /**
@@ -58,12 +62,26 @@ void SmkyFilePairs::_clean (void)
     if (!m_dictionary.empty())
     {
         g_debug("FilePairsDB: going to release current dictionary..");
-        m_dictionary.clear();
+        m_prefix_index.clear();
         g_debug("FilePairsDB: done, no dictionaries");
     }
 
+    //also releases keys of erased entries
+    m_dictionary.clear();
+
+    m_compiled.close();
+
     m_initialized = false;
     m_changed = false;
+
+    m_journal.clear();
+    m_journal_size = 0;
+    m_journal_file.clear();
+
+    m_added_keys.clear();
+    m_keys_moved = true;
+
+    changeDictionaryGeneration();
 }
 
 /**
@@ -83,6 +101,11 @@ void SmkyFilePairs::_importFileDB (std::string i_db_file)
         std::string line;
         std::string key;
 
+        //all words of the file are stored in one block
+        fin.seekg(0, std::ios::end);
+        m_dictionary.reserveStorage((size_t)fin.tellg() + 1);
+        fin.seekg(0, std::ios::beg);
+
         while ( !fin.eof() )
         {
             getline(fin, line);
@@ -97,7 +120,7 @@ void SmkyFilePairs::_importFileDB (std::string i_db_file)
 
             if (tok_iter != tokens.end())
             {
-                m_dictionary.insert( std::pair<std::string,std::string>(key, *tok_iter) );
+                _insert(key, *tok_iter);
             }
         }
     }
@@ -120,27 +143,46 @@ bool SmkyFilePairs::load (string i_locale_path_file)
         return(false);
     }
 
+    gint64 start = g_get_monotonic_time();
+
     _clean();
 
-    if ( g_file_test(i_locale_path_file.c_str(), G_FILE_TEST_EXISTS) )
+    std::string compiled_file = SmkyCompiledDictionary::getCompiledPath(i_locale_path_file);
+
+    if ( SmkyCompiledDictionary::isFresh(i_locale_path_file, compiled_file) && m_compiled.open(compiled_file) && m_compiled.hasValues() )
     {
-        g_debug("FilePairsDB: going to load dictionary for locale");
-        _importFileDB(i_locale_path_file);
+        g_debug("FilePairsDB: using compiled dictionary for locale");
     }
+    else
+    {
+        m_compiled.close();
 
-    m_initialized = !m_dictionary.empty();
+        if ( g_file_test(i_locale_path_file.c_str(), G_FILE_TEST_EXISTS) )
+        {
+            g_debug("FilePairsDB: going to load dictionary for locale");
+            _importFileDB(i_locale_path_file);
+        }
+    }
+
+    _replayJournal(i_locale_path_file);
+
+    m_initialized = !m_dictionary.empty() || m_compiled.size() > 0;
 
     if (m_initialized)
     {
         g_debug("FilePairsDB: dictionary was loaded successfuly.");
     }
 
+    m_load_ms = (g_get_monotonic_time() - start) / 1000.0;
+
     return(m_initialized);
 }
 
 /**
 * save dictionary to the file,
-* word pairs are saved in text mode and separated with symbol '|'
+* word pairs are saved in text mode and separated with symbol '|',
+* changes are appended to the journal, the file is rewritten (and the journal removed)
+* only when the journal grows too long
 *
 * @return bool
 *   true if saved
@@ -152,17 +194,209 @@ bool SmkyFilePairs::save (std::string i_db_file)
         return(false);
     }
 
-    if ( m_changed && (!m_dictionary.empty()) )
+    if (!m_changed)
+    {
+        return(true);
+    }
+
+    if ( i_db_file == m_journal_file
+         && m_journal_size + m_journal.size() < SmkyJournal::COMPACT_RECORDS
+         && g_file_test(i_db_file.c_str(), G_FILE_TEST_EXISTS)
+         && SmkyJournal::append(i_db_file, m_journal) )
+    {
+        m_journal_size += m_journal.size();
+    }
+    else
+    {
+        g_debug("FilePairsDB: compacting dictionary, %u journal records", (unsigned int)(m_journal_size + m_journal.size()));
+
+        if (!_writeSnapshot(i_db_file))
+        {
+            return(false);
+        }
+
+        SmkyJournal::remove(i_db_file);
+        m_journal_size = 0;
+        m_journal_file = i_db_file;
+    }
+
+    m_journal.clear();
+    m_changed = false;
+
+    return(true);
+}
+
+/**
+* write all pairs to the file
+*
+* @param i_db_file
+*   = path + filename to db
+*
+* @return bool
+*   true if written
+*/
+bool SmkyFilePairs::_writeSnapshot (const std::string& i_db_file)
+{
+    SmkyHashMap::const_iterator it;
+    std::string data;
+
+    //whole file is written with a single write
+    for ( it = m_dictionary.begin(); it != m_dictionary.end(); ++it )
+    {
+        data.append(it->key, it->length);
+        data += '|';
+        data += it->value;
+        data += '\n';
+    }
+
+    return(SmkyJournal::writeSnapshot(i_db_file, data));
+}
+
+/**
+* apply journal records on top of the loaded dictionary,
+* added pairs are stored as 'key|value', removed pairs as key only
+*
+* @param i_db_file
+*   = path + filename to db
+*/
+void SmkyFilePairs::_replayJournal (const std::string& i_db_file)
+{
+    std::vector<std::string> records;
+
+    m_journal_file = i_db_file;
+
+    if (!SmkyJournal::read(i_db_file, records) || records.empty())
+    {
+        return;
+    }
+
+    g_debug("FilePairsDB: replaying %u journal records", (unsigned int)records.size());
+
+    _materialize();
+
+    boost::char_separator<char> sep("|");
+
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        std::string entry = records[i].substr(1);
+
+        if (records[i][0] == SmkyJournal::RECORD_REMOVE)
+        {
+            _erase(entry);
+            continue;
+        }
+
+        tokenizer tokens(entry, sep);
+        tokenizer::iterator tok_iter = tokens.begin();
+
+        if (tok_iter == tokens.end())
+            continue;
+
+        std::string key = *tok_iter;
+        ++tok_iter;
+
+        if (tok_iter != tokens.end())
+        {
+            _insert(key, *tok_iter);
+        }
+    }
+
+    m_journal_size = records.size();
+}
+
+/**
+* insert pair into dictionary and index its value
+*
+* @param i_key
+*   key word to search
+*
+* @param i_value
+*   value word
+*/
+void SmkyFilePairs::_insert (const std::string& i_key, const std::string& i_value)
+{
+    size_t relocations = m_dictionary.relocations();
+    std::pair<SmkyHashMap::Entry*, bool> res = m_dictionary.insert( i_key.data(), i_key.length(), NULL );
+
+    if (res.second)
+    {
+        res.first->value = m_dictionary.store( i_value.data(), i_value.length() );
+    }
+
+    //storage of erased pairs was compacted, indexed values moved
+    if (m_dictionary.relocations() != relocations)
+    {
+        _reindex();
+    }
+    else if (res.second)
+    {
+        m_prefix_index.insert( res.first->value );
+
+        if (!m_keys_moved)
+        {
+            m_added_keys.push_back( res.first->key );
+        }
+    }
+}
+
+/**
+* rebuild prefix index over all values of m_dictionary
+*/
+void SmkyFilePairs::_reindex (void)
+{
+    m_keys_moved = true;
+
+    m_prefix_index.clear();
+
+    for (SmkyHashMap::const_iterator it = m_dictionary.begin(); it != m_dictionary.end(); ++it)
+    {
+        m_prefix_index.insert( it->value );
+    }
+}
+
+/**
+* compiled dictionary is read-only, so copy it into m_dictionary before the first modification
+*/
+void SmkyFilePairs::_materialize (void)
+{
+    if (m_compiled.isOpen())
     {
-        SmkyHashMap::iterator it;
+        //keys of the image are not valid any more
+        m_keys_moved = true;
 
-        std::fstream file(i_db_file.c_str(), std::ios::out);
+        m_dictionary.reserve(m_compiled.size());
 
-        for ( it = m_dictionary.begin(); it != m_dictionary.end(); ++it )
+        for (uint32_t i = 0; i < m_compiled.size(); ++i)
         {
-            file << it->first << "|" << it->second << std::endl;
+            _insert(m_compiled.keyAt(i), m_compiled.valueAt(i));
         }
+
+        m_compiled.close();
     }
+}
+
+/**
+* erase pair from dictionary and index of values
+*
+* @param i_key
+*   key word
+*
+* @return bool
+*   true if erased
+*/
+bool SmkyFilePairs::_erase (const std::string& i_key)
+{
+    SmkyHashMap::Entry* p_entry = m_dictionary.find(i_key.data(), i_key.length());
+
+    if (!p_entry)
+    {
+        return(false);
+    }
+
+    m_prefix_index.erase( p_entry->value );
+    m_dictionary.erase(p_entry);
+
+    m_keys_moved = true;
 
     return(true);
 }
@@ -178,8 +412,17 @@ bool SmkyFilePairs::save (std::string i_db_file)
 */
 void SmkyFilePairs::add (std::string i_key, std::string i_value)
 {
-    m_dictionary.insert( std::pair<std::string,std::string>(i_key, i_value) );
+    if (!SmkyJournal::isValidEntry(i_key) || !SmkyJournal::isValidEntry(i_value))
+    {
+        g_warning("SmkyFilePairs: rejecting pair with a line break");
+        return;
+    }
+
+    _materialize();
+    _insert(i_key, i_value);
+    m_journal.push_back(SmkyJournal::RECORD_ADD + i_key + "|" + i_value);
     m_changed = true;
+    changeDictionaryGeneration();
 }
 
 /**
@@ -190,17 +433,14 @@ void SmkyFilePairs::add (std::string i_key, std::string i_value)
 */
 bool SmkyFilePairs::remove (std::string i_key)
 {
-    if (!m_dictionary.empty())
-    {
-        SmkyHashMap::iterator it;
-        it = m_dictionary.find(i_key);
+    _materialize();
 
-        if (it != m_dictionary.end())
-        {
-            m_dictionary.erase(it);
-            m_changed = true;
-            return(true);
-        }
+    if (_erase(i_key))
+    {
+        m_journal.push_back(SmkyJournal::RECORD_REMOVE + i_key);
+        m_changed = true;
+        changeDictionaryGeneration();
+        return(true);
     }
 
     return(false);
@@ -217,48 +457,61 @@ bool SmkyFilePairs::remove (std::string i_key)
 */
 std::string SmkyFilePairs::find (const std::string& shortcut)
 {
-    if (!m_dictionary.empty())
+    if (m_compiled.isOpen())
     {
-        SmkyHashMap::iterator it;
-        it = m_dictionary.find(shortcut);
-
-        if (it != m_dictionary.end())
-        {
-            return(it->second);
-        }
+        int index = m_compiled.find(shortcut.c_str());
+        return( index >= 0 ? m_compiled.valueAt(index) : "" );
     }
 
-    return "";
+    const SmkyHashMap::Entry* p_entry = m_dictionary.find(shortcut);
+
+    return( p_entry ? p_entry->value : "" );
 }
 
 /**
 * is word with specified prefix exist in dictionary ?
+* lookup is done through the sorted index of values, so the first value in alphabetical order is returned
 *
-* @param shortcut
-*   key word to search
+* @param prefix
+*   prefix to search
 *
 * @return std::string
-*   word assotiated with prefix word
+*   value word starting with prefix
 */
 std::string SmkyFilePairs::find_by_prefix (const std::string& prefix)
 {
-    if (!m_dictionary.empty())
+    if (m_compiled.isOpen())
     {
-        SmkyHashMap::iterator it;
-        std::pair<std::string::const_iterator, std::string::const_iterator> res;
+        const char* p_compiled_word = m_compiled.findValueByPrefix(prefix);
+        return( p_compiled_word ? p_compiled_word : "" );
+    }
 
-        for (it = m_dictionary.begin(); it != m_dictionary.end(); ++it )
-        {
-            res = std::mismatch(prefix.begin(), prefix.end(), it->second.begin());
+    const char* p_word = m_prefix_index.findFirst(prefix);
 
-            if (res.first == prefix.end())
-            {
-                return(it->second);
-            }
-        }
+    return( p_word ? p_word : "" );
+}
+
+/**
+* find values by prefix: one seek in the sorted index and a step per value
+*
+* @param prefix
+*   prefix to search
+*
+* @param max
+*   limit number of values
+*
+* @param o_words
+*   output: found values are appended in sorted order
+*/
+void SmkyFilePairs::find_all_by_prefix (const std::string& prefix, size_t max, std::list<std::string>& o_words)
+{
+    if (m_compiled.isOpen())
+    {
+        m_compiled.findValuesByPrefix(prefix, max, o_words);
+        return;
     }
 
-    return "";
+    m_prefix_index.findAll(prefix, max, o_words);
 }
 
 /**
@@ -269,18 +522,96 @@ std::string SmkyFilePairs::find_by_prefix (const std::string& prefix)
 */
 void SmkyFilePairs::exportToList (std::list<Entry>& entries)
 {
+    for (uint32_t i = 0; i < m_compiled.size(); ++i)
+    {
+        Entry entry;
+        entry.shortcut = m_compiled.keyAt(i);
+        entry.substitution = m_compiled.valueAt(i);
+        entries.push_back(entry);
+    }
+
     if (!m_dictionary.empty())
     {
-        SmkyHashMap::iterator it;
+        SmkyHashMap::const_iterator it;
         Entry entry;
 
         for (it = m_dictionary.begin(); it != m_dictionary.end(); ++it )
         {
-            entry.shortcut = it->first;
-            entry.substitution = it->second;
+            entry.shortcut.assign(it->key, it->length);
+            entry.substitution = it->value;
             entries.push_back(entry);
         }
     }
 }
 
+/**
+* export pointers to all keys (no copies), they are valid until the dictionary is changed or reloaded
+*
+* @param o_keys
+*   output: keys are appended
+*/
+void SmkyFilePairs::exportKeys (std::vector<const char*>& o_keys)
+{
+    for (uint32_t i = 0; i < m_compiled.size(); ++i)
+    {
+        o_keys.push_back(m_compiled.keyAt(i));
+    }
+
+    SmkyHashMap::const_iterator it;
 
+    for (it = m_dictionary.begin(); it != m_dictionary.end(); ++it)
+    {
+        o_keys.push_back(it->key);
+    }
+}
+
+/**
+* append keys added since the last call: they extend keys exported before, unless
+* any key was erased or moved meanwhile (e.g. storage was compacted)
+*
+* @param o_keys
+*   output: added keys are appended
+*
+* @return bool
+*   false if keys exported before are stale, all of them must be exported again
+*/
+bool SmkyFilePairs::takeAddedKeys (std::vector<const char*>& o_keys)
+{
+    bool valid = !m_keys_moved;
+
+    if (valid)
+    {
+        o_keys.insert(o_keys.end(), m_added_keys.begin(), m_added_keys.end());
+    }
+
+    m_added_keys.clear();
+    m_keys_moved = false;
+
+    return(valid);
+}
+
+/**
+* get memory usage and load time of the dictionary, pairs of compiled dictionary
+* are counted as mapped (or as overhead when the image was built in memory)
+*
+* @param o_stats
+*   output: statistics, name is not changed
+*/
+void SmkyFilePairs::getStats (DictionaryStats& o_stats) const
+{
+    o_stats.entries = m_compiled.size() + m_dictionary.size();
+    o_stats.keyBytes = 0;
+    o_stats.valueBytes = 0;
+
+    SmkyHashMap::const_iterator it;
+
+    for (it = m_dictionary.begin(); it != m_dictionary.end(); ++it)
+    {
+        o_stats.keyBytes += it->length + 1;
+        o_stats.valueBytes += strlen(it->value) + 1;
+    }
+
+    o_stats.overheadBytes = m_dictionary.memoryUsed() - o_stats.keyBytes - o_stats.valueBytes + m_prefix_index.memoryUsed() + m_compiled.memoryUsed();
+    o_stats.mappedBytes = m_compiled.mappedSize();
+    o_stats.loadMs = m_load_ms;
+}
@@ -20,29 +20,19 @@
 #define SMKY_FILEPAIRS_H
 
 #include "Database.h"
+#include "SmkyFlatTable.h"
+#include "SmkyPrefixIndex.h"
+#include "SmkyCompiledDictionary.h"
 #include <list>
-#include <ext/hash_map> //I know about replacement to <unordered_map>, but not sure yet about c++11 support for this project
-
-namespace __gnu_cxx
-{
-template<> struct hash<std::string>
-{
-    hash<char*> h;
-    size_t operator()(const std::string &str) const
-    {
-        return h(str.c_str());
-    };
-};
-}
-
+#include <vector>
 namespace SmartKey
 {
-using namespace __gnu_cxx;
-
-#define SmkyHashMap hash_map<std::string,std::string >
+//values are kept in the string storage of the table
+#define SmkyHashMap SmkyFlatTable<const char*>
 
 /**
- * Read/write dictionary with pairs of words stored into text file.
+ * Read/write dictionary with pairs of words stored into text file,
+ * changes are appended to the journal of the file (see SmkyJournal).
  */
 class SmkyFilePairs
 {
@@ -53,6 +43,28 @@ private:
 
     SmkyHashMap m_dictionary;
 
+    //sorted index over values of m_dictionary for prefix lookups
+    SmkyPrefixIndex m_prefix_index;
+
+    //read-only compiled dictionary, used instead of m_dictionary until the first change
+    SmkyCompiledDictionary m_compiled;
+
+    //changes not saved yet (see SmkyJournal)
+    std::vector<std::string> m_journal;
+
+    //number of records in journal file of m_journal_file
+    size_t m_journal_size;
+    std::string m_journal_file;
+
+    //duration of the last load (ms)
+    double m_load_ms;
+
+    //keys added since the last takeAddedKeys(), not collected while m_keys_moved is set
+    std::vector<const char*> m_added_keys;
+
+    //keys were erased or moved since the last takeAddedKeys(), exported pointers are stale
+    bool m_keys_moved;
+
 public:
 
     SmkyFilePairs (void);
@@ -82,9 +94,21 @@ public:
     //find by prefix
     virtual std::string find_by_prefix (const std::string& prefix);
 
+    //find up to max different values by prefix (in sorted order), append them to o_words
+    virtual void find_all_by_prefix (const std::string& prefix, size_t max, std::list<std::string>& o_words);
+
     //export all pairs from the dictionary to list
     virtual void exportToList (std::list<Entry>& entries);
 
+    //export pointers to all keys, they are valid until the dictionary is changed
+    void exportKeys (std::vector<const char*>& o_keys);
+
+    //append keys added since the last call, return false if exported keys became stale meanwhile (export all again)
+    bool takeAddedKeys (std::vector<const char*>& o_keys);
+
+    //get memory usage and load time (name is not set)
+    void getStats (DictionaryStats& o_stats) const;
+
 protected:
     //release all allocated objects
     void _clean (void);
@@ -92,6 +116,24 @@ protected:
     //read pairs from text file and add them to m_dictionary
     void _importFileDB (std::string i_db_file);
 
+    //insert pair into m_dictionary and m_prefix_index
+    void _insert (const std::string& i_key, const std::string& i_value);
+
+    //rebuild m_prefix_index after keys or values of m_dictionary were moved
+    void _reindex (void);
+
+    //erase pair from m_dictionary and m_prefix_index
+    bool _erase (const std::string& i_key);
+
+    //apply journal of the dictionary file
+    void _replayJournal (const std::string& i_db_file);
+
+    //write all pairs to the dictionary file
+    bool _writeSnapshot (const std::string& i_db_file);
+
+    //copy compiled dictionary into m_dictionary before modification
+    void _materialize (void);
+
 };
 
 /**
@@ -107,6 +149,9 @@ inline bool SmkyFilePairs::isInitialized (void)
 */
 inline int SmkyFilePairs::size (void)
 {
+    if (m_compiled.isOpen())
+        return m_compiled.size();
+
     return m_dictionary.empty() ? 0 : m_dictionary.size();
 }
 
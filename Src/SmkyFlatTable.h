@@ -0,0 +1,466 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SMKY_FLAT_TABLE_H
+#define SMKY_FLAT_TABLE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "SmkyStringArena.h"
+
+namespace SmartKey
+{
+
+/**
+ * Value of SmkyFlatTable used as a set.
+ */
+struct SmkyNoValue
+{
+};
+
+/**
+* bytes of the value kept in the arena of SmkyFlatTable, only string values (see store()) take storage
+*/
+template <typename V>
+inline size_t smkyStoredBytes (const V&, const SmkyStringArena&)
+{
+    return(0);
+}
+
+inline size_t smkyStoredBytes (const char* const& i_value, const SmkyStringArena& i_arena)
+{
+    return(i_arena.contains(i_value) ? strlen(i_value) + 1 : 0);
+}
+
+/**
+* copy the value kept in the old arena of SmkyFlatTable into the new one
+*/
+template <typename V>
+inline void smkyRelocate (V&, const SmkyStringArena&, SmkyStringArena&)
+{
+}
+
+inline void smkyRelocate (const char*& io_value, const SmkyStringArena& i_old, SmkyStringArena& io_new)
+{
+    if (i_old.contains(io_value))
+        io_value = io_new.store(io_value, strlen(io_value));
+}
+
+/**
+ * Open addressing hash table with string keys.
+ * Entries are stored in one array (linear probing) together with hash, length and the first
+ * bytes of the key, so short keys are compared without touching the key storage.
+ * Keys are copied into the string arena of the table, their addresses stay the same while
+ * relocations() doesn't change, so they can be indexed elsewhere (see SmkyPrefixIndex).
+ * Table can also refer to keys stored elsewhere instead of copying them (see insert()).
+ * Keys are not interned across tables: dictionaries of locales kept by SmkyLocalePool have their
+ * own copies of shared words (e.g. locale words of en_us and en_gb). Read-only dictionaries compiled
+ * by DictionaryCompiler -r are mapped instead of copied, so the copies are mostly text dictionaries
+ * and user words, and they are counted in the memory budget of the pool (localePoolMemoryKb).
+ * A shared intern table would take a lock on every load and a refcounted entry per unique word.
+ * Erased entries are dropped when the table is rebuilt; if most of the storage is taken by erased
+ * keys and values, live ones are copied into a new storage at the same time and relocations() grows.
+ */
+template <typename V>
+class SmkyFlatTable
+{
+public:
+    enum
+    {
+        INLINE_KEY = 8,
+        COMPACT_GARBAGE = 32 * 1024     ///< erased bytes which are worth compacting the storage
+    };
+
+    struct Entry
+    {
+        uint32_t    hash;
+        uint32_t    length;
+        char        head[INLINE_KEY];   ///< first bytes of the key
+        const char* key;                ///< zero terminated key (NULL - free entry)
+        V           value;
+    };
+
+    /**
+     * iterator over used entries
+     */
+    class const_iterator
+    {
+    private:
+        const Entry* mp_entry;
+        const Entry* mp_end;
+
+    public:
+        const_iterator (void) : mp_entry(NULL), mp_end(NULL) {}
+
+        const_iterator (const Entry* ip_entry, const Entry* ip_end) : mp_entry(ip_entry), mp_end(ip_end)
+        {
+            _skip();
+        }
+
+        const Entry& operator* (void) const { return(*mp_entry); }
+        const Entry* operator-> (void) const { return(mp_entry); }
+        bool operator== (const const_iterator& other) const { return(mp_entry == other.mp_entry); }
+        bool operator!= (const const_iterator& other) const { return(mp_entry != other.mp_entry); }
+
+        const_iterator& operator++ (void)
+        {
+            ++mp_entry;
+            _skip();
+            return(*this);
+        }
+
+    private:
+        void _skip (void)
+        {
+            while (mp_entry != mp_end && !SmkyFlatTable::_isUsed(*mp_entry))
+                ++mp_entry;
+        }
+    };
+
+private:
+    std::vector<Entry> m_entries;
+    size_t m_used;
+    size_t m_erased;
+    size_t m_garbage;       ///< bytes of erased keys and values in m_arena
+    size_t m_relocations;
+    SmkyStringArena m_arena;
+
+public:
+    SmkyFlatTable (void) : m_used(0), m_erased(0), m_garbage(0), m_relocations(0) {}
+
+    size_t size (void) const { return(m_used); }
+    bool empty (void) const { return(m_used == 0); }
+
+    const_iterator begin (void) const { return(const_iterator(_first(), _last())); }
+    const_iterator end (void) const { return(const_iterator(_last(), _last())); }
+
+    //remove all entries and release keys
+    void clear (void);
+
+    //prepare space for i_count entries
+    void reserve (size_t i_count);
+
+    //insert key if it is not present yet (value of existing key is kept), return entry and true if inserted;
+    //ip_stored_key is zero terminated key kept by the caller while it is in the table (e.g. by a dictionary
+    //of the same locale, see SmkyKnownWords), it is used instead of a copy
+    std::pair<Entry*, bool> insert (const char* i_key, size_t i_length, const V& i_value, const char* ip_stored_key = NULL);
+
+    //find entry of the key, NULL if not found
+    Entry* find (const char* i_key, size_t i_length);
+    const Entry* find (const char* i_key, size_t i_length) const;
+    const Entry* find (const std::string& i_key) const { return(find(i_key.data(), i_key.length())); }
+
+    //erase found entry
+    void erase (Entry* ip_entry);
+
+    //copy additional string (e.g. value) into the storage of the table, it is released by clear()
+    //or moved by compaction when it is the value of an entry
+    const char* store (const char* i_str, size_t i_length) { return(m_arena.store(i_str, i_length)); }
+
+    //number of compactions of the storage, addresses of keys and values are changed by each of them
+    size_t relocations (void) const { return(m_relocations); }
+
+    //prepare storage for i_size bytes of keys and values in one block
+    void reserveStorage (size_t i_size) { m_arena.reserve(i_size); }
+
+    //bytes allocated for entries and string storage
+    size_t memoryUsed (void) const { return(m_entries.capacity() * sizeof(Entry) + m_arena.allocated()); }
+
+    //hash of the key
+    static uint32_t hash (const char* i_key, size_t i_length);
+
+private:
+    static const char* _erasedKey (void) { static const char s_erased = '\0'; return(&s_erased); }
+    static bool _isUsed (const Entry& i_entry) { return(i_entry.key != NULL && i_entry.key != _erasedKey()); }
+    static bool _matches (const Entry& i_entry, uint32_t i_hash, const char* i_key, size_t i_length);
+
+    const Entry* _first (void) const { return(m_entries.empty() ? NULL : &m_entries[0]); }
+    const Entry* _last (void) const { return(m_entries.empty() ? NULL : &m_entries[0] + m_entries.size()); }
+
+    //find slot of the key (or NULL)
+    const Entry* _find (const char* i_key, size_t i_length, uint32_t i_hash) const;
+
+    //rebuild table with a new capacity (power of 2)
+    void _rehash (size_t i_capacity);
+
+    //most of the storage is taken by erased keys and values
+    bool _isWasteful (void) const { return(m_garbage >= COMPACT_GARBAGE && m_garbage * 2 > m_arena.stored()); }
+
+    //copy keys and values of used entries into a new storage
+    void _compact (void);
+};
+
+/**
+* FNV-1a hash
+*/
+template <typename V>
+inline uint32_t SmkyFlatTable<V>::hash (const char* i_key, size_t i_length)
+{
+    uint32_t h = 2166136261U;
+
+    for (size_t i = 0; i < i_length; ++i)
+    {
+        h ^= (unsigned char)i_key[i];
+        h *= 16777619U;
+    }
+
+    return(h);
+}
+
+/**
+* compare entry with the key: hash, length and inline head first, the rest of the key only if needed
+*/
+template <typename V>
+inline bool SmkyFlatTable<V>::_matches (const Entry& i_entry, uint32_t i_hash, const char* i_key, size_t i_length)
+{
+    if (i_entry.hash != i_hash || i_entry.length != i_length || !_isUsed(i_entry))
+        return(false);
+
+    size_t head = i_length < INLINE_KEY ? i_length : INLINE_KEY;
+
+    if (memcmp(i_entry.head, i_key, head) != 0)
+        return(false);
+
+    return(i_length <= INLINE_KEY || memcmp(i_entry.key + INLINE_KEY, i_key + INLINE_KEY, i_length - INLINE_KEY) == 0);
+}
+
+/**
+* remove all entries and release keys
+*/
+template <typename V>
+void SmkyFlatTable<V>::clear (void)
+{
+    std::vector<Entry>().swap(m_entries);
+    m_used = 0;
+    m_erased = 0;
+    m_garbage = 0;
+    m_arena.clear();
+}
+
+/**
+* prepare space for entries, so the table doesn't grow while they are inserted;
+* capacity depends on live entries only, erased ones are dropped by the rebuild
+*
+* @param i_count
+*   expected number of entries
+*/
+template <typename V>
+void SmkyFlatTable<V>::reserve (size_t i_count)
+{
+    size_t capacity = 16;
+
+    //load factor is kept below 0.7
+    while (capacity * 7 < i_count * 10)
+        capacity *= 2;
+
+    if (capacity > m_entries.size())
+        _rehash(capacity);
+}
+
+/**
+* find slot of the key
+*
+* @return const Entry*
+*   NULL if not found
+*/
+template <typename V>
+const typename SmkyFlatTable<V>::Entry* SmkyFlatTable<V>::_find (const char* i_key, size_t i_length, uint32_t i_hash) const
+{
+    if (m_used == 0)
+        return(NULL);
+
+    size_t mask = m_entries.size() - 1;
+
+    for (size_t i = i_hash & mask; m_entries[i].key != NULL; i = (i + 1) & mask)
+    {
+        if (_matches(m_entries[i], i_hash, i_key, i_length))
+            return(&m_entries[i]);
+    }
+
+    return(NULL);
+}
+
+/**
+* find entry of the key
+*
+* @param i_key
+*   key (not necessarily zero terminated)
+*
+* @param i_length
+*   length of the key
+*
+* @return Entry*
+*   NULL if not found
+*/
+template <typename V>
+inline const typename SmkyFlatTable<V>::Entry* SmkyFlatTable<V>::find (const char* i_key, size_t i_length) const
+{
+    return(_find(i_key, i_length, hash(i_key, i_length)));
+}
+
+template <typename V>
+inline typename SmkyFlatTable<V>::Entry* SmkyFlatTable<V>::find (const char* i_key, size_t i_length)
+{
+    return(const_cast<Entry*>(_find(i_key, i_length, hash(i_key, i_length))));
+}
+
+/**
+* insert key if it is not present yet, like hash_map::insert value of existing key isn't changed
+*
+* @param i_key
+*   key (not necessarily zero terminated)
+*
+* @param i_length
+*   length of the key
+*
+* @param i_value
+*   value
+*
+* @param ip_stored_key
+*   NULL - key is copied into the table, otherwise the same key stored by the caller
+*
+* @return std::pair<Entry*, bool>
+*   entry of the key, true if it was inserted
+*/
+template <typename V>
+std::pair<typename SmkyFlatTable<V>::Entry*, bool> SmkyFlatTable<V>::insert (const char* i_key, size_t i_length, const V& i_value, const char* ip_stored_key)
+{
+    uint32_t h = hash(i_key, i_length);
+    Entry* p_entry = const_cast<Entry*>(_find(i_key, i_length, h));
+
+    if (p_entry)
+        return(std::make_pair(p_entry, false));
+
+    reserve(m_used + 1);
+
+    //too many erased entries in probe chains or in the storage: rebuild with the same capacity instead of growing
+    if ((m_used + m_erased + 1) * 10 > m_entries.size() * 7 || _isWasteful())
+        _rehash(m_entries.size());
+
+    size_t mask = m_entries.size() - 1;
+    size_t i = h & mask;
+
+    //erased entries are reused
+    while (_isUsed(m_entries[i]))
+        i = (i + 1) & mask;
+
+    p_entry = &m_entries[i];
+
+    if (p_entry->key != NULL)
+        m_erased--;
+
+    p_entry->hash = h;
+    p_entry->length = (uint32_t)i_length;
+    memset(p_entry->head, 0, INLINE_KEY);
+    memcpy(p_entry->head, i_key, i_length < INLINE_KEY ? i_length : INLINE_KEY);
+    p_entry->key = ip_stored_key ? ip_stored_key : m_arena.store(i_key, i_length);
+    p_entry->value = i_value;
+    m_used++;
+
+    return(std::make_pair(p_entry, true));
+}
+
+/**
+* erase found entry, it stays in the probe chain as erased
+*
+* @param ip_entry
+*   entry returned by find() or insert()
+*/
+template <typename V>
+void SmkyFlatTable<V>::erase (Entry* ip_entry)
+{
+    if (m_arena.contains(ip_entry->key))
+        m_garbage += ip_entry->length + 1;
+
+    m_garbage += smkyStoredBytes(ip_entry->value, m_arena);
+
+    ip_entry->key = _erasedKey();
+    m_used--;
+    m_erased++;
+}
+
+/**
+* rebuild table, erased entries are dropped and the storage is compacted
+* when erased keys and values take most of it
+*
+* @param i_capacity
+*   new number of entries (power of 2)
+*/
+template <typename V>
+void SmkyFlatTable<V>::_rehash (size_t i_capacity)
+{
+    std::vector<Entry> old_entries(i_capacity);
+    old_entries.swap(m_entries);
+
+    for (size_t i = 0; i < i_capacity; ++i)
+        m_entries[i].key = NULL;
+
+    size_t mask = i_capacity - 1;
+
+    for (size_t i = 0; i < old_entries.size(); ++i)
+    {
+        if (!_isUsed(old_entries[i]))
+            continue;
+
+        size_t j = old_entries[i].hash & mask;
+
+        while (m_entries[j].key != NULL)
+            j = (j + 1) & mask;
+
+        m_entries[j] = old_entries[i];
+    }
+
+    m_erased = 0;
+
+    if (_isWasteful())
+        _compact();
+}
+
+/**
+* copy keys and values of used entries into a new storage and release the old one,
+* keys kept by the caller (see insert()) are not copied
+*/
+template <typename V>
+void SmkyFlatTable<V>::_compact (void)
+{
+    SmkyStringArena arena;
+    arena.reserve(m_arena.stored() - m_garbage);
+
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        Entry& entry = m_entries[i];
+
+        if (!_isUsed(entry))
+            continue;
+
+        if (m_arena.contains(entry.key))
+            entry.key = arena.store(entry.key, entry.length);
+
+        smkyRelocate(entry.value, m_arena, arena);
+    }
+
+    m_arena.swap(arena);
+    m_garbage = 0;
+    m_relocations++;
+}
+
+}
+
+#endif
@@ -16,19 +16,44 @@
 *
 * LICENSE@@@ */
 
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <algorithm>
 #include <cctype>
+#include <set>
+#include <sys/stat.h>
 #include "SmkyHunspellDatabase.h"
 #include "Settings.h"
 
 using namespace SmartKey;
 
 /**
-* SmkyHunspellDatabase
+* SmkyHunspellDatabase: dictionary of current locale
 */
 SmkyHunspellDatabase::SmkyHunspellDatabase (void)
+{
+    _init();
+    _loadDictionary(Settings::getInstance()->localeSettings);
+}
+
+/**
+* SmkyHunspellDatabase: dictionary of the given locale (can be loaded in background before
+* the locale becomes current)
+*
+* @param i_locale
+*   locale settings
+*/
+SmkyHunspellDatabase::SmkyHunspellDatabase (const LocaleSettings& i_locale)
+{
+    _init();
+    _loadDictionary(i_locale);
+}
+
+/**
+* init members
+*/
+void SmkyHunspellDatabase::_init (void)
 {
     //m_initialized = false;
 #ifdef USE_HUNSPELL
@@ -36,8 +61,11 @@ SmkyHunspellDatabase::SmkyHunspellDatabase (void)
 #else
     m_initialized = false;
 #endif
-
-    _loadDictionary();
+    m_dict_words = 0;
+    m_dict_bytes = 0;
+    m_dict_load_ms = 0;
+    m_sym_load_ms = 0;
+    m_freq_load_ms = 0;
 }
 
 /**
@@ -62,24 +90,38 @@ void SmkyHunspellDatabase::_clean (void)
         g_debug("Hunspell: done, no dictionaries");
     }
 #endif
+    m_sym_index.close();
+    m_frequencies.close();
     m_initialized = false;
+
+    m_dict_words = 0;
+    m_dict_bytes = 0;
+    m_dict_load_ms = 0;
+    m_sym_load_ms = 0;
+    m_freq_load_ms = 0;
 }
 
 /**
 * load dictionary
+*
+* @param i_locale
+*   locale settings
 */
-void SmkyHunspellDatabase::_loadDictionary (void)
+void SmkyHunspellDatabase::_loadDictionary (const LocaleSettings& i_locale)
 {
     //
     // constract path to dictionary and aff-file 'on the fly' using settings
     //
     Settings* p_settings = Settings::getInstance();
 
-    string locale = p_settings->localeSettings.getLanguageCountryLocale();
-    string aff_path = p_settings->getDBFilePath(Settings::DICT_HUNSPELL, Settings::DICT_HUNSPELL_AFF);
-    string dict_path = p_settings->getDBFilePath(Settings::DICT_HUNSPELL, Settings::DICT_HUNSPELL_DIC);
+    string locale = i_locale.getLanguageCountryLocale();
+    string aff_path = p_settings->getDBFilePath(Settings::DICT_HUNSPELL, Settings::DICT_HUNSPELL_AFF, i_locale);
+    string dict_path = p_settings->getDBFilePath(Settings::DICT_HUNSPELL, Settings::DICT_HUNSPELL_DIC, i_locale);
 
     _clean();
+    _resetSuggestCost();
+
+    m_layout.load(i_locale.m_keyboardLayout);
 
     if ( (g_file_test(aff_path.c_str(), G_FILE_TEST_EXISTS)) &&
             (g_file_test(dict_path.c_str(), G_FILE_TEST_EXISTS)) )
@@ -87,13 +129,27 @@ void SmkyHunspellDatabase::_loadDictionary (void)
 #ifdef USE_HUNSPELL
         g_debug("Hunspell: going to load dictionary for locale '%s'", locale.c_str());
 
+        gint64 start = g_get_monotonic_time();
+
         mp_dict_base = new Hunspell( aff_path.c_str(), dict_path.c_str(), NULL );
         m_initialized = mp_dict_base != NULL;
+
+        m_dict_load_ms = (g_get_monotonic_time() - start) / 1000.0;
 #endif
 
         if (m_initialized)
         {
             g_debug("Hunspell: dictionaries was loaded successfuly.");
+            _readDictionaryInfo(aff_path, dict_path);
+
+            gint64 step_start = g_get_monotonic_time();
+            _loadSymSpellIndex(i_locale);
+            m_sym_load_ms = (g_get_monotonic_time() - step_start) / 1000.0;
+
+            step_start = g_get_monotonic_time();
+            if (m_frequencies.load(p_settings->getDBFilePath(Settings::DICT_FREQUENCY, Settings::DICT_LOCALE_INDEPEND, i_locale)))
+                g_debug("Hunspell: guesses are ranked by word frequency");
+            m_freq_load_ms = (g_get_monotonic_time() - step_start) / 1000.0;
         }
     }
     else
@@ -105,13 +161,124 @@ void SmkyHunspellDatabase::_loadDictionary (void)
     }
 }
 
+/**
+* map compiled SymSpell index (<locale>.sym, see Tools/DictionaryCompiler) if it is enabled for the locale.
+* Index is not built at load time: every dictionary instance (worker threads, background and extra locales)
+* would build and keep its own copy, while the mapped file is shared. Without the file Hunspell::suggest is used.
+* Index compiled from stems of .dic file can't suggest inflected forms,
+* so Hunspell::suggest is still asked for them (see findGuesses).
+*
+* @param i_locale
+*   locale settings
+*/
+void SmkyHunspellDatabase::_loadSymSpellIndex (const LocaleSettings& i_locale)
+{
+    Settings* p_settings = Settings::getInstance();
+
+    if (!p_settings->isSymSpellEnabled(i_locale))
+        return;
+
+    string sym_path = p_settings->getDBFilePath(Settings::DICT_HUNSPELL, Settings::DICT_HUNSPELL_SYM, i_locale);
+
+    if (sym_path.empty() || !m_sym_index.open(sym_path))
+    {
+        g_warning("Hunspell: SymSpell index is enabled for '%s', but it is not compiled (DictionaryCompiler -s), using Hunspell::suggest",
+                  i_locale.getLanguageCountryLocale().c_str());
+        return;
+    }
+
+    if (!m_sym_index.hasInflectedForms())
+        g_debug("Hunspell: SymSpell index has stems only, Hunspell::suggest is used for inflected forms");
+}
+
+/**
+* read number of words declared in the first line of .dic file and size of .aff and .dic files,
+* Hunspell doesn't report its memory usage, it grows with the size of the files
+*
+* @param i_aff_path
+*   path to hunspell .aff file
+*
+* @param i_dict_path
+*   path to hunspell .dic file
+*/
+void SmkyHunspellDatabase::_readDictionaryInfo (const std::string& i_aff_path, const std::string& i_dict_path)
+{
+    struct stat st;
+
+    m_dict_bytes = 0;
+
+    if (stat(i_aff_path.c_str(), &st) == 0)
+        m_dict_bytes += st.st_size;
+
+    if (stat(i_dict_path.c_str(), &st) == 0)
+        m_dict_bytes += st.st_size;
+
+    m_dict_words = 0;
+
+    FILE* p_file = fopen(i_dict_path.c_str(), "r");
+    if (p_file)
+    {
+        char line[32];
+        if (fgets(line, sizeof(line), p_file))
+            m_dict_words = strtoul(line, NULL, 10);
+
+        fclose(p_file);
+    }
+}
+
+/**
+* append memory usage and load time of hunspell dictionary (estimated by size of its files),
+* SymSpell index and frequency list
+*
+* @param o_stats
+*   output: statistics are appended
+*/
+void SmkyHunspellDatabase::getStats (std::vector<DictionaryStats>& o_stats) const
+{
+    DictionaryStats stats;
+
+    stats.name = "hunspell";
+    stats.entries = m_dict_words;
+    //estimate, hunspell doesn't report its memory usage
+    stats.overheadBytes = m_dict_bytes;
+    stats.loadMs = m_dict_load_ms;
+    o_stats.push_back(stats);
+
+    stats = DictionaryStats();
+    stats.name = "symspell";
+    stats.entries = m_sym_index.size();
+    stats.mappedBytes = m_sym_index.mappedSize();
+    stats.loadMs = m_sym_load_ms;
+    o_stats.push_back(stats);
+
+    stats = DictionaryStats();
+    stats.name = "frequency";
+    stats.entries = m_frequencies.size();
+    stats.overheadBytes = m_frequencies.memoryUsed();
+    stats.mappedBytes = m_frequencies.mappedSize();
+    stats.loadMs = m_freq_load_ms;
+    o_stats.push_back(stats);
+}
+
 /**
 * notification about locale change
 */
 void SmkyHunspellDatabase::changedLocaleSettings (void)
 {
     g_debug("Hunspell: got notification: locale settings changed");
-    _loadDictionary();
+    _loadDictionary(Settings::getInstance()->localeSettings);
+}
+
+/**
+* use other keyboard layout for ranking guesses, e.g. by dictionaries of extra locales
+* which are not reloaded on locale change
+*
+* @param i_layout
+*   name of the layout
+*/
+void SmkyHunspellDatabase::setKeyboardLayout (const std::string& i_layout)
+{
+    m_layout.load(i_layout);
 }
 
 /**
@@ -142,9 +309,71 @@ bool SmkyHunspellDatabase::findEntry (const std::string& word)
     return false;
 }
 
+/**
+* check word and find guesses in one pass: the word is spelled once,
+* and guesses are not spelled again when Hunspell already verified them (see _isVerifiedGuess)
+*
+* @param word
+*   word to search for
+*
+* @param result
+*   output value: result.inDictionary is set if word is good, guesses are added
+*
+* @param maxGuesses
+*   limit number of guesses for result
+*
+* @param deadline
+*   time budget of the request
+*
+* @param rankByKeys
+*   weight edit cost of guesses by keyboard distance and prune unlikely ones
+*
+* @return SmartKeyErrorCode
+*   - SKERR_SUCCESS if SmkyHunspellDatabase instance is initialized
+*   - SKERR_FAILURE if not
+*/
+SmartKeyErrorCode SmkyHunspellDatabase::checkAndSuggest (const std::string& word, SpellCheckWordInfo& result, int maxGuesses, const SmkyDeadline& deadline, bool rankByKeys)
+{
+    if (!m_initialized)
+    {
+        g_debug("Hunspell: dictionary is not loaded, spell check request ignored");
+        return(SKERR_FAILURE);
+    }
+
+    if (_isSpelledGood(word.c_str()))
+    {
+        result.inDictionary = true;
+    }
+
+    return( findGuesses(word, result, maxGuesses, deadline, rankByKeys) );
+}
+
+/**
+* Hunspell::suggest and cheap guesses return only dictionary words, except of the multi word
+* suggestions (split with space or dash), they need to be verified as a whole.
+* Guesses of SymSpell index are not verified this way, findGuesses spells them unless Hunspell::suggest returned them too.
+*
+* @param guess
+*   guess to test
+*
+* @return bool
+*   true if guess doesn't need a spell check
+*/
+bool SmkyHunspellDatabase::_isVerifiedGuess (const std::string& guess)
+{
+    return( guess.find_first_of(" -") == std::string::npos );
+}
+
 /**
 * find guesses
 *
+* SymSpell index (if enabled) is asked first, Hunspell::suggest is skipped if the index has inflected forms too.
+* Hunspell::suggest can't be interrupted, so it is called only if it is expected to fit into the time
+* budget (cost is estimated from the previous calls for words of the same length). Otherwise guesses are
+* made of keyboard adjacency substitutions and transpositions, and result is marked as partial.
+* When guesses are ranked (by keys, or by frequency if there is a frequency list for the locale), more
+* candidates are collected and the cheapest/most frequent ones are kept.
+*
 * @param word
 *   word to search for
 *
@@ -154,39 +383,112 @@ bool SmkyHunspellDatabase::findEntry (const std::string& word)
 * @param maxGuesses
 *   limit number of guesses for result
 *
+* @param deadline
+*   time budget of the request
+*
+* @param rankByKeys
+*   weight edit cost of guesses by keyboard distance and prune unlikely ones
+*
 * @return SmartKeyErrorCode
 *   - SKERR_SUCCESS if SmkyHunspellDatabase instance is initialized
 *   - SKERR_FAILURE if not
 */
-SmartKeyErrorCode SmkyHunspellDatabase::findGuesses (const std::string& word, SpellCheckWordInfo& result, int maxGuesses)
+SmartKeyErrorCode SmkyHunspellDatabase::findGuesses (const std::string& word, SpellCheckWordInfo& result, int maxGuesses, const SmkyDeadline& deadline, bool rankByKeys)
 {
     if (m_initialized)
     {
 #ifdef USE_HUNSPELL
-        int res;
-        WordGuess word_guess;
-        char** p_slst;
-        const char* p_search_word = word.c_str();
+        std::vector<std::string> guesses;
+
+        //more candidates are collected for ranking, they are truncated to maxGuesses after it
+        bool rank = rankByKeys || m_frequencies.isLoaded();
+        int candidates = rank ? std::max(maxGuesses, (int)RANK_CANDIDATES) : maxGuesses;
+
+        //SymSpell index answers in microseconds, Hunspell::suggest is used only if it found nothing
+        m_sym_index.lookup(word, candidates, guesses);
 
-        res = mp_dict_base->suggest( &p_slst, p_search_word );
+        //index can be compiled from any word list, its guesses are spelled by Hunspell
+        bool from_index = !guesses.empty();
+        std::set<std::string> index_guesses(guesses.begin(), guesses.end());
 
-        if (res > 0) // have suggestion(s)!
+        if (from_index)
         {
-            for (int i = 0; i < std::min(res, maxGuesses); ++i)
+            g_debug("Hunspell: %u guesses for '%s' from SymSpell index", (unsigned int)guesses.size(), word.c_str());
+        }
+
+        //index of stems misses inflected forms, Hunspell::suggest adds them
+        if (!from_index || !m_sym_index.hasInflectedForms())
+        {
+            if (_canAffordSuggest(word, deadline))
             {
-                word_guess.guess = p_slst[i];
-                word_guess.spellCorrection = _isSpelledGood(p_slst[i]);
+                char** p_slst;
+                gint64 start = g_get_monotonic_time();
+
+                int res = mp_dict_base->suggest( &p_slst, word.c_str() );
 
-                if ( i == 0) //suggest to auto replace a first word
+                _updateSuggestCost(word, g_get_monotonic_time() - start);
+
+                if (res > 0) // have suggestion(s)!
                 {
-                    word_guess.autoAccept = true;
+                    //suggestions go first, guesses of the index follow (unless ranked)
+                    std::vector<std::string> suggested;
+
+                    for (int i = 0; i < std::min(res, candidates); ++i)
+                    {
+                        suggested.push_back(p_slst[i]);
+
+                        //verified by Hunspell too
+                        index_guesses.erase(suggested.back());
+                    }
+
+                    mp_dict_base->free_list( &p_slst, res );
+
+                    for (size_t i = 0; i < guesses.size(); ++i)
+                    {
+                        if (std::find(suggested.begin(), suggested.end(), guesses[i]) == suggested.end())
+                            suggested.push_back(guesses[i]);
+                    }
+
+                    if (!rank && (int)suggested.size() > candidates)
+                        suggested.resize(candidates);
+
+                    guesses.swap(suggested);
                 }
+            }
+            else if (!from_index)
+            {
+                g_debug("Hunspell: no time left for suggestions of '%s', using cheap guesses", word.c_str());
+                _findCheapGuesses(word, guesses, candidates, deadline);
+                result.partial = true;
+            }
+            else
+            {
+                //inflected forms are missing
+                result.partial = true;
+            }
+        }
+
+        if (rank)
+        {
+            _rankGuesses(word, guesses, maxGuesses, rankByKeys);
+        }
+
+        WordGuess word_guess;
 
-                result.guesses.push_back(word_guess);
-                word_guess.autoAccept = false;
+        for (size_t i = 0; i < guesses.size(); ++i)
+        {
+            word_guess.guess = guesses[i];
+            //only guesses of the index and multi word suggestions are spelled again
+            bool verified = !index_guesses.count(guesses[i]) && _isVerifiedGuess(guesses[i]);
+            word_guess.spellCorrection = verified || _isSpelledGood(guesses[i].c_str());
+
+            if ( i == 0) //suggest to auto replace a first word
+            {
+                word_guess.autoAccept = true;
             }
 
-            mp_dict_base->free_list( &p_slst, res );
+            result.guesses.push_back(word_guess);
+            word_guess.autoAccept = false;
         }
 #endif
     }
@@ -196,6 +498,216 @@ SmartKeyErrorCode SmkyHunspellDatabase::findGuesses (const std::string& word, Sp
     return( m_initialized ? SKERR_SUCCESS : SKERR_FAILURE );
 }
 
+/**
+* add candidate to guesses if it is a good word (and not added yet)
+*
+* @param candidate
+*   candidate word
+*
+* @param o_guesses
+*   output: guesses
+*
+* @return bool
+*   true if added
+*/
+bool SmkyHunspellDatabase::_addCheapGuess (const std::string& candidate, std::vector<std::string>& o_guesses)
+{
+    if (std::find(o_guesses.begin(), o_guesses.end(), candidate) != o_guesses.end())
+        return(false);
+
+    if (!_isSpelledGood(candidate.c_str()))
+        return(false);
+
+    o_guesses.push_back(candidate);
+    return(true);
+}
+
+/**
+* find guesses with transpositions of adjacent letters and substitutions of letters with
+* their neighbours on the keyboard; only ASCII letters are touched, so UTF-8 sequences stay intact
+*
+* @param word
+*   word to search for
+*
+* @param o_guesses
+*   output: guesses
+*
+* @param maxGuesses
+*   limit number of guesses
+*
+* @param deadline
+*   time budget of the request
+*/
+void SmkyHunspellDatabase::_findCheapGuesses (const std::string& word, std::vector<std::string>& o_guesses, int maxGuesses, const SmkyDeadline& deadline)
+{
+    std::string candidate;
+
+    for (size_t i = 0; i + 1 < word.length(); ++i)
+    {
+        if ((int)o_guesses.size() >= maxGuesses || deadline.isExpired())
+            return;
+
+        if ((unsigned char)word[i] >= 0x80 || (unsigned char)word[i + 1] >= 0x80 || word[i] == word[i + 1])
+            continue;
+
+        candidate = word;
+        std::swap(candidate[i], candidate[i + 1]);
+        _addCheapGuess(candidate, o_guesses);
+    }
+
+    for (size_t i = 0; i < word.length(); ++i)
+    {
+        const std::string& neighbours = m_layout.getNeighbours(word[i]);
+        bool upper = isupper((unsigned char)word[i]) != 0;
+
+        for (size_t n = 0; n < neighbours.length(); ++n)
+        {
+            if ((int)o_guesses.size() >= maxGuesses || deadline.isExpired())
+                return;
+
+            candidate = word;
+            candidate[i] = upper ? toupper((unsigned char)neighbours[n]) : neighbours[n];
+            _addCheapGuess(candidate, o_guesses);
+        }
+    }
+}
+
+/**
+* order guesses by edit distance to the word, more frequent guesses first for equal distances
+* (Hunspell/index order is kept if frequencies are equal or unknown), truncate to maxGuesses
+*
+* @param word
+*   typed word
+*
+* @param io_guesses
+*   guesses to rank
+*
+* @param maxGuesses
+*   limit number of guesses
+*
+* @param rankByKeys
+*   weight distance by keyboard (typos of adjacent keys are cheaper) and prune guesses much farther
+*   than the best one
+*/
+void SmkyHunspellDatabase::_rankGuesses (const std::string& word, std::vector<std::string>& io_guesses, int maxGuesses, bool rankByKeys)
+{
+    //(distance, -frequency, original position)
+    std::vector< std::pair< std::pair<int, gint64>, size_t> > ranks;
+
+    for (size_t i = 0; i < io_guesses.size(); ++i)
+    {
+        int distance = m_layout.getDistance(word, io_guesses[i], rankByKeys);
+        gint64 frequency = m_frequencies.getFrequency(io_guesses[i]);
+
+        ranks.push_back(std::make_pair(std::make_pair(distance, -frequency), i));
+    }
+
+    std::sort(ranks.begin(), ranks.end());
+
+    std::vector<std::string> ranked;
+
+    for (size_t i = 0; i < ranks.size() && (int)ranked.size() < maxGuesses; ++i)
+    {
+        if (rankByKeys && ranks[i].first.first > ranks[0].first.first + RANK_PRUNE_MARGIN)
+            break;
+
+        ranked.push_back(io_guesses[ranks[i].second]);
+    }
+
+    io_guesses.swap(ranked);
+}
+
+/**
+* the most frequent words starting with prefix
+*
+* @param prefix
+*   prefix to complete
+*
+* @param max
+*   limit number of words
+*
+* @param o_words
+*   output: completions are appended, the most frequent first (nothing if there is no frequency list for the locale)
+*/
+void SmkyHunspellDatabase::findCompletions (const std::string& prefix, size_t max, std::list<std::string>& o_words) const
+{
+    m_frequencies.findBestCompletions(prefix, max, o_words);
+}
+
+/**
+* usage count of the word
+*
+* @param word
+*   word
+*
+* @return uint32_t
+*   usage count, 0 if unknown or there is no frequency list for the locale
+*/
+uint32_t SmkyHunspellDatabase::getFrequency (const std::string& word) const
+{
+    return( m_frequencies.getFrequency(word) );
+}
+
+/**
+* is there enough time left for Hunspell::suggest?
+*
+* @param word
+*   word to search for
+*
+* @param deadline
+*   time budget of the request
+*
+* @return bool
+*   true if suggest is expected to finish in time
+*/
+bool SmkyHunspellDatabase::_canAffordSuggest (const std::string& word, const SmkyDeadline& deadline)
+{
+    //suggest can't be interrupted, nobody waits for result of superseded request
+    if (deadline.isCancelled())
+        return(false);
+
+    if (!deadline.isLimited())
+        return(true);
+
+    gint64& cost = m_suggest_cost[std::min(word.length(), (size_t)SUGGEST_COST_BUCKETS - 1)];
+    gint64 remaining = deadline.getRemainingUs();
+
+    if (remaining > 0 && cost <= remaining)
+        return(true);
+
+    //forget the estimation slowly, so suggest is tried again later
+    cost -= cost / 8;
+
+    return(false);
+}
+
+/**
+* remember how long Hunspell::suggest took
+*
+* @param word
+*   word which was searched
+*
+* @param cost
+*   time spent (microseconds)
+*/
+void SmkyHunspellDatabase::_updateSuggestCost (const std::string& word, gint64 cost)
+{
+    gint64& estimation = m_suggest_cost[std::min(word.length(), (size_t)SUGGEST_COST_BUCKETS - 1)];
+
+    estimation = estimation ? (estimation * 3 + cost) / 4 : cost;
+}
+
+/**
+* reset estimated costs, they depend on the loaded dictionary
+*/
+void SmkyHunspellDatabase::_resetSuggestCost (void)
+{
+    for (int i = 0; i < SUGGEST_COST_BUCKETS; ++i)
+    {
+        m_suggest_cost[i] = 0;
+    }
+}
+
 /**
 * test word spelling
 *
@@ -20,8 +20,14 @@
 #define SMKY_HUNSPELL_DATABASE_H
 
 #include <string>
+#include <vector>
 #include "Database.h"
+#include "Settings.h"
 #include "SpellCheckClient.h"
+#include "SmkyDeadline.h"
+#include "SmkyKeyboardLayout.h"
+#include "SmkySymSpellIndex.h"
+#include "SmkyWordFrequency.h"
 
 #define USE_HUNSPELL
 
@@ -45,27 +51,99 @@ private:
     Hunspell* mp_dict_base;
 #endif
 
+    //keyboard layout used for cheap guesses
+    SmkyKeyboardLayout m_layout;
+
+    //fast suggestions (enabled per locale in settings)
+    SmkySymSpellIndex m_sym_index;
+
+    //usage counts of words (optional, per locale)
+    SmkyWordFrequency m_frequencies;
+
+    //words declared in .dic file, size of .aff and .dic files and load durations (ms)
+    size_t m_dict_words;
+    size_t m_dict_bytes;
+    double m_dict_load_ms;
+    double m_sym_load_ms;
+    double m_freq_load_ms;
+
+    //estimated cost of Hunspell::suggest (microseconds) by length of the word
+    enum { SUGGEST_COST_BUCKETS = 32 };
+    gint64 m_suggest_cost[SUGGEST_COST_BUCKETS];
+
+    //number of candidates collected for ranking and margin (SmkyKeyboardLayout::EDIT_COST units) over the best
+    //candidate, candidates above the margin are pruned when ranked by keys distance
+    enum { RANK_CANDIDATES = 15, RANK_PRUNE_MARGIN = 100 };
+
 public:
 
     SmkyHunspellDatabase (void);
+    SmkyHunspellDatabase (const LocaleSettings& i_locale);
     virtual ~SmkyHunspellDatabase (void);
     void changedLocaleSettings (void);
 
+    //use other keyboard layout for ranking guesses (dictionary isn't reloaded)
+    void setKeyboardLayout (const std::string& i_layout);
+
     bool isLoaded (void);
     bool findEntry (const std::string& word);
 
-    SmartKeyErrorCode findGuesses (const std::string& word, SpellCheckWordInfo& result, int maxGuesses);
+    //find guesses ordered by (edit cost, frequency), if rankByKeys is set edit cost is weighted by keyboard distance
+    //and unlikely guesses are pruned
+    SmartKeyErrorCode findGuesses (const std::string& word, SpellCheckWordInfo& result, int maxGuesses, const SmkyDeadline& deadline, bool rankByKeys = false);
+
+    //check word and find guesses in one pass
+    SmartKeyErrorCode checkAndSuggest (const std::string& word, SpellCheckWordInfo& result, int maxGuesses, const SmkyDeadline& deadline, bool rankByKeys = false);
+
+    //up to max the most frequent words starting with prefix (nothing if there is no frequency list for the locale)
+    void findCompletions (const std::string& prefix, size_t max, std::list<std::string>& o_words) const;
+
+    //usage count of the word, 0 if unknown or there is no frequency list for the locale
+    uint32_t getFrequency (const std::string& word) const;
+
+    //append memory usage and load time of hunspell dictionary, SymSpell index and frequency list
+    void getStats (std::vector<DictionaryStats>& o_stats) const;
 
 private:
+    //init members
+    void _init (void);
+
     //release all allocated objects
     void _clean (void);
 
-    //load dictionary according to current locale settings
-    void _loadDictionary (void);
+    //load dictionary of the locale
+    void _loadDictionary (const LocaleSettings& i_locale);
+
+    //map compiled SymSpell index if it is enabled for the locale
+    void _loadSymSpellIndex (const LocaleSettings& i_locale);
+
+    //read number of words and size of hunspell dictionary files
+    void _readDictionaryInfo (const std::string& i_aff_path, const std::string& i_dict_path);
 
     //test word spelling
     bool _isSpelledGood (const char* ip_word);
 
+    //is guess already verified by the way it was made?
+    static bool _isVerifiedGuess (const std::string& guess);
+
+    //find guesses with keyboard adjacency substitutions and transpositions
+    void _findCheapGuesses (const std::string& word, std::vector<std::string>& o_guesses, int maxGuesses, const SmkyDeadline& deadline);
+
+    //add candidate to guesses if it is a good word
+    bool _addCheapGuess (const std::string& candidate, std::vector<std::string>& o_guesses);
+
+    //order guesses by (edit cost, frequency), prune unlikely ones if ranked by keys and truncate to maxGuesses
+    void _rankGuesses (const std::string& word, std::vector<std::string>& io_guesses, int maxGuesses, bool rankByKeys);
+
+    //is there enough time left for Hunspell::suggest?
+    bool _canAffordSuggest (const std::string& word, const SmkyDeadline& deadline);
+
+    //remember how long Hunspell::suggest took
+    void _updateSuggestCost (const std::string& word, gint64 cost);
+
+    //reset estimated costs
+    void _resetSuggestCost (void);
+
 };
 
 /**
@@ -0,0 +1,271 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "SmkyJournal.h"
+#include "Settings.h"
+#include <glib.h>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+using namespace SmartKey;
+
+/**
+* get path of journal of the dictionary
+*
+* @param i_db_file
+*   dictionary file
+*
+* @return std::string
+*   journal file
+*/
+std::string SmkyJournal::getPath (const std::string& i_db_file)
+{
+    return(i_db_file + ".journal");
+}
+
+/**
+* read records of the journal, incomplete last record (interrupted append) is skipped and cut off
+* the journal, so the next append doesn't continue it
+*
+* @param i_db_file
+*   dictionary file
+*
+* @param o_records
+*   output: records in the order they were appended
+*
+* @return bool
+*   false if there is no journal
+*/
+bool SmkyJournal::read (const std::string& i_db_file, std::vector<std::string>& o_records)
+{
+    o_records.clear();
+
+    std::string path = getPath(i_db_file);
+    std::ifstream fin(path.c_str());
+
+    if (!fin.is_open())
+        return(false);
+
+    std::string line;
+    off_t complete_length = 0;
+    bool torn = false;
+
+    while (getline(fin, line))
+    {
+        //getline stops at the end of file if there was no newline
+        if (fin.eof())
+        {
+            torn = !line.empty();
+            break;
+        }
+
+        complete_length += line.length() + 1;
+
+        if (line.length() > 1 && (line[0] == RECORD_ADD || line[0] == RECORD_REMOVE))
+            o_records.push_back(line);
+    }
+
+    fin.close();
+
+    if (torn)
+    {
+        g_warning("Journal: dropping incomplete record in '%s'", path.c_str());
+
+        if (truncate(path.c_str(), complete_length) != 0)
+            g_warning("Journal: can't truncate '%s' (%s)", path.c_str(), strerror(errno));
+    }
+
+    return(true);
+}
+
+/**
+* check that the entry can be stored as one record (line) of the journal and the dictionary file
+*
+* @param i_entry
+*   word or value
+*
+* @return bool
+*   false if the entry contains a line break
+*/
+bool SmkyJournal::isValidEntry (const std::string& i_entry)
+{
+    return(i_entry.find_first_of("\r\n") == std::string::npos);
+}
+
+/**
+* append records to the journal
+*
+* @param i_db_file
+*   dictionary file
+*
+* @param i_records
+*   records
+*
+* @return bool
+*   true if all records were written
+*/
+bool SmkyJournal::append (const std::string& i_db_file, const std::vector<std::string>& i_records)
+{
+    if (i_records.empty())
+        return(true);
+
+    std::string data;
+    for (size_t i = 0; i < i_records.size(); ++i)
+    {
+        data += i_records[i];
+        data += '\n';
+    }
+
+    std::string path = getPath(i_db_file);
+    int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+
+    if (fd < 0)
+    {
+        g_warning("Journal: can't open '%s' (%s)", path.c_str(), strerror(errno));
+        return(false);
+    }
+
+    bool result = _writeAll(fd, data) && _sync(fd, SYNC_ALWAYS);
+
+    if (!result)
+        g_warning("Journal: can't append to '%s' (%s)", path.c_str(), strerror(errno));
+
+    close(fd);
+
+    return(result);
+}
+
+/**
+* remove journal
+*
+* @param i_db_file
+*   dictionary file
+*/
+void SmkyJournal::remove (const std::string& i_db_file)
+{
+    unlink(getPath(i_db_file).c_str());
+}
+
+/**
+* replace content of the dictionary file: data is written to a temporary file in the same directory,
+* which is renamed over the dictionary file
+*
+* @param i_db_file
+*   dictionary file
+*
+* @param i_data
+*   new content of the file (may be empty)
+*
+* @return bool
+*   true if the file was replaced
+*/
+bool SmkyJournal::writeSnapshot (const std::string& i_db_file, const std::string& i_data)
+{
+    std::string tmp_path = i_db_file + ".tmp";
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0)
+    {
+        g_warning("Journal: can't create '%s' (%s)", tmp_path.c_str(), strerror(errno));
+        return(false);
+    }
+
+    bool result = _writeAll(fd, i_data) && _sync(fd, SYNC_SNAPSHOT);
+
+    if (close(fd) != 0)
+        result = false;
+
+    if (result && rename(tmp_path.c_str(), i_db_file.c_str()) == 0)
+    {
+        //make the rename itself durable
+        gchar* p_dir = g_path_get_dirname(i_db_file.c_str());
+        int dir_fd = open(p_dir, O_RDONLY);
+
+        if (dir_fd >= 0)
+        {
+            _sync(dir_fd, SYNC_SNAPSHOT);
+            close(dir_fd);
+        }
+
+        g_free(p_dir);
+        return(true);
+    }
+
+    g_warning("Journal: can't write '%s' (%s)", i_db_file.c_str(), strerror(errno));
+    unlink(tmp_path.c_str());
+
+    return(false);
+}
+
+/**
+* write whole buffer, write() is repeated only if it was interrupted or written partially
+*
+* @param i_fd
+*   file descriptor
+*
+* @param i_data
+*   data
+*
+* @return bool
+*   true if all data was written
+*/
+bool SmkyJournal::_writeAll (int i_fd, const std::string& i_data)
+{
+    const char* p_data = i_data.data();
+    size_t left = i_data.length();
+
+    while (left > 0)
+    {
+        ssize_t written = write(i_fd, p_data, left);
+
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return(false);
+        }
+
+        p_data += written;
+        left -= written;
+    }
+
+    return(true);
+}
+
+/**
+* fsync the file if Settings::syncPolicy is at least i_level
+*
+* @param i_fd
+*   file descriptor
+*
+* @param i_level
+*   policy level which requires fsync
+*
+* @return bool
+*   false if fsync failed
+*/
+bool SmkyJournal::_sync (int i_fd, SyncPolicy i_level)
+{
+    if (Settings::getInstance()->syncPolicy < i_level)
+        return(true);
+
+    return(fsync(i_fd) == 0);
+}
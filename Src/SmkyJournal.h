@@ -0,0 +1,80 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SMKY_JOURNAL_H
+#define SMKY_JOURNAL_H
+
+#include <string>
+#include <vector>
+
+namespace SmartKey
+{
+
+/**
+ * Append-only journal of changes of a read/write dictionary (<file>.journal next to the dictionary).
+ * Every record is one line: '+' or '-' followed by the entry. Changes are appended to the journal
+ * instead of rewriting the dictionary; the dictionary file (snapshot) is rewritten and the journal
+ * is removed only when the journal grows over COMPACT_RECORDS.
+ * The snapshot is written to a temporary file which is renamed over the dictionary,
+ * so the dictionary file is either old or new one after a crash.
+ */
+class SmkyJournal
+{
+public:
+    enum { COMPACT_RECORDS = 1000 };
+
+    //values of Settings::syncPolicy
+    enum SyncPolicy
+    {
+        SYNC_NEVER = 0,
+        SYNC_SNAPSHOT = 1,
+        SYNC_ALWAYS = 2
+    };
+
+    static const char RECORD_ADD = '+';
+    static const char RECORD_REMOVE = '-';
+
+    //get path of journal of the dictionary
+    static std::string getPath (const std::string& i_db_file);
+
+    //read complete records of the journal and cut off an incomplete one, return false if there is no journal
+    static bool read (const std::string& i_db_file, std::vector<std::string>& o_records);
+
+    //false if the entry can't be stored as a single record (contains a line break)
+    static bool isValidEntry (const std::string& i_entry);
+
+    //append records to the journal with a single write
+    static bool append (const std::string& i_db_file, const std::vector<std::string>& i_records);
+
+    //remove journal (after the dictionary was rewritten)
+    static void remove (const std::string& i_db_file);
+
+    //replace content of the dictionary file atomically
+    static bool writeSnapshot (const std::string& i_db_file, const std::string& i_data);
+
+private:
+    //write whole buffer to the file descriptor
+    static bool _writeAll (int i_fd, const std::string& i_data);
+
+    //fsync the file descriptor if allowed by settings
+    static bool _sync (int i_fd, SyncPolicy i_level);
+};
+
+}
+
+#endif
@@ -0,0 +1,256 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "SmkyKeyboardLayout.h"
+#include <glib.h>
+#include <ctype.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+using namespace SmartKey;
+
+static const int k_rows_count = 3;
+
+//substitution of adjacent keys costs about 2/3 of an edit, keys two rows or columns apart cost a full edit
+static const int k_near_key_cost = 30;
+static const int k_key_distance_cost = 35;
+
+static const char* k_qwerty_rows[k_rows_count] = { "qwertyuiop", "asdfghjkl", "zxcvbnm" };
+static const char* k_azerty_rows[k_rows_count] = { "azertyuiop", "qsdfghjklm", "wxcvbn" };
+static const char* k_qwertz_rows[k_rows_count] = { "qwertzuiop", "asdfghjkl", "yxcvbnm" };
+
+/**
+* get key from the row, 0 if out of the row
+*/
+static char key_at (const char* ip_row, int i_col)
+{
+    if (i_col < 0 || i_col >= (int)strlen(ip_row))
+        return(0);
+
+    return(ip_row[i_col]);
+}
+
+/**
+* SmkyKeyboardLayout
+*/
+SmkyKeyboardLayout::SmkyKeyboardLayout (void)
+{
+    load("qwerty");
+}
+
+/**
+* ~SmkyKeyboardLayout
+*/
+SmkyKeyboardLayout::~SmkyKeyboardLayout (void)
+{
+}
+
+/**
+* load layout by name
+*
+* @param i_name
+*   layout name ("qwerty", "azerty", "qwertz")
+*/
+void SmkyKeyboardLayout::load (const std::string& i_name)
+{
+    const char** p_rows = k_qwerty_rows;
+    m_name = "qwerty";
+
+    if (i_name == "azerty")
+    {
+        p_rows = k_azerty_rows;
+        m_name = i_name;
+    }
+    else if (i_name == "qwertz")
+    {
+        p_rows = k_qwertz_rows;
+        m_name = i_name;
+    }
+    else if (!i_name.empty() && i_name != "qwerty")
+    {
+        g_debug("KeyboardLayout: unknown layout '%s', using qwerty", i_name.c_str());
+    }
+
+    for (int i = 0; i < 256; ++i)
+    {
+        m_neighbours[i].clear();
+        m_positions[i].x = -1;
+        m_positions[i].y = -1;
+    }
+
+    //rows are staggered: key (row, col) touches (row-1, col), (row-1, col+1), (row+1, col-1) and (row+1, col)
+    for (int row = 0; row < k_rows_count; ++row)
+    {
+        for (int col = 0; p_rows[row][col]; ++col)
+        {
+            std::string& neighbours = m_neighbours[(unsigned char)p_rows[row][col]];
+            KeyPosition& position = m_positions[(unsigned char)p_rows[row][col]];
+            char candidates[6];
+
+            position.x = col * 2 + row;
+            position.y = row * 2;
+
+            candidates[0] = key_at(p_rows[row], col - 1);
+            candidates[1] = key_at(p_rows[row], col + 1);
+            candidates[2] = row > 0 ? key_at(p_rows[row - 1], col) : 0;
+            candidates[3] = row > 0 ? key_at(p_rows[row - 1], col + 1) : 0;
+            candidates[4] = row + 1 < k_rows_count ? key_at(p_rows[row + 1], col - 1) : 0;
+            candidates[5] = row + 1 < k_rows_count ? key_at(p_rows[row + 1], col) : 0;
+
+            for (int i = 0; i < 6; ++i)
+            {
+                if (candidates[i])
+                    neighbours.push_back(candidates[i]);
+            }
+        }
+    }
+}
+
+/**
+* get keys adjacent to the key
+*
+* @param i_key
+*   key (case insensitive)
+*
+* @return const std::string&
+*   lower case neighbour keys, empty if key is unknown
+*/
+const std::string& SmkyKeyboardLayout::getNeighbours (char i_key) const
+{
+    return(m_neighbours[(unsigned char)tolower((unsigned char)i_key)]);
+}
+
+/**
+* position of the letter
+*
+* @param i_key
+*   letter (case insensitive)
+*
+* @return const KeyPosition*
+*   position, NULL if letter is not on the layout
+*/
+const SmkyKeyboardLayout::KeyPosition* SmkyKeyboardLayout::_getPosition (gunichar i_key) const
+{
+    if (i_key >= 0x80)
+        return(NULL);
+
+    const KeyPosition* p_position = &m_positions[tolower((int)i_key)];
+    return(p_position->x < 0 ? NULL : p_position);
+}
+
+/**
+* cost of typing a letter instead of another one
+*
+* @param i_typed
+*   typed letter
+*
+* @param i_intended
+*   letter of the candidate word
+*
+* @return int
+*   0 for the same letter (case insensitive), EDIT_COST for letters far away or not on the layout
+*/
+int SmkyKeyboardLayout::getSubstitutionCost (gunichar i_typed, gunichar i_intended) const
+{
+    if (i_typed == i_intended || g_unichar_tolower(i_typed) == g_unichar_tolower(i_intended))
+        return(0);
+
+    const KeyPosition* p_typed = _getPosition(i_typed);
+    const KeyPosition* p_intended = _getPosition(i_intended);
+
+    if (!p_typed || !p_intended)
+        return(EDIT_COST);
+
+    int dx = p_typed->x - p_intended->x;
+    int dy = p_typed->y - p_intended->y;
+
+    //positions are in half key units
+    int cost = k_near_key_cost + (int)(k_key_distance_cost * sqrt((double)(dx * dx + dy * dy)) / 2);
+
+    return(std::min(cost, (int)EDIT_COST));
+}
+
+/**
+* edit distance (with transpositions of adjacent letters), where substitutions are weighted by keys distance,
+* letters are compared case insensitive
+*
+* @param i_typed
+*   typed word (UTF-8)
+*
+* @param i_intended
+*   candidate word (UTF-8)
+*
+* @param i_weighted
+*   weight substitutions by keys distance, otherwise any substitution costs EDIT_COST
+*
+* @return int
+*   distance, EDIT_COST per insertion, deletion or transposition
+*/
+int SmkyKeyboardLayout::getDistance (const std::string& i_typed, const std::string& i_intended, bool i_weighted) const
+{
+    glong typed_len = 0;
+    glong intended_len = 0;
+    gunichar* p_typed = g_utf8_to_ucs4_fast(i_typed.c_str(), -1, &typed_len);
+    gunichar* p_intended = g_utf8_to_ucs4_fast(i_intended.c_str(), -1, &intended_len);
+
+    //letters are compared case insensitive, by substitutions and transpositions alike
+    for (glong i = 0; i < typed_len; ++i)
+        p_typed[i] = g_unichar_tolower(p_typed[i]);
+
+    for (glong j = 0; j < intended_len; ++j)
+        p_intended[j] = g_unichar_tolower(p_intended[j]);
+
+    //three rows of the matrix are enough with transpositions
+    std::vector<int> prev2(intended_len + 1), prev(intended_len + 1), cur(intended_len + 1);
+
+    for (glong j = 0; j <= intended_len; ++j)
+        prev[j] = j * EDIT_COST;
+
+    for (glong i = 1; i <= typed_len; ++i)
+    {
+        cur[0] = i * EDIT_COST;
+
+        for (glong j = 1; j <= intended_len; ++j)
+        {
+            int best = std::min(prev[j], cur[j - 1]) + EDIT_COST;
+            int substitution = getSubstitutionCost(p_typed[i - 1], p_intended[j - 1]);
+
+            if (!i_weighted && substitution > 0)
+                substitution = EDIT_COST;
+
+            best = std::min(best, prev[j - 1] + substitution);
+
+            if (i > 1 && j > 1 && p_typed[i - 1] == p_intended[j - 2] && p_typed[i - 2] == p_intended[j - 1])
+                best = std::min(best, prev2[j - 2] + EDIT_COST);
+
+            cur[j] = best;
+        }
+
+        prev2.swap(prev);
+        prev.swap(cur);
+    }
+
+    int distance = prev[intended_len];
+
+    g_free(p_typed);
+    g_free(p_intended);
+
+    return(distance);
+}
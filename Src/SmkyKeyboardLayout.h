@@ -0,0 +1,90 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SMKY_KEYBOARD_LAYOUT_H
+#define SMKY_KEYBOARD_LAYOUT_H
+
+#include <string>
+#include <glib.h>
+
+namespace SmartKey
+{
+
+/**
+ * Geometry of the letter keys for the supported keyboard layouts (qwerty, azerty, qwertz).
+ * Only latin letters are known, any other symbol has no neighbours.
+ */
+class SmkyKeyboardLayout
+{
+public:
+    //cost of a single edit (insertion, deletion, transposition, substitution of distant keys)
+    enum { EDIT_COST = 100 };
+
+private:
+    //position of the key, in half key units (rows are staggered by half key)
+    struct KeyPosition
+    {
+        int x;
+        int y;
+    };
+
+    //name of loaded layout
+    std::string m_name;
+
+    //neighbour keys (lower case) for every lower case letter
+    std::string m_neighbours[256];
+
+    //positions of lower case letters, x < 0 for unknown symbols
+    KeyPosition m_positions[256];
+
+public:
+
+    SmkyKeyboardLayout (void);
+    virtual ~SmkyKeyboardLayout (void);
+
+    //load layout by name ("qwerty", "azerty", "qwertz"), unknown names fall back to qwerty
+    void load (const std::string& i_name);
+
+    //name of loaded layout
+    const std::string& getName (void) const;
+
+    //get keys adjacent to the key (case insensitive), empty for unknown symbols
+    const std::string& getNeighbours (char i_key) const;
+
+    //cost of typing i_typed instead of i_intended: 0 for the same letter, cheaper for closer keys
+    int getSubstitutionCost (gunichar i_typed, gunichar i_intended) const;
+
+    //edit distance weighted by keys distance (or plain, if not weighted), in EDIT_COST units (case insensitive)
+    int getDistance (const std::string& i_typed, const std::string& i_intended, bool i_weighted = true) const;
+
+private:
+    //position of the letter, NULL if it is not on the layout
+    const KeyPosition* _getPosition (gunichar i_key) const;
+};
+
+/**
+* name of loaded layout
+*/
+inline const std::string& SmkyKeyboardLayout::getName (void) const
+{
+    return(m_name);
+}
+
+}
+
+#endif
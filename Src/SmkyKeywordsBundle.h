@@ -28,6 +28,7 @@ namespace SmartKey
  * wrapper around SmkyFileKeywords to support locale-independent and locale-dependent dictionaries,
  * idia is to combine locale independent dictionary with locale dependent using one interface.
  * m_independent_dict is for static words set and never changed.
+ * Locale-dependent dictionary can be loaded separately (e.g. in background) and swapped in.
  */
 class SmkyKeywordsBundle
 {
@@ -36,11 +37,15 @@ private:
     SmkyFileKeywords m_independent_dict;
 
     //locale-dependent dictionary
-    SmkyFileKeywords m_dependent_dict;
+    SmkyFileKeywords* mp_dependent_dict;
+
+    //locale-dependent dictionary was swapped since the last takeAddedKeys()
+    bool m_dependent_swapped;
 
 public:
 
-    virtual ~SmkyKeywordsBundle (void) {};
+    SmkyKeywordsBundle (void) : mp_dependent_dict(new SmkyFileKeywords()), m_dependent_swapped(true) {};
+    virtual ~SmkyKeywordsBundle (void) { delete mp_dependent_dict; };
 
     //load dictionary according to current locale settings
     virtual void load (std::string i_independent_dict, std::string i_dependent_dict);
@@ -63,9 +68,27 @@ public:
     //find by prefix
     virtual std::string find_by_prefix (const std::string& prefix);
 
+    //find up to max words by prefix (in sorted order), append them to o_words
+    virtual void find_all_by_prefix (const std::string& prefix, size_t max, std::list<std::string>& o_words);
+
     //export all strings to external list
     virtual void exportToList (std::list<std::string>& o_entries);
 
+    //export pointers to all strings, they are valid until the bundle is changed
+    void exportKeys (std::vector<const char*>& o_keys);
+
+    //append keys added since the last call, return false if exported keys became stale meanwhile
+    bool takeAddedKeys (std::vector<const char*>& o_keys);
+
+    //replace locale-dependent dictionary, return the previous one (caller owns it)
+    SmkyFileKeywords* swapDependent (SmkyFileKeywords* ip_dependent_dict);
+
+    //append memory usage and load time of both dictionaries (as 'name' and 'name-locale')
+    void getStats (const std::string& i_name, std::vector<DictionaryStats>& o_stats) const;
+
+private:
+    SmkyKeywordsBundle (const SmkyKeywordsBundle&);     // don't implement
+    void operator= (const SmkyKeywordsBundle&);         // don't implement
 };
 
 /**
@@ -73,7 +96,7 @@ public:
 */
 inline void SmkyKeywordsBundle::load (std::string i_independent_dict, std::string i_dependent_dict)
 {
-    m_dependent_dict.load(i_dependent_dict);
+    mp_dependent_dict->load(i_dependent_dict);
 
     if(!m_independent_dict.isInitialized())
         m_independent_dict.load(i_independent_dict);
@@ -84,7 +107,7 @@ inline void SmkyKeywordsBundle::load (std::string i_independent_dict, std::strin
 */
 inline bool SmkyKeywordsBundle::save (std::string i_dependent_dict)
 {
-    return( m_dependent_dict.save(i_dependent_dict) );
+    return( mp_dependent_dict->save(i_dependent_dict) );
 }
 
 /**
@@ -92,7 +115,7 @@ inline bool SmkyKeywordsBundle::save (std::string i_dependent_dict)
 */
 inline int SmkyKeywordsBundle::size (void)
 {
-    return (m_independent_dict.size() + m_dependent_dict.size());
+    return (m_independent_dict.size() + mp_dependent_dict->size());
 }
 
 /**
@@ -100,7 +123,7 @@ inline int SmkyKeywordsBundle::size (void)
 */
 inline void SmkyKeywordsBundle::add (std::string i_key)
 {
-    m_dependent_dict.add(i_key);
+    mp_dependent_dict->add(i_key);
 }
 
 /**
@@ -108,7 +131,7 @@ inline void SmkyKeywordsBundle::add (std::string i_key)
 */
 inline bool SmkyKeywordsBundle::remove (std::string i_key)
 {
-    return(m_dependent_dict.remove(i_key));
+    return(mp_dependent_dict->remove(i_key));
 }
 
 /**
@@ -116,7 +139,7 @@ inline bool SmkyKeywordsBundle::remove (std::string i_key)
 */
 inline bool SmkyKeywordsBundle::find (const std::string& shortcut)
 {
-    return(m_independent_dict.find(shortcut) || m_dependent_dict.find(shortcut));
+    return(m_independent_dict.find(shortcut) || mp_dependent_dict->find(shortcut));
 }
 
 /**
@@ -134,7 +157,29 @@ inline std::string SmkyKeywordsBundle::find_by_prefix (const std::string& prefix
     if(retval.length() > 0)
         return( retval );
 
-    return( m_dependent_dict.find_by_prefix(prefix) );
+    return( mp_dependent_dict->find_by_prefix(prefix) );
+}
+
+/**
+* find words with specified prefix in both dictionaries
+*
+* @param prefix
+*   prefix to search
+*
+* @param max
+*   limit number of words
+*
+* @param o_words
+*   output: found words are appended (locale independent dictionary first)
+*/
+inline void SmkyKeywordsBundle::find_all_by_prefix (const std::string& prefix, size_t max, std::list<std::string>& o_words)
+{
+    size_t count = o_words.size();
+    m_independent_dict.find_all_by_prefix(prefix, max, o_words);
+
+    count = o_words.size() - count;
+    if (count < max)
+        mp_dependent_dict->find_all_by_prefix(prefix, max - count, o_words);
 }
 
 /**
@@ -143,7 +188,79 @@ inline std::string SmkyKeywordsBundle::find_by_prefix (const std::string& prefix
 inline void SmkyKeywordsBundle::exportToList (std::list<std::string>& o_entries)
 {
     m_independent_dict.exportToList(o_entries);
-    m_dependent_dict.exportToList(o_entries);
+    mp_dependent_dict->exportToList(o_entries);
+}
+
+/**
+* export pointers to all strings
+*/
+inline void SmkyKeywordsBundle::exportKeys (std::vector<const char*>& o_keys)
+{
+    m_independent_dict.exportKeys(o_keys);
+    mp_dependent_dict->exportKeys(o_keys);
+}
+
+/**
+* append keys added to both dictionaries since the last call
+*
+* @param o_keys
+*   output: added keys are appended
+*
+* @return bool
+*   false if keys exported before are stale (e.g. dictionary was swapped)
+*/
+inline bool SmkyKeywordsBundle::takeAddedKeys (std::vector<const char*>& o_keys)
+{
+    //both dictionaries forget their changes
+    bool valid = m_independent_dict.takeAddedKeys(o_keys);
+    valid = mp_dependent_dict->takeAddedKeys(o_keys) && valid;
+    valid = !m_dependent_swapped && valid;
+
+    m_dependent_swapped = false;
+
+    return(valid);
+}
+
+/**
+* append memory usage and load time of both dictionaries
+*
+* @param i_name
+*   name of the bundle, locale dependent dictionary is named 'i_name-locale'
+*
+* @param o_stats
+*   output: statistics are appended
+*/
+inline void SmkyKeywordsBundle::getStats (const std::string& i_name, std::vector<DictionaryStats>& o_stats) const
+{
+    DictionaryStats stats;
+
+    stats.name = i_name;
+    m_independent_dict.getStats(stats);
+    o_stats.push_back(stats);
+
+    stats.name = i_name + "-locale";
+    mp_dependent_dict->getStats(stats);
+    o_stats.push_back(stats);
+}
+
+/**
+* replace locale-dependent dictionary
+*
+* @param ip_dependent_dict
+*   loaded dictionary, bundle takes ownership
+*
+* @return SmkyFileKeywords*
+*   previous dictionary, caller releases it
+*/
+inline SmkyFileKeywords* SmkyKeywordsBundle::swapDependent (SmkyFileKeywords* ip_dependent_dict)
+{
+    SmkyFileKeywords* p_previous = mp_dependent_dict;
+    mp_dependent_dict = ip_dependent_dict;
+    m_dependent_swapped = true;
+
+    changeDictionaryGeneration();
+
+    return(p_previous);
 }
 
 }
@@ -0,0 +1,75 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "SmkyKnownWords.h"
+#include <string.h>
+
+using namespace SmartKey;
+
+/**
+* drop content
+*
+* @param i_expected_words
+*   number of words which will be added (words of all layers)
+*/
+void SmkyKnownWords::reset (size_t i_expected_words)
+{
+    m_layers.clear();
+    m_layers.reserve(i_expected_words);
+    m_filter.reset(i_expected_words);
+    m_expected = i_expected_words;
+}
+
+/**
+* add word of the layer
+*
+* @param ip_word
+*   word owned by a dictionary
+*
+* @param i_layer
+*   layer (dictionary) of the word
+*/
+void SmkyKnownWords::add (const char* ip_word, Layer i_layer)
+{
+    size_t length = strlen(ip_word);
+    std::pair<LayersMap::Entry*, bool> res = m_layers.insert(ip_word, length, i_layer, ip_word);
+
+    if (res.second)
+        m_filter.add(ip_word, length);
+    else
+        res.first->value |= i_layer;
+}
+
+/**
+* get layers containing the word
+*
+* @param i_word
+*   word to find
+*
+* @return unsigned int
+*   bits of Layer, 0 if the word is in none of them
+*/
+unsigned int SmkyKnownWords::find (const std::string& i_word) const
+{
+    if (!m_filter.mayContain(i_word))
+        return(0);
+
+    const LayersMap::Entry* p_entry = m_layers.find(i_word);
+
+    return(p_entry ? p_entry->value : 0);
+}
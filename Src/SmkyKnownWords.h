@@ -0,0 +1,107 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SMKY_KNOWN_WORDS_H
+#define SMKY_KNOWN_WORDS_H
+
+#include <string>
+#include "SmkyBloomFilter.h"
+#include "SmkyFlatTable.h"
+
+namespace SmartKey
+{
+
+/**
+ * Words of several dictionaries merged into one table: every word is stored once
+ * together with bits of the dictionaries (layers) which contain it, so one lookup answers
+ * for all of them. Bloom filter in front of the table rejects most of unknown words.
+ * Words aren't copied, the table refers to strings of the dictionaries: added words can be added
+ * to the table, but it must be rebuilt (or not used) as soon as any word is erased or moved.
+ */
+class SmkyKnownWords
+{
+public:
+    enum Layer
+    {
+        LAYER_WHITELIST = 1 << 0,
+        LAYER_AUTOSUB = 1 << 1,
+        LAYER_MANUFACTURER = 1 << 2,
+        LAYER_USER = 1 << 3
+    };
+
+private:
+    typedef SmkyFlatTable<unsigned int> LayersMap;
+
+    SmkyBloomFilter m_filter;
+    LayersMap m_layers;
+
+    //number of words the filter was sized for
+    size_t m_expected;
+
+public:
+    SmkyKnownWords (void) : m_expected(0) {}
+
+    //drop content, expected number of words is used to size the filter
+    void reset (size_t i_expected_words);
+
+    //add word of the layer, the word must stay valid while it is in the table
+    void add (const char* ip_word, Layer i_layer);
+
+    //get layers containing the word (0 - unknown word)
+    unsigned int find (const std::string& i_word) const;
+
+    //number of different words
+    size_t size (void) const;
+
+    //can more words be added without raising false positive rate of the filter?
+    bool hasRoom (size_t i_words) const;
+
+    //bytes allocated for the table and the filter (words belong to dictionaries)
+    size_t memoryUsed (void) const;
+};
+
+/**
+* number of different words
+*/
+inline size_t SmkyKnownWords::size (void) const
+{
+    return(m_layers.size());
+}
+
+/**
+* can more words be added without raising false positive rate of the filter?
+*
+* @param i_words
+*   number of words to add
+*/
+inline bool SmkyKnownWords::hasRoom (size_t i_words) const
+{
+    return(m_layers.size() + i_words <= m_expected);
+}
+
+/**
+* bytes allocated for the table and the filter
+*/
+inline size_t SmkyKnownWords::memoryUsed (void) const
+{
+    return(m_layers.memoryUsed() + m_filter.memoryUsed());
+}
+
+}
+
+#endif
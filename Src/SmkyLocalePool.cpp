@@ -0,0 +1,155 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#include "SmkyLocalePool.h"
+
+using namespace SmartKey;
+
+/**
+* SmkyLocalePool
+*/
+SmkyLocalePool::SmkyLocalePool (void)
+    : m_bytes(0)
+    , m_max_entries(0)
+    , m_max_bytes(0)
+{
+}
+
+/**
+* ~SmkyLocalePool
+*/
+SmkyLocalePool::~SmkyLocalePool (void)
+{
+    clear();
+}
+
+/**
+* key of dictionaries of the locale: paths of all the dictionaries depend on input language and
+* device country only (see Settings::getDBFilePath), so other device language or keyboard layout
+* reuse them (keyboard layout is set by the caller)
+*
+* @param i_locale
+*   locale settings
+*
+* @return std::string
+*   key
+*/
+std::string SmkyLocalePool::_getKey (const LocaleSettings& i_locale)
+{
+    return(i_locale.getLanguageCountryLocale());
+}
+
+/**
+* set limits of kept locales, dictionaries exceeding them are released at once
+*
+* @param i_max_entries
+*   max number of kept locales (0 - pool is disabled)
+*
+* @param i_max_bytes
+*   max estimated memory of kept dictionaries (0 - no limit)
+*/
+void SmkyLocalePool::configure (size_t i_max_entries, size_t i_max_bytes)
+{
+    m_max_entries = i_max_entries;
+    m_max_bytes = i_max_bytes;
+
+    _evict();
+}
+
+/**
+* remove dictionaries of the locale from the pool, caller takes ownership
+*
+* @param i_locale
+*   locale settings
+*
+* @return SmkyLocaleDictionaries*
+*   dictionaries, NULL if there are no such ones
+*/
+SmkyLocaleDictionaries* SmkyLocalePool::take (const LocaleSettings& i_locale)
+{
+    std::string key = _getKey(i_locale);
+
+    for (EntryList::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+        if (it->key == key)
+        {
+            SmkyLocaleDictionaries* p_dicts = it->dicts;
+            m_bytes -= it->bytes;
+            m_entries.erase(it);
+
+            return(p_dicts);
+        }
+    }
+
+    return(NULL);
+}
+
+/**
+* keep dictionaries as the most recently used ones, dictionaries of the same locale kept
+* before are replaced
+*
+* @param ip_dicts
+*   dictionaries labeled by their locale, pool takes ownership
+*/
+void SmkyLocalePool::put (SmkyLocaleDictionaries* ip_dicts)
+{
+    if (!ip_dicts)
+        return;
+
+    delete take(ip_dicts->locale);
+
+    Entry entry;
+    entry.key = _getKey(ip_dicts->locale);
+    entry.dicts = ip_dicts;
+    entry.bytes = ip_dicts->memoryUsed();
+
+    m_entries.push_front(entry);
+    m_bytes += entry.bytes;
+
+    _evict();
+}
+
+/**
+* release all kept dictionaries
+*/
+void SmkyLocalePool::clear (void)
+{
+    for (EntryList::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+        delete it->dicts;
+
+    m_entries.clear();
+    m_bytes = 0;
+}
+
+/**
+* release least recently used dictionaries while there are too many of them or they take too much memory
+*/
+void SmkyLocalePool::_evict (void)
+{
+    while (!m_entries.empty() && (m_entries.size() > m_max_entries || (m_max_bytes && m_bytes > m_max_bytes)))
+    {
+        Entry& entry = m_entries.back();
+
+        g_debug("LocalePool: releasing dictionaries of '%s' (%u bytes)", entry.key.c_str(), (unsigned int)entry.bytes);
+
+        m_bytes -= entry.bytes;
+        delete entry.dicts;
+        m_entries.pop_back();
+    }
+}
@@ -0,0 +1,106 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef SMKY_LOCALE_POOL_H
+#define SMKY_LOCALE_POOL_H
+
+#include <list>
+#include <string>
+#include "Settings.h"
+#include "SmkySpellCheckEngine.h"
+
+namespace SmartKey
+{
+
+/**
+ * Dictionaries of recently used locales which are not the current one, so switching back
+ * to such locale just swaps them in (see SmkySpellCheckEngine::swapLocale()) instead of loading.
+ * The least recently used locale is dropped when there are too many of them or they take
+ * more memory than allowed. Used on the main loop only.
+ */
+class SmkyLocalePool
+{
+private:
+    struct Entry
+    {
+        std::string             key;
+        SmkyLocaleDictionaries* dicts;
+        size_t                  bytes;
+    };
+
+    typedef std::list<Entry> EntryList;
+
+    EntryList m_entries;        ///< Most recently used first
+    size_t    m_bytes;
+    size_t    m_max_entries;
+    size_t    m_max_bytes;
+
+public:
+
+    SmkyLocalePool (void);
+    virtual ~SmkyLocalePool (void);
+
+    //set limits of kept locales (0 entries - pool is disabled, 0 bytes - no memory limit)
+    void configure (size_t i_max_entries, size_t i_max_bytes);
+
+    //remove dictionaries of the locale from the pool, NULL if there are no such ones
+    SmkyLocaleDictionaries* take (const LocaleSettings& i_locale);
+
+    //keep dictionaries (labeled by their locale), pool takes ownership and may release them at once
+    void put (SmkyLocaleDictionaries* ip_dicts);
+
+    //release all kept dictionaries
+    void clear (void);
+
+    //number of kept locales
+    size_t size (void) const;
+
+    //estimated memory used by kept dictionaries (bytes)
+    size_t memoryUsed (void) const;
+
+private:
+    //key of dictionaries of the locale
+    static std::string _getKey (const LocaleSettings& i_locale);
+
+    //release least recently used dictionaries exceeding the limits
+    void _evict (void);
+
+    SmkyLocalePool (const SmkyLocalePool&);     // don't implement
+    void operator= (const SmkyLocalePool&);     // don't implement
+};
+
+/**
+* number of kept locales
+*/
+inline size_t SmkyLocalePool::size (void) const
+{
+    return(m_entries.size());
+}
+
+/**
+* estimated memory used by kept dictionaries (bytes)
+*/
+inline size_t SmkyLocalePool::memoryUsed (void) const
+{
+    return(m_bytes);
+}
+
+}
+
+#endif
@@ -52,6 +52,18 @@ public:
     //find word by prefix
     virtual std::string findWordByPrefix (const std::string& prefix);
 
+    //find up to max words by prefix, append them to o_words
+    virtual void findWordsByPrefix (const std::string& prefix, size_t max, std::list<std::string>& o_words);
+
+    //export pointers to all words, they are valid until the database is changed
+    void exportWords (std::vector<const char*>& o_words);
+
+    //append words added since the last call, return false if exported words became stale meanwhile
+    bool takeAddedWords (std::vector<const char*>& o_words);
+
+    //append memory usage and load time of the dictionaries
+    void getStats (std::vector<DictionaryStats>& o_stats) const;
+
     //save dictionary
     virtual SmartKeyErrorCode save (void);
 
@@ -124,6 +136,59 @@ inline std::string SmkyManufacturerDatabase::findWordByPrefix (const std::string
     return( m_dictionary.find_by_prefix(prefix) );
 }
 
+/**
+* find words with prefix in database
+*
+* @param prefix
+*   prefix to search
+*
+* @param max
+*   limit number of words
+*
+* @param o_words
+*   output: found words are appended
+*/
+inline void SmkyManufacturerDatabase::findWordsByPrefix (const std::string& prefix, size_t max, std::list<std::string>& o_words)
+{
+    m_dictionary.find_all_by_prefix(prefix, max, o_words);
+}
+
+/**
+* export all words of the database
+*
+* @param o_words
+*   output: words are appended
+*/
+inline void SmkyManufacturerDatabase::exportWords (std::vector<const char*>& o_words)
+{
+    m_dictionary.exportKeys(o_words);
+}
+
+/**
+* append words added since the last call
+*
+* @param o_words
+*   output: added words are appended
+*
+* @return bool
+*   false if words exported before are stale, all of them must be exported again
+*/
+inline bool SmkyManufacturerDatabase::takeAddedWords (std::vector<const char*>& o_words)
+{
+    return(m_dictionary.takeAddedKeys(o_words));
+}
+
+/**
+* append memory usage and load time of the dictionaries
+*
+* @param o_stats
+*   output: statistics are appended
+*/
+inline void SmkyManufacturerDatabase::getStats (std::vector<DictionaryStats>& o_stats) const
+{
+    m_dictionary.getStats("manufacturer", o_stats);
+}
+
 }
 
 #endif
@@ -0,0 +1,95 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "SmkyPrefixIndex.h"
+
+using namespace SmartKey;
+
+/**
+* remove string from the index,
+* several equal strings can be indexed (values of pairs), so match by address
+*
+* @param ip_word
+*   pointer to the string owned by dictionary
+*/
+void SmkyPrefixIndex::erase (const char* ip_word)
+{
+    std::pair<IndexSet::iterator, IndexSet::iterator> range = m_index.equal_range(ip_word);
+
+    for (IndexSet::iterator it = range.first; it != range.second; ++it)
+    {
+        if (*it == ip_word)
+        {
+            m_index.erase(it);
+            return;
+        }
+    }
+}
+
+/**
+* find first string (in sorted order) which starts with prefix
+*
+* @param prefix
+*   prefix to search
+*
+* @return const char*
+*   NULL if nothing found
+*/
+const char* SmkyPrefixIndex::findFirst (const std::string& prefix) const
+{
+    IndexSet::const_iterator it = m_index.lower_bound(prefix.c_str());
+
+    if (it != m_index.end() && strncmp(*it, prefix.c_str(), prefix.length()) == 0)
+    {
+        return(*it);
+    }
+
+    return(NULL);
+}
+
+/**
+* find strings starting with prefix: one seek and a step per string,
+* equal strings (values of pairs) are reported once
+*
+* @param prefix
+*   prefix to search
+*
+* @param i_max
+*   limit number of strings
+*
+* @param o_words
+*   output: found strings are appended in sorted order
+*/
+void SmkyPrefixIndex::findAll (const std::string& prefix, size_t i_max, std::list<std::string>& o_words) const
+{
+    const char* p_last = NULL;
+    size_t found = 0;
+
+    for (IndexSet::const_iterator it = m_index.lower_bound(prefix.c_str()); it != m_index.end() && found < i_max; ++it)
+    {
+        if (strncmp(*it, prefix.c_str(), prefix.length()) != 0)
+            break;
+
+        if (p_last && strcmp(p_last, *it) == 0)
+            continue;
+
+        o_words.push_back(*it);
+        p_last = *it;
+        found++;
+    }
+}
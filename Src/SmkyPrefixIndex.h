@@ -0,0 +1,102 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SMKY_PREFIX_INDEX_H
+#define SMKY_PREFIX_INDEX_H
+
+#include <set>
+#include <string.h>
+#include <list>
+#include <string>
+
+namespace SmartKey
+{
+
+/**
+ * Sorted secondary index over strings owned by a dictionary container.
+ * Only pointers are stored, so the indexed strings must stay at the same address
+ * while they are indexed (keys and values kept in SmkyFlatTable move only when its relocations() changes).
+ * Prefix lookup is a logarithmic seek followed by a scan of the matching range.
+ */
+class SmkyPrefixIndex
+{
+private:
+    class SmkyPtrLess
+    {
+    public:
+        bool operator()(const char* p_str1, const char* p_str2) const
+        {
+            return (strcmp(p_str1, p_str2) < 0);
+        }
+    };
+
+    typedef std::multiset<const char*, SmkyPtrLess> IndexSet;
+
+    IndexSet m_index;
+
+public:
+
+    //add string to the index
+    void insert (const char* ip_word);
+
+    //remove string from the index (by address)
+    void erase (const char* ip_word);
+
+    //remove all strings
+    void clear (void);
+
+    //find first (in sorted order) string starting with prefix
+    const char* findFirst (const std::string& prefix) const;
+
+    //find up to i_max different strings starting with prefix (in sorted order), append them to o_words
+    void findAll (const std::string& prefix, size_t i_max, std::list<std::string>& o_words) const;
+
+    //approximate bytes allocated for the index (strings are not counted)
+    size_t memoryUsed (void) const;
+};
+
+/**
+* add string to the index
+*
+* @param ip_word
+*   pointer to the string owned by dictionary
+*/
+inline void SmkyPrefixIndex::insert (const char* ip_word)
+{
+    m_index.insert(ip_word);
+}
+
+/**
+* remove all strings from the index
+*/
+inline void SmkyPrefixIndex::clear (void)
+{
+    m_index.clear();
+}
+
+/**
+* approximate bytes allocated for the index: one tree node (color, 3 links and value) per string
+*/
+inline size_t SmkyPrefixIndex::memoryUsed (void) const
+{
+    return(m_index.size() * (4 * sizeof(void*) + sizeof(const char*)));
+}
+
+}
+
+#endif
@@ -0,0 +1,148 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "SmkyRequestPool.h"
+
+using namespace SmartKey;
+
+/**
+* SmkyRequestPool
+*/
+SmkyRequestPool::SmkyRequestPool (void)
+    : mp_pool(NULL)
+{
+}
+
+/**
+* ~SmkyRequestPool
+*/
+SmkyRequestPool::~SmkyRequestPool (void)
+{
+    stop();
+}
+
+/**
+* start worker threads
+*
+* @param i_threads
+*   number of threads, 0 - pool is not started and every request is processed by caller
+*
+* @return bool
+*   true if pool is running
+*/
+bool SmkyRequestPool::start (int i_threads)
+{
+    if (mp_pool)
+        return(true);
+
+    if (i_threads <= 0)
+        return(false);
+
+    GError* p_error = NULL;
+    mp_pool = g_thread_pool_new(_run, NULL, i_threads, TRUE, &p_error);
+
+    if (!mp_pool)
+    {
+        g_warning("RequestPool: failed to start %d threads (%s)", i_threads, p_error ? p_error->message : "unknown error");
+        if (p_error)
+            g_error_free(p_error);
+        return(false);
+    }
+
+    g_message("RequestPool: started %d threads", i_threads);
+
+    return(true);
+}
+
+/**
+* wait for queued requests and stop threads
+*/
+void SmkyRequestPool::stop (void)
+{
+    if (!mp_pool)
+        return;
+
+    //requests already queued are still replied
+    g_thread_pool_free(mp_pool, FALSE, TRUE);
+    mp_pool = NULL;
+}
+
+/**
+* queue request
+*
+* @param i_handler
+*   handler to run in worker thread
+*
+* @param ip_sh
+*   luna handle
+*
+* @param ip_message
+*   request message, referenced until handler is done
+*
+* @param ip_ctx
+*   handler context
+*
+* @return bool
+*   true if queued, false - caller should run handler itself
+*/
+bool SmkyRequestPool::push (Handler i_handler, LSHandle* ip_sh, LSMessage* ip_message, void* ip_ctx)
+{
+    if (!mp_pool)
+        return(false);
+
+    Request* p_request = new Request;
+    p_request->handler = i_handler;
+    p_request->sh = ip_sh;
+    p_request->message = ip_message;
+    p_request->ctx = ip_ctx;
+
+    LSMessageRef(ip_message);
+
+    GError* p_error = NULL;
+    if (!g_thread_pool_push(mp_pool, p_request, &p_error))
+    {
+        g_warning("RequestPool: failed to queue request (%s)", p_error ? p_error->message : "unknown error");
+        if (p_error)
+            g_error_free(p_error);
+
+        LSMessageUnref(ip_message);
+        delete p_request;
+        return(false);
+    }
+
+    return(true);
+}
+
+/**
+* run request in worker thread
+*
+* @param ip_data
+*   Request
+*
+* @param ip_userData
+*   not used
+*/
+void SmkyRequestPool::_run (gpointer ip_data, gpointer ip_userData)
+{
+    Request* p_request = static_cast<Request*>(ip_data);
+
+    p_request->handler(p_request->sh, p_request->message, p_request->ctx);
+
+    LSMessageUnref(p_request->message);
+    delete p_request;
+}
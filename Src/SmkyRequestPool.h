@@ -0,0 +1,81 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SMKY_REQUEST_POOL_H
+#define SMKY_REQUEST_POOL_H
+
+#include <glib.h>
+#include "lunaservice.h"
+
+namespace SmartKey
+{
+
+/**
+ * Bounded pool of threads which run luna request handlers off the main loop.
+ * Handler is responsible for the reply (LSMessageReply is thread safe), message is
+ * referenced while request is queued.
+ */
+class SmkyRequestPool
+{
+public:
+    typedef bool (*Handler)(LSHandle* sh, LSMessage* message, void* ctx);
+
+private:
+    struct Request
+    {
+        Handler     handler;
+        LSHandle*   sh;
+        LSMessage*  message;
+        void*       ctx;
+    };
+
+    GThreadPool* mp_pool;
+
+public:
+
+    SmkyRequestPool (void);
+    virtual ~SmkyRequestPool (void);
+
+    //start i_threads worker threads (0 - no threads, requests are not accepted)
+    bool start (int i_threads);
+
+    //wait for queued requests and stop threads
+    void stop (void);
+
+    //is pool running?
+    bool isRunning (void) const;
+
+    //queue request, return false if it should be processed by caller
+    bool push (Handler i_handler, LSHandle* ip_sh, LSMessage* ip_message, void* ip_ctx);
+
+private:
+    //run request in worker thread
+    static void _run (gpointer ip_data, gpointer ip_userData);
+};
+
+/**
+* is pool running?
+*/
+inline bool SmkyRequestPool::isRunning (void) const
+{
+    return(mp_pool != NULL);
+}
+
+}
+
+#endif
@@ -0,0 +1,154 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "SmkyRequestSessions.h"
+
+using namespace SmartKey;
+
+/**
+* SmkyRequestSessions
+*/
+SmkyRequestSessions::SmkyRequestSessions (void)
+    : m_clock(0)
+{
+    g_mutex_init(&m_mutex);
+}
+
+/**
+* ~SmkyRequestSessions
+*/
+SmkyRequestSessions::~SmkyRequestSessions (void)
+{
+    for (SessionsMap::iterator it = m_sessions.begin(); it != m_sessions.end(); ++it)
+        SmkyRequestTicket::unref(it->second.state);
+    m_sessions.clear();
+
+    g_mutex_clear(&m_mutex);
+}
+
+/**
+* register a new request of the session, the least recently used session is dropped
+* if there are MAX_SESSIONS already
+*
+* @param i_session
+*   session id
+*
+* @param i_seq
+*   sequence number of the request, growing within the session
+*
+* @return bool
+*   false if a newer request of the session was already started
+*/
+bool SmkyRequestSessions::start (const std::string& i_session, gint i_seq)
+{
+    bool result = true;
+
+    g_mutex_lock(&m_mutex);
+
+    SessionsMap::iterator it = m_sessions.find(i_session);
+
+    if (it != m_sessions.end())
+    {
+        if (g_atomic_int_get(&it->second.state->latest) > i_seq)
+            result = false;
+        else
+            g_atomic_int_set(&it->second.state->latest, i_seq);
+    }
+    else
+    {
+        if (m_sessions.size() >= MAX_SESSIONS)
+            _evict();
+
+        Session session;
+        session.state = new SmkySessionState;
+        session.state->latest = i_seq;
+        session.state->refs = 1;
+        it = m_sessions.insert(std::make_pair(i_session, session)).first;
+    }
+
+    it->second.lastUsed = ++m_clock;
+
+    g_mutex_unlock(&m_mutex);
+
+    return(result);
+}
+
+/**
+* get ticket of the request
+*
+* @param i_session
+*   session id
+*
+* @param i_seq
+*   sequence number of the request
+*
+* @return SmkyRequestTicket
+*   ticket, it is never superseded if session is not tracked
+*/
+SmkyRequestTicket SmkyRequestSessions::getTicket (const std::string& i_session, gint i_seq)
+{
+    SmkyRequestTicket ticket;
+
+    g_mutex_lock(&m_mutex);
+
+    SessionsMap::iterator it = m_sessions.find(i_session);
+    if (it != m_sessions.end())
+        ticket = SmkyRequestTicket(it->second.state, i_seq);
+
+    g_mutex_unlock(&m_mutex);
+
+    return(ticket);
+}
+
+/**
+* number of tracked sessions
+*
+* @return size_t
+*   sessions
+*/
+size_t SmkyRequestSessions::size (void)
+{
+    g_mutex_lock(&m_mutex);
+    size_t count = m_sessions.size();
+    g_mutex_unlock(&m_mutex);
+
+    return(count);
+}
+
+/**
+* drop the least recently used session, caller holds the mutex.
+* Running requests of the session keep its state, they are just never superseded.
+*/
+void SmkyRequestSessions::_evict (void)
+{
+    SessionsMap::iterator oldest = m_sessions.begin();
+
+    for (SessionsMap::iterator it = m_sessions.begin(); it != m_sessions.end(); ++it)
+    {
+        if (it->second.lastUsed < oldest->second.lastUsed)
+            oldest = it;
+    }
+
+    if (oldest == m_sessions.end())
+        return;
+
+    g_debug("RequestSessions: session '%s' is dropped", oldest->first.c_str());
+
+    SmkyRequestTicket::unref(oldest->second.state);
+    m_sessions.erase(oldest);
+}
@@ -0,0 +1,79 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SMKY_REQUEST_SESSIONS_H
+#define SMKY_REQUEST_SESSIONS_H
+
+#include <map>
+#include <string>
+#include <glib.h>
+#include "SmkyDeadline.h"
+
+namespace SmartKey
+{
+
+/**
+ * Latest request sequence number of every client session (e.g. keyboard instance).
+ * Requests are started on the main loop in the order they are received, worker threads check
+ * their tickets to skip or cut short requests which were superseded by a newer one.
+ * At most MAX_SESSIONS are tracked, the least recently used one is dropped for a new one;
+ * tickets keep the state of a dropped session referenced until its requests finish.
+ */
+class SmkyRequestSessions
+{
+public:
+    enum { MAX_SESSIONS = 64 };
+
+private:
+    struct Session
+    {
+        SmkySessionState* state;    ///< Referenced by the list and by tickets.
+        guint64           lastUsed; ///< Value of m_clock when the latest request was started.
+    };
+
+    typedef std::map<std::string, Session> SessionsMap;
+
+    SessionsMap m_sessions;
+    guint64     m_clock;    ///< Incremented by every started request.
+    GMutex      m_mutex;
+
+public:
+
+    SmkyRequestSessions (void);
+    virtual ~SmkyRequestSessions (void);
+
+    //register a new request of the session, return false if a newer one was already started
+    bool start (const std::string& i_session, gint i_seq);
+
+    //get ticket of the request
+    SmkyRequestTicket getTicket (const std::string& i_session, gint i_seq);
+
+    //number of tracked sessions
+    size_t size (void);
+
+private:
+    //drop the least recently used session
+    void _evict (void);
+
+    SmkyRequestSessions (const SmkyRequestSessions&);   // don't implement
+    void operator= (const SmkyRequestSessions&);        // don't implement
+};
+
+}
+
+#endif
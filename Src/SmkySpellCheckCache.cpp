@@ -0,0 +1,269 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "SmkySpellCheckCache.h"
+#include "Database.h"
+#include <stdio.h>
+
+using namespace SmartKey;
+
+/**
+* SmkySpellCheckCache
+*
+* @param i_capacity
+*   max number of cached results, 0 disables the cache
+*/
+SmkySpellCheckCache::SmkySpellCheckCache (size_t i_capacity)
+    : m_capacity(i_capacity)
+    , m_generation(getDictionaryGeneration())
+    , m_hits(0)
+    , m_misses(0)
+{
+    g_mutex_init(&m_mutex);
+}
+
+/**
+* ~SmkySpellCheckCache
+*/
+SmkySpellCheckCache::~SmkySpellCheckCache (void)
+{
+    _clear();
+    g_mutex_clear(&m_mutex);
+}
+
+/**
+* make cache key
+*
+* @param i_word
+*   word to check
+*
+* @param i_maxGuesses
+*   number of guesses requested
+*
+* @param i_mode
+*   check spelling or auto correct
+*
+* @param i_locale
+*   current locale
+*
+* @return std::string
+*   key
+*/
+std::string SmkySpellCheckCache::_makeKey (const std::string& i_word, int i_maxGuesses, Mode i_mode, const std::string& i_locale)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "\x1f%d\x1f%d\x1f", i_maxGuesses, (int)i_mode);
+
+    return(i_word + buf + i_locale);
+}
+
+/**
+* drop cached results if any dictionary was changed since they were stored
+*/
+void SmkySpellCheckCache::_checkGeneration (void)
+{
+    gint generation = getDictionaryGeneration();
+
+    if (generation != m_generation)
+    {
+        _clear();
+        m_generation = generation;
+    }
+}
+
+/**
+* find cached result
+*
+* @param i_word
+*   word to check
+*
+* @param i_maxGuesses
+*   number of guesses requested
+*
+* @param i_mode
+*   check spelling or auto correct
+*
+* @param i_locale
+*   current locale
+*
+* @param o_result
+*   output: cached result
+*
+* @return bool
+*   true if found
+*/
+bool SmkySpellCheckCache::lookup (const std::string& i_word, int i_maxGuesses, Mode i_mode, const std::string& i_locale, SpellCheckWordInfo& o_result)
+{
+    if (m_capacity == 0)
+        return(false);
+
+    std::string key = _makeKey(i_word, i_maxGuesses, i_mode, i_locale);
+
+    g_mutex_lock(&m_mutex);
+
+    _checkGeneration();
+
+    EntriesMap::iterator it = m_map.find(key);
+
+    if (it == m_map.end())
+    {
+        m_misses++;
+        g_mutex_unlock(&m_mutex);
+        return(false);
+    }
+
+    //move entry to the front of the list, iterators stay valid
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    o_result = it->second->result;
+    m_hits++;
+
+    g_mutex_unlock(&m_mutex);
+
+    return(true);
+}
+
+/**
+* remember result
+*
+* @param i_word
+*   word to check
+*
+* @param i_maxGuesses
+*   number of guesses requested
+*
+* @param i_mode
+*   check spelling or auto correct
+*
+* @param i_locale
+*   current locale
+*
+* @param i_result
+*   result to remember
+*/
+void SmkySpellCheckCache::store (const std::string& i_word, int i_maxGuesses, Mode i_mode, const std::string& i_locale, const SpellCheckWordInfo& i_result)
+{
+    if (m_capacity == 0)
+        return;
+
+    std::string key = _makeKey(i_word, i_maxGuesses, i_mode, i_locale);
+
+    g_mutex_lock(&m_mutex);
+
+    _checkGeneration();
+
+    EntriesMap::iterator it = m_map.find(key);
+
+    if (it != m_map.end())
+    {
+        it->second->result = i_result;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        g_mutex_unlock(&m_mutex);
+        return;
+    }
+
+    //drop least recently used entry
+    if (m_entries.size() >= m_capacity)
+    {
+        m_map.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+
+    CacheEntry entry;
+    entry.key = key;
+    entry.result = i_result;
+
+    m_entries.push_front(entry);
+    m_map[key] = m_entries.begin();
+
+    g_mutex_unlock(&m_mutex);
+}
+
+/**
+* drop all cached results
+*/
+void SmkySpellCheckCache::clear (void)
+{
+    g_mutex_lock(&m_mutex);
+    _clear();
+    g_mutex_unlock(&m_mutex);
+}
+
+/**
+* drop all cached results, mutex is locked by caller
+*/
+void SmkySpellCheckCache::_clear (void)
+{
+    if (!m_entries.empty())
+    {
+        g_debug("SpellCheckCache: dropping %u results (hits: %u, misses: %u)", (unsigned int)m_entries.size(), m_hits, m_misses);
+    }
+
+    m_map.clear();
+    m_entries.clear();
+}
+
+/**
+* get memory usage of cached results: keys are stored twice (in the list and in the map),
+* node overhead is estimated as two pointers per list node and one per map node and bucket
+*
+* @param o_stats
+*   output: statistics, name is not changed
+*/
+void SmkySpellCheckCache::getStats (DictionaryStats& o_stats) const
+{
+    g_mutex_lock(&m_mutex);
+
+    o_stats.entries = m_entries.size();
+    o_stats.keyBytes = 0;
+    o_stats.valueBytes = 0;
+
+    for (EntriesList::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+        o_stats.keyBytes += 2 * (it->key.capacity() + 1);
+        o_stats.valueBytes += resultBytes(it->result);
+    }
+
+    o_stats.overheadBytes = m_entries.size() * (2 * sizeof(void*) + sizeof(CacheEntry))
+        + m_map.size() * (sizeof(void*) + sizeof(EntriesMap::value_type))
+        + m_map.bucket_count() * sizeof(void*);
+    o_stats.mappedBytes = 0;
+    o_stats.loadMs = 0;
+
+    g_mutex_unlock(&m_mutex);
+}
+
+/**
+* approximate bytes allocated for the result: array of guesses and their strings
+*
+* @param i_result
+*   spell check result
+*
+* @return size_t
+*   bytes
+*/
+size_t SmkySpellCheckCache::resultBytes (const SpellCheckWordInfo& i_result)
+{
+    size_t bytes = i_result.guesses.capacity() * sizeof(WordGuess);
+
+    for (size_t i = 0; i < i_result.guesses.size(); ++i)
+    {
+        bytes += i_result.guesses[i].guess.capacity() + 1;
+    }
+
+    return(bytes);
+}
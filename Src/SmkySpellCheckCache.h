@@ -0,0 +1,146 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SMKY_SPELL_CHECK_CACHE_H
+#define SMKY_SPELL_CHECK_CACHE_H
+
+#include <list>
+#include <ext/hash_map> //I know about replacement to <unordered_map>, but not sure yet about c++11 support for this project
+#include <string>
+#include <glib.h>
+#include "SmkyFileKeywords.h"
+#include "SpellCheckClient.h"
+
+namespace SmartKey
+{
+
+/**
+ * LRU cache of spell check results, keyed by (word, maxGuesses, mode, locale).
+ * Content is dropped as soon as any dictionary is changed (see getDictionaryGeneration()).
+ * Cache is shared by worker threads, all methods are serialized by internal mutex.
+ */
+class SmkySpellCheckCache
+{
+public:
+    enum Mode
+    {
+        MODE_CHECK_SPELLING = 0
+        ,MODE_AUTO_CORRECT
+    };
+
+private:
+    struct CacheEntry
+    {
+        std::string        key;
+        SpellCheckWordInfo result;
+    };
+
+    typedef std::list<CacheEntry> EntriesList;
+    typedef hash_map<std::string, EntriesList::iterator, SmkyHasher, SmkyComparator> EntriesMap;
+
+    //most recently used entries are at the front
+    EntriesList  m_entries;
+    EntriesMap   m_map;
+
+    size_t       m_capacity;
+    gint         m_generation;
+
+    unsigned int m_hits;
+    unsigned int m_misses;
+
+    mutable GMutex m_mutex;
+
+public:
+
+    SmkySpellCheckCache (size_t i_capacity);
+    virtual ~SmkySpellCheckCache (void);
+
+    //find cached result, return true if found
+    bool lookup (const std::string& i_word, int i_maxGuesses, Mode i_mode, const std::string& i_locale, SpellCheckWordInfo& o_result);
+
+    //remember result
+    void store (const std::string& i_word, int i_maxGuesses, Mode i_mode, const std::string& i_locale, const SpellCheckWordInfo& i_result);
+
+    //drop all cached results
+    void clear (void);
+
+    //number of cached results
+    size_t size (void) const;
+
+    //number of lookups answered from the cache
+    unsigned int getHits (void) const;
+
+    //number of lookups not found in the cache
+    unsigned int getMisses (void) const;
+
+    //get memory usage of cached results (name is not set)
+    void getStats (DictionaryStats& o_stats) const;
+
+    //approximate bytes allocated for strings of the result
+    static size_t resultBytes (const SpellCheckWordInfo& i_result);
+
+private:
+    //make cache key
+    static std::string _makeKey (const std::string& i_word, int i_maxGuesses, Mode i_mode, const std::string& i_locale);
+
+    //drop cached results if dictionaries were changed (mutex is locked by caller)
+    void _checkGeneration (void);
+
+    //drop all cached results (mutex is locked by caller)
+    void _clear (void);
+};
+
+/**
+* number of cached results
+*/
+inline size_t SmkySpellCheckCache::size (void) const
+{
+    g_mutex_lock(&m_mutex);
+    size_t result = m_entries.size();
+    g_mutex_unlock(&m_mutex);
+
+    return(result);
+}
+
+/**
+* number of lookups answered from the cache
+*/
+inline unsigned int SmkySpellCheckCache::getHits (void) const
+{
+    g_mutex_lock(&m_mutex);
+    unsigned int result = m_hits;
+    g_mutex_unlock(&m_mutex);
+
+    return(result);
+}
+
+/**
+* number of lookups not found in the cache
+*/
+inline unsigned int SmkySpellCheckCache::getMisses (void) const
+{
+    g_mutex_lock(&m_mutex);
+    unsigned int result = m_misses;
+    g_mutex_unlock(&m_mutex);
+
+    return(result);
+}
+
+}
+
+#endif
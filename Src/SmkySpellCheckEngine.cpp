@@ -30,6 +30,7 @@
 #include "StringUtils.h"
 #include "Database.h"
 #include "SmkyAutoSubDatabase.h"
+#include "SmkyExtraLocales.h"
 #include "SmkyManufacturerDatabase.h"
 #include "SmkyHunspellDatabase.h"
 #include "Settings.h"
@@ -47,12 +48,26 @@ using namespace SmartKey;
 * SmkySpellCheckEngine
 */
 SmkySpellCheckEngine::SmkySpellCheckEngine (void)
-	: m_supported_languages("")
+	: mp_extraLocales(NULL)
+	, m_supported_languages("")
+	, m_cache(std::max(0, Settings::getInstance()->spellCacheSize))
+	, m_known_words_generation(0)
+	, m_known_words_ms(0)
+	, m_locale_switch_ms(0)
+	, mp_hunspOwner(NULL)
+	, m_preloading(0)
+	, mp_preloadThread(NULL)
+	, m_locale_generation(0)
 {
+    g_mutex_init(&m_worker_mutex);
+    g_cond_init(&m_worker_cond);
+    g_rw_lock_init(&m_lock);
+
     mp_hunspDb = new SmkyHunspellDatabase();
     mp_autoSubDb = new SmkyAutoSubDatabase();
     mp_userDb = new SmkyUserDatabase();
     mp_manDb = new SmkyManufacturerDatabase();
+    mp_extraLocales = new SmkyExtraLocales();
 
     m_initialized = mp_hunspDb && mp_autoSubDb && mp_userDb && mp_manDb;
 
@@ -72,6 +87,10 @@ SmkySpellCheckEngine::SmkySpellCheckEngine (void)
     m_white_dictionary.load(Settings::getInstance()->getDBFilePath(Settings::DICT_WHITE),
                             Settings::getInstance()->getDBFilePath(Settings::DICT_WHITE, Settings::DICT_LOCALE_DEPEND));
 
+    //multi-language mode: other languages checked after the current one
+    if (m_initialized)
+        mp_extraLocales->load(Settings::getInstance()->extraLocales, Settings::getInstance()->localeSettings);
+
     //init list of supported languages (need to move it to configuration file!)
     m_languages.add("an");
     m_languages.add("ar");
@@ -91,6 +110,94 @@ SmkySpellCheckEngine::SmkySpellCheckEngine (void)
     m_languages.add("uk");
     m_languages.add("uz");
     m_languages.add("vi");
+
+    _updateKnownWords();
+}
+
+/**
+* update table of words from whitelist, auto substitution, manufacturer and user dictionaries,
+* called only when no request is running (constructor or exclusive lock). Words added since
+* the last update are inserted, the table is rebuilt only if any word was erased or moved
+* (or the filter has no room for added words).
+*/
+void SmkySpellCheckEngine::_updateKnownWords (void)
+{
+    gint generation = getDictionaryGeneration();
+
+    if (!m_initialized || generation == m_known_words_generation)
+        return;
+
+    gint64 start = g_get_monotonic_time();
+
+    //words are not copied, table refers to strings of the dictionaries
+    std::vector<const char*> layers[4];
+
+    //every dictionary forgets its changes, so all of them are asked
+    bool incremental = m_white_dictionary.takeAddedKeys(layers[0]);
+    incremental = mp_autoSubDb->takeAddedShortcuts(layers[1]) && incremental;
+    incremental = mp_manDb->takeAddedWords(layers[2]) && incremental;
+    incremental = mp_userDb->takeAddedWords(layers[3]) && incremental;
+    incremental = incremental && m_known_words.hasRoom(layers[0].size() + layers[1].size() + layers[2].size() + layers[3].size());
+
+    if (!incremental)
+    {
+        for (int i = 0; i < 4; ++i)
+            layers[i].clear();
+
+        m_white_dictionary.exportKeys(layers[0]);
+        mp_autoSubDb->exportShortcuts(layers[1]);
+        mp_manDb->exportWords(layers[2]);
+        mp_userDb->exportWords(layers[3]);
+
+        //room for words learned later
+        size_t words = layers[0].size() + layers[1].size() + layers[2].size() + layers[3].size();
+        m_known_words.reset(words + words / 8 + 64);
+    }
+
+    static const SmkyKnownWords::Layer layer_ids[4] = { SmkyKnownWords::LAYER_WHITELIST,
+                                                        SmkyKnownWords::LAYER_AUTOSUB,
+                                                        SmkyKnownWords::LAYER_MANUFACTURER,
+                                                        SmkyKnownWords::LAYER_USER };
+
+    for (int i = 0; i < 4; ++i)
+    {
+        for (size_t j = 0; j < layers[i].size(); ++j)
+            m_known_words.add(layers[i][j], layer_ids[i]);
+    }
+
+    m_known_words_generation = generation;
+    m_known_words_ms = (g_get_monotonic_time() - start) / 1000.0;
+
+    g_debug("SpellCheckEngine: table of known words %s, %u words", incremental ? "updated" : "rebuilt", (unsigned int)m_known_words.size());
+}
+
+/**
+* find word in whitelist, auto substitution, manufacturer and user dictionaries with a single lookup,
+* dictionaries are searched one by one only if they were changed after the table was built
+*
+* @param word
+*   word to find
+*
+* @return unsigned int
+*   bits of SmkyKnownWords::Layer, 0 if word is in none of the dictionaries
+*/
+unsigned int SmkySpellCheckEngine::_findKnownWord (const std::string& word)
+{
+    if (m_known_words_generation == getDictionaryGeneration())
+        return(m_known_words.find(word));
+
+    unsigned int layers = 0;
+
+    if (m_white_dictionary.find(word))
+        layers |= SmkyKnownWords::LAYER_WHITELIST;
+    if (mp_autoSubDb->findEntry(word).length() > 0)
+        layers |= SmkyKnownWords::LAYER_AUTOSUB;
+    if (mp_manDb->findEntry(word))
+        layers |= SmkyKnownWords::LAYER_MANUFACTURER;
+    if (mp_userDb->findWord(word))
+        layers |= SmkyKnownWords::LAYER_USER;
+
+    return(layers);
 }
 
 /**
@@ -98,7 +205,12 @@ SmkySpellCheckEngine::SmkySpellCheckEngine (void)
 */
 SmkySpellCheckEngine::~SmkySpellCheckEngine()
 {
+    _stopPreload();
     _clean();
+
+    g_rw_lock_clear(&m_lock);
+    g_cond_clear(&m_worker_cond);
+    g_mutex_clear(&m_worker_mutex);
 }
 
 /**
@@ -114,6 +226,20 @@ void SmkySpellCheckEngine::_clean (void)
         mp_hunspDb = NULL;
     }
 
+    for (WorkerDbMap::iterator it = m_worker_dbs.begin(); it != m_worker_dbs.end(); ++it)
+        delete it->second;
+    m_worker_dbs.clear();
+
+    for (size_t i = 0; i < m_spare_dbs.size(); ++i)
+        delete m_spare_dbs[i];
+    m_spare_dbs.clear();
+
+    if (mp_extraLocales)
+    {
+        delete mp_extraLocales;
+        mp_extraLocales = NULL;
+    }
+
     if (mp_autoSubDb)
     {
         delete mp_autoSubDb;
@@ -133,6 +259,221 @@ void SmkySpellCheckEngine::_clean (void)
     }
 }
 
+/**
+* get hunspell dictionary of calling thread.
+* Hunspell instance can't be used by several threads at once, so the first thread which asks
+* takes mp_hunspDb and other threads take a copy, loaded in advance when worker threads are
+* started (see startWorkerDictionaries) and together with dictionaries of each locale
+* (see loadLocale). A copy is loaded here only if there are more threads than copies.
+* Requests run either on worker threads or on the main loop (no worker threads), never on both
+* (see SmartKeyService::dispatchRequest), so the main loop never takes a copy.
+*
+* @return SmkyHunspellDatabase*
+*   dictionary (NULL if engine is not initialized)
+*/
+SmkyHunspellDatabase* SmkySpellCheckEngine::_getHunspellDb (void)
+{
+    if (!mp_hunspDb)
+        return(NULL);
+
+    GThread* p_self = g_thread_self();
+
+    g_mutex_lock(&m_worker_mutex);
+
+    if (!mp_hunspOwner)
+        mp_hunspOwner = p_self;
+
+    if (mp_hunspOwner == p_self)
+    {
+        g_mutex_unlock(&m_worker_mutex);
+        return(mp_hunspDb);
+    }
+
+    WorkerDbMap::iterator it = m_worker_dbs.find(p_self);
+    if (it != m_worker_dbs.end())
+    {
+        SmkyHunspellDatabase* p_db = it->second;
+        g_mutex_unlock(&m_worker_mutex);
+        return(p_db);
+    }
+
+    //copy being preloaded is ready sooner than a new one
+    while (m_spare_dbs.empty() && m_preloading > 0)
+        g_cond_wait(&m_worker_cond, &m_worker_mutex);
+
+    SmkyHunspellDatabase* p_db = NULL;
+    if (!m_spare_dbs.empty())
+    {
+        p_db = m_spare_dbs.back();
+        m_spare_dbs.pop_back();
+    }
+
+    g_mutex_unlock(&m_worker_mutex);
+
+    //locale is not changed meanwhile, caller holds the engine lock
+    if (!p_db)
+    {
+        g_warning("SpellCheckEngine: no preloaded hunspell dictionary, loading one for worker thread");
+        p_db = new SmkyHunspellDatabase(Settings::getInstance()->localeSettings);
+    }
+
+    g_mutex_lock(&m_worker_mutex);
+    m_worker_dbs[p_self] = p_db;
+    g_mutex_unlock(&m_worker_mutex);
+
+    return(p_db);
+}
+
+/**
+* load copies of hunspell dictionary in background, so that requests don't wait for them:
+* the first worker thread uses the engine's dictionary, each other one takes a copy
+*
+* @param i_threads
+*   number of worker threads
+*/
+void SmkySpellCheckEngine::startWorkerDictionaries (int i_threads)
+{
+    if (!m_initialized || mp_preloadThread)
+        return;
+
+    g_mutex_lock(&m_worker_mutex);
+
+    int missing = i_threads - 1 - (int)(m_worker_dbs.size() + m_spare_dbs.size());
+    if (missing > 0)
+    {
+        m_preloading = missing;
+        m_preload_locale = Settings::getInstance()->localeSettings;
+    }
+
+    g_mutex_unlock(&m_worker_mutex);
+
+    if (missing > 0)
+    {
+        g_debug("SpellCheckEngine: loading %d hunspell dictionaries for worker threads", missing);
+        mp_preloadThread = g_thread_new("smartkey-hunspell", _preloadThread, this);
+    }
+}
+
+/**
+* load copies of hunspell dictionary for worker threads one by one, copies are dropped
+* if locale is changed meanwhile (dictionaries of the new locale come with their copies)
+*
+* @param ctx
+*   SmkySpellCheckEngine
+*
+* @return gpointer
+*   NULL
+*/
+gpointer SmkySpellCheckEngine::_preloadThread (gpointer ctx)
+{
+    SmkySpellCheckEngine* p_engine = static_cast<SmkySpellCheckEngine*>(ctx);
+
+    g_mutex_lock(&p_engine->m_worker_mutex);
+
+    LocaleSettings locale = p_engine->m_preload_locale;
+    gint generation = p_engine->m_locale_generation;
+
+    while (p_engine->m_preloading > 0)
+    {
+        g_mutex_unlock(&p_engine->m_worker_mutex);
+
+        SmkyHunspellDatabase* p_db = new SmkyHunspellDatabase(locale);
+
+        g_mutex_lock(&p_engine->m_worker_mutex);
+
+        if (p_engine->m_preloading > 0 && generation == p_engine->m_locale_generation)
+        {
+            p_engine->m_spare_dbs.push_back(p_db);
+            p_engine->m_preloading--;
+        }
+        else
+        {
+            delete p_db;
+            p_engine->m_preloading = 0;
+        }
+
+        g_cond_broadcast(&p_engine->m_worker_cond);
+    }
+
+    g_mutex_unlock(&p_engine->m_worker_mutex);
+
+    return NULL;
+}
+
+/**
+* stop loading copies of hunspell dictionary, the copy being loaded is dropped
+*/
+void SmkySpellCheckEngine::_stopPreload (void)
+{
+    if (!mp_preloadThread)
+        return;
+
+    g_mutex_lock(&m_worker_mutex);
+    m_preloading = 0;
+    g_cond_broadcast(&m_worker_cond);
+    g_mutex_unlock(&m_worker_mutex);
+
+    g_thread_join(mp_preloadThread);
+    mp_preloadThread = NULL;
+}
+
+/**
+* append memory usage and load time of all dictionaries and caches,
+* caller holds the engine lock, so dictionaries are not changed meanwhile
+*
+* @param o_stats
+*   output: statistics are appended
+*/
+void SmkySpellCheckEngine::getStats (std::vector<DictionaryStats>& o_stats)
+{
+    DictionaryStats stats;
+
+    stats.name = "languages";
+    m_languages.getStats(stats);
+    o_stats.push_back(stats);
+
+    m_locale_dictionary.getStats("locale", o_stats);
+    m_white_dictionary.getStats("whitelist", o_stats);
+
+    if (m_initialized)
+    {
+        mp_autoSubDb->getStats(o_stats);
+        mp_manDb->getStats(o_stats);
+        mp_userDb->getStats(o_stats);
+        mp_hunspDb->getStats(o_stats);
+        mp_extraLocales->getStats(o_stats);
+    }
+
+    stats = DictionaryStats();
+    stats.name = "known-words";
+    stats.entries = m_known_words.size();
+    stats.overheadBytes = m_known_words.memoryUsed();
+    stats.loadMs = m_known_words_ms;
+    o_stats.push_back(stats);
+
+    stats = DictionaryStats();
+    stats.name = "spellcheck-cache";
+    m_cache.getStats(stats);
+    o_stats.push_back(stats);
+}
+
+/**
+* number of hunspell dictionaries loaded for worker threads, each of them takes
+* about as much memory as the main one
+*
+* @return size_t
+*   number of dictionaries
+*/
+size_t SmkySpellCheckEngine::getWorkerDictionaries (void)
+{
+    //copies taken by worker threads and preloaded ones
+    g_mutex_lock(&m_worker_mutex);
+    size_t count = m_worker_dbs.size() + m_spare_dbs.size();
+    g_mutex_unlock(&m_worker_mutex);
+
+    return(count);
+}
+
 /**
 * get supported languages
 *
@@ -192,7 +533,59 @@ bool SmkySpellCheckEngine::_wordIsAllDigits (const std::string& word)
 }
 
 /**
-* check spelling
+* get time budget of request
+*
+* @param budgetMs
+*   requested budget, < 0 - use default from settings
+*
+* @return int
+*   budget in milliseconds, 0 - no limit
+*/
+int SmkySpellCheckEngine::_getBudgetMs (int budgetMs)
+{
+    return(budgetMs >= 0 ? budgetMs : Settings::getInstance()->suggestBudgetMs);
+}
+
+/**
+* check spelling, results are cached until any dictionary or locale is changed
+*
+* @param word
+*   word to check
+*
+* @param result
+*   output: result
+*
+* @param maxGuesses
+*   number of words in result
+*
+* @param budgetMs
+*   time budget (ms) for suggestions, < 0 - default from settings, 0 - no limit
+*
+* @param ticket
+*   request ticket, suggestions are cut short when request is superseded
+*
+* @return SmartKeyErrorCode
+*   SKERR_SUCCESS if done
+*/
+SmartKeyErrorCode SmkySpellCheckEngine::checkSpelling (const std::string& word, SpellCheckWordInfo& result, int maxGuesses, int budgetMs, const SmkyRequestTicket& ticket)
+{
+    std::string locale = Settings::getInstance()->localeSettings.getFullLocale();
+
+    if (m_cache.lookup(word, maxGuesses, SmkySpellCheckCache::MODE_CHECK_SPELLING, locale, result))
+        return SKERR_SUCCESS;
+
+    SmkyDeadline deadline(_getBudgetMs(budgetMs), ticket);
+    SmartKeyErrorCode err = _checkSpelling(word, result, maxGuesses, deadline);
+
+    //partial results depend on timing, don't keep them
+    if (err == SKERR_SUCCESS && !result.partial)
+        m_cache.store(word, maxGuesses, SmkySpellCheckCache::MODE_CHECK_SPELLING, locale, result);
+
+    return err;
+}
+
+/**
+* check spelling through all the dictionaries
 *
 * @param word
 *   word to check
@@ -203,10 +596,13 @@ bool SmkySpellCheckEngine::_wordIsAllDigits (const std::string& word)
 * @param maxGuesses
 *   number of words in result
 *
+* @param deadline
+*   time budget of the request
+*
 * @return SmartKeyErrorCode
 *   SKERR_SUCCESS if done
 */
-SmartKeyErrorCode SmkySpellCheckEngine::checkSpelling (const std::string& word, SpellCheckWordInfo& result, int maxGuesses)
+SmartKeyErrorCode SmkySpellCheckEngine::_checkSpelling (const std::string& word, SpellCheckWordInfo& result, int maxGuesses, const SmkyDeadline& deadline)
 {
     result.clear();
 
@@ -224,15 +620,18 @@ SmartKeyErrorCode SmkySpellCheckEngine::checkSpelling (const std::string& word,
         return SKERR_SUCCESS;
     }
 
+    //  all the dictionaries below are searched with one lookup
+    unsigned int known_word = _findKnownWord(word);
+
     //  b) If whitelist is non-empty. check it.  If found set result.inDictionary=true; and return success
-    if ( m_white_dictionary.find(word) )
+    if ( known_word & SmkyKnownWords::LAYER_WHITELIST )
     {
         result.inDictionary = true;
         return SKERR_SUCCESS;
     }
 
     //  c) Check word in auto sub dictionary.
-    string auto_subdb_word = mp_autoSubDb->findEntry(word);
+    string auto_subdb_word = (known_word & SmkyKnownWords::LAYER_AUTOSUB) ? mp_autoSubDb->findEntry(word) : "";
 
     //  d) If word is all digits, set result.inDictionary=true; and return success
     if (_wordIsAllDigits(word))
@@ -242,19 +641,14 @@ SmartKeyErrorCode SmkySpellCheckEngine::checkSpelling (const std::string& word,
     }
 
     //  e) If no result found look word up in dictionaries: manufacturer and user (person and context)
-    if ( mp_manDb->findEntry(word) || mp_userDb->findWord(word) )
+    if ( known_word & (SmkyKnownWords::LAYER_MANUFACTURER | SmkyKnownWords::LAYER_USER) )
     {
         result.inDictionary = true;
         return SKERR_SUCCESS;
     }
 
-    if ( mp_hunspDb->findEntry(word) )
-    {
-        result.inDictionary = true;
-    }
-
-    //  f) If word not found in dictionaries, get a list of guesses from dictionaries.
-    if ( mp_hunspDb->findGuesses(word, result, maxGuesses) == SKERR_SUCCESS)
+    //  f) Check word in hunspell dictionary and get a list of guesses (word is spelled only once)
+    if ( _checkAndSuggest(word, result, maxGuesses, deadline, false) == SKERR_SUCCESS)
     {
         if (result.inDictionary) //entry was found, clear auto replace flag
         {
@@ -285,7 +679,61 @@ SmartKeyErrorCode SmkySpellCheckEngine::checkSpelling (const std::string& word,
 }
 
 /**
-* auto correct
+* check word in hunspell dictionary of the current locale and find guesses. In multi-language mode
+* the word is good if any locale accepts it: locales are checked in order and the first one accepting
+* the word ends the check (no guesses are needed then). Guesses of a word misspelled in all locales are
+* found in extra locales by pool threads while the calling thread finds guesses of the current locale,
+* then they are merged by weights of the locales.
+*
+* @param word
+*   word to check
+*
+* @param result
+*   output: result.inDictionary is set if word is good, guesses are added
+*
+* @param maxGuesses
+*   number of words in result
+*
+* @param deadline
+*   time budget of the request
+*
+* @param rankByKeys
+*   weight edit cost of guesses by keyboard distance
+*
+* @return SmartKeyErrorCode
+*   SKERR_SUCCESS if dictionary of the current locale is loaded
+*/
+SmartKeyErrorCode SmkySpellCheckEngine::_checkAndSuggest (const std::string& word, SpellCheckWordInfo& result, int maxGuesses, const SmkyDeadline& deadline, bool rankByKeys)
+{
+    SmkyHunspellDatabase* p_hunspDb = _getHunspellDb();
+
+    if (mp_extraLocales->isEmpty() || !p_hunspDb->isLoaded())
+        return(p_hunspDb->checkAndSuggest(word, result, maxGuesses, deadline, rankByKeys));
+
+    //words of the current locale are checked as in single language mode
+    if (p_hunspDb->findEntry(word))
+    {
+        result.inDictionary = true;
+        return(p_hunspDb->findGuesses(word, result, maxGuesses, deadline, rankByKeys));
+    }
+
+    const std::string& language = Settings::getInstance()->localeSettings.m_inputLanguage;
+
+    if (mp_extraLocales->findEntry(word, language))
+    {
+        result.inDictionary = true;
+        return(SKERR_SUCCESS);
+    }
+
+    SmkyExtraLocales::Search* p_search = mp_extraLocales->startGuesses(word, maxGuesses, deadline, rankByKeys, language);
+    SmartKeyErrorCode err = p_hunspDb->findGuesses(word, result, maxGuesses, deadline, rankByKeys);
+    mp_extraLocales->finishGuesses(p_search, result, maxGuesses);
+
+    return(err);
+}
+
+/**
+* auto correct, results are cached until any dictionary or locale is changed
 *
 * @param word
 *   word to correct
@@ -299,10 +747,54 @@ SmartKeyErrorCode SmkySpellCheckEngine::checkSpelling (const std::string& word,
 * @param maxGuesses
 *   number of words in result
 *
+* @param budgetMs
+*   time budget (ms) for suggestions, < 0 - default from settings, 0 - no limit
+*
+* @param ticket
+*   request ticket, suggestions are cut short when request is superseded
+*
 * @return SmartKeyErrorCode
 *   SKERR_SUCCESS if done
 */
-SmartKeyErrorCode SmkySpellCheckEngine::autoCorrect (const std::string& word, const std::string& context, SpellCheckWordInfo& result, int maxGuesses)
+SmartKeyErrorCode SmkySpellCheckEngine::autoCorrect (const std::string& word, const std::string& context, SpellCheckWordInfo& result, int maxGuesses, int budgetMs, const SmkyRequestTicket& ticket)
+{
+    std::string locale = Settings::getInstance()->localeSettings.getFullLocale();
+
+    if (m_cache.lookup(word, maxGuesses, SmkySpellCheckCache::MODE_AUTO_CORRECT, locale, result))
+        return SKERR_SUCCESS;
+
+    SmkyDeadline deadline(_getBudgetMs(budgetMs), ticket);
+    SmartKeyErrorCode err = _autoCorrect(word, context, result, maxGuesses, deadline);
+
+    //partial results depend on timing, don't keep them
+    if (err == SKERR_SUCCESS && !result.partial)
+        m_cache.store(word, maxGuesses, SmkySpellCheckCache::MODE_AUTO_CORRECT, locale, result);
+
+    return err;
+}
+
+/**
+* auto correct through all the dictionaries
+*
+* @param word
+*   word to correct
+*
+* @param context
+*   context (parameter is not used)
+*
+* @param result
+*   result
+*
+* @param maxGuesses
+*   number of words in result
+*
+* @param deadline
+*   time budget of the request
+*
+* @return SmartKeyErrorCode
+*   SKERR_SUCCESS if done
+*/
+SmartKeyErrorCode SmkySpellCheckEngine::_autoCorrect (const std::string& word, const std::string& context, SpellCheckWordInfo& result, int maxGuesses, const SmkyDeadline& deadline)
 {
     result.clear();
 
@@ -316,8 +808,11 @@ SmartKeyErrorCode SmkySpellCheckEngine::autoCorrect (const std::string& word, co
         return SKERR_SUCCESS;
     }
 
+    //  all the dictionaries below are searched with one lookup
+    unsigned int known_word = _findKnownWord(word);
+
     //  b) If whitelist is non-empty. check it.  If found set result.inDictionary=true; and return success
-    if ( m_white_dictionary.find(word) )
+    if ( known_word & SmkyKnownWords::LAYER_WHITELIST )
     {
         result.inDictionary = true;
         return SKERR_SUCCESS;
@@ -325,7 +820,7 @@ SmartKeyErrorCode SmkySpellCheckEngine::autoCorrect (const std::string& word, co
 
     //  c) Check word in auto sub dictionary.
     //         If found: add to result.guesses: .spellCorrection=false; .autoReplace=true; .autoAccept=true;
-    string auto_subdb_word = mp_autoSubDb->findEntry(word);
+    string auto_subdb_word = (known_word & SmkyKnownWords::LAYER_AUTOSUB) ? mp_autoSubDb->findEntry(word) : "";
     WordGuess word_guess;
 
     if ( auto_subdb_word.length() > 0 )
@@ -345,19 +840,15 @@ SmartKeyErrorCode SmkySpellCheckEngine::autoCorrect (const std::string& word, co
     }
 
     //  e) If no result found look word up in dictionaries
-    if ( mp_manDb->findEntry(word) || mp_userDb->findWord(word) )
+    if ( known_word & (SmkyKnownWords::LAYER_MANUFACTURER | SmkyKnownWords::LAYER_USER) )
     {
         result.inDictionary = true;
         return SKERR_SUCCESS;
     }
 
-    if ( mp_hunspDb->findEntry(word) )
-    {
-        result.inDictionary = true;
-    }
-
-    //  f) If word not found in dictionaries, get a list of guesses from dictionaries.
-    if ( mp_hunspDb->findGuesses(word, result, maxGuesses) == SKERR_SUCCESS)
+    //  f) Check word in hunspell dictionary and get a list of guesses (word is spelled only once),
+    //     guesses are ranked by keyboard distance, so the first one is the most likely typo correction
+    if ( _checkAndSuggest(word, result, maxGuesses, deadline, true) == SKERR_SUCCESS)
     {
         return SKERR_SUCCESS;
     }
@@ -472,12 +963,47 @@ SmartKeyErrorCode SmkySpellCheckEngine::processTaps (const TapDataArray& taps, S
 */
 SmartKeyErrorCode SmkySpellCheckEngine::getCompletion (const std::string& prefix, std::string& result)
 {
-    result.clear();
+    std::vector<std::string> results;
+    SmartKeyErrorCode err = getCompletions(prefix, 1, results);
+
+    result = results.empty() ? "" : results[0];
+
+    return(err);
+}
+
+/**
+* order completions of the same dictionary: more frequent first
+*/
+static bool compare_completion_rank (const std::pair<gint64, std::string>& first, const std::pair<gint64, std::string>& second)
+{
+    return (first.first > second.first);
+}
+
+/**
+* get ranked completions: every dictionary is asked for up to maxResults words with the prefix (one seek in the
+* sorted index and a step per word), words are ranked by dictionary (auto substitutions, user words, manufacturer
+* words, locale words) and by frequency inside of the dictionary, duplicates are skipped
+*
+* @param prefix
+*   look for words starting with this prefix
+*
+* @param maxResults
+*   limit number of completions
+*
+* @param results
+*   output: completions, the best first
+*
+* @return SmartKeyErrorCode
+*   return code
+*/
+SmartKeyErrorCode SmkySpellCheckEngine::getCompletions (const std::string& prefix, size_t maxResults, std::vector<std::string>& results)
+{
+    results.clear();
 
     if (!m_initialized)
         return(SKERR_FAILURE);
 
-    if (prefix.empty())
+    if (prefix.empty() || maxResults == 0)
         return(SKERR_BAD_PARAM);
 
     //  TODO:  This may not be necessary, but just in case:
@@ -487,41 +1013,57 @@ SmartKeyErrorCode SmkySpellCheckEngine::getCompletion (const std::string& prefix
         return SKERR_SUCCESS;
     }
 
-    //  b) If there's a match in the auto sub database, use that
-    string auto_word = mp_autoSubDb->findWordByPrefix(prefix);
+    //  b) Lookup the prefix (partially entered string) in the dictionaries, in order of priority:
+    //     auto sub database, user (person and context), manufacturer, locale (words and frequency list)
+    enum { COMPLETION_AUTOSUB = 0, COMPLETION_USER, COMPLETION_MANUFACTURER, COMPLETION_LOCALE, COMPLETION_SOURCES };
+    std::list<std::string> found[COMPLETION_SOURCES];
+    SmkyHunspellDatabase* p_hunspDb = _getHunspellDb();
 
-    if ( auto_word.length() > 0 )
-    {
-        result = auto_word;
-    }
-    else
+    mp_autoSubDb->findWordsByPrefix(prefix, maxResults, found[COMPLETION_AUTOSUB]);
+    mp_userDb->findWordsByPrefix(prefix, maxResults, found[COMPLETION_USER]);
+    mp_manDb->findWordsByPrefix(prefix, maxResults, found[COMPLETION_MANUFACTURER]);
+    p_hunspDb->findCompletions(prefix, maxResults, found[COMPLETION_LOCALE]);
+    m_locale_dictionary.find_all_by_prefix(prefix, maxResults, found[COMPLETION_LOCALE]);
+
+    //  c) Rank words of every dictionary by frequency (order of dictionary is kept for unknown words), skip duplicates
+    std::set<std::string> unique;
+
+    for (int source = 0; source < COMPLETION_SOURCES && results.size() < maxResults; ++source)
     {
-        //  c) Otherwise lookup the prefix (partially entered string) in the dictionaries to get an autocompletion match, if there is one
-        auto_word = mp_userDb->findWordByPrefix(prefix);
-        if (auto_word.length() > 0 )
+        std::vector< std::pair<gint64, std::string> > ranked;
+
+        for (std::list<std::string>::iterator it = found[source].begin(); it != found[source].end(); ++it)
         {
-            result = auto_word;
-            return(SKERR_SUCCESS);
+            ranked.push_back(std::make_pair((gint64)p_hunspDb->getFrequency(*it), *it));
         }
 
-        auto_word = mp_manDb->findWordByPrefix(prefix);
-        if (auto_word.length() > 0 )
+        std::stable_sort(ranked.begin(), ranked.end(), compare_completion_rank);
+
+        for (size_t i = 0; i < ranked.size() && results.size() < maxResults; ++i)
         {
-            result = auto_word;
-            return(SKERR_SUCCESS);
+            if (unique.insert(ranked[i].second).second)
+                results.push_back(ranked[i].second);
         }
+    }
 
-        //  If word not found in dictionaries, get a list of guesses from dictionaries.
+    //  d) If word not found in dictionaries, get a list of guesses from dictionaries.
+    if (results.empty())
+    {
         SpellCheckWordInfo info;
         info.clear();
 
-        if ( mp_hunspDb->findGuesses(prefix, info, 1) == SKERR_SUCCESS)
+        SmkyDeadline deadline(_getBudgetMs(-1));
+
+        if ( p_hunspDb->findGuesses(prefix, info, maxResults, deadline) == SKERR_SUCCESS)
         {
-            result = info.guesses.at(0).guess;
-            return SKERR_SUCCESS;
+            for (size_t i = 0; i < info.guesses.size(); ++i)
+            {
+                results.push_back(info.guesses[i].guess);
+            }
         }
     }
-    //  d) Return valid error code
+
+    //  e) Return valid error code
     return(SKERR_SUCCESS);
 }
 
@@ -531,15 +1073,166 @@ SmartKeyErrorCode SmkySpellCheckEngine::getCompletion (const std::string& prefix
 */
 void SmkySpellCheckEngine::changedLocaleSettings (void)
 {
+    //cached results belong to the previous locale
+    m_cache.clear();
+
     if (m_initialized)
     {
-        //load locale words
-        m_locale_dictionary.load( _getLocaleIndependDbPath(), _getLocaleDependDbPath() );
+        SmkyLocaleDictionaries dicts(Settings::getInstance()->localeSettings);
 
-        //load whitelist
-        m_white_dictionary.load( _getWhitelistIndependDbPath(), _getWhitelistDependDbPath() );
-
-        mp_hunspDb->changedLocaleSettings();
+        loadLocale(dicts);
+        swapLocale(dicts);
     }
 }
 
+/**
+* load locale words, whitelist and hunspell dictionary of the locale,
+* it takes a while for big hunspell dictionaries, so it can be done in background
+* while the engine serves requests with dictionaries of the current locale
+*
+* @param io_dicts
+*   locale to load, output: loaded dictionaries
+*/
+void SmkySpellCheckEngine::loadLocale (SmkyLocaleDictionaries& io_dicts)
+{
+    gint64 start = g_get_monotonic_time();
+
+    io_dicts.localeWords->load(_getLocaleDependDbPath(io_dicts.locale));
+    io_dicts.whitelistWords->load(_getWhitelistDependDbPath(io_dicts.locale));
+
+    delete io_dicts.hunspell;
+    io_dicts.hunspell = new SmkyHunspellDatabase(io_dicts.locale);
+
+    //each worker thread but the one using io_dicts.hunspell needs a copy (see _getHunspellDb)
+    for (size_t i = 0; i < io_dicts.workerCopies.size(); ++i)
+        delete io_dicts.workerCopies[i];
+    io_dicts.workerCopies.clear();
+
+    for (int i = 1; i < Settings::getInstance()->workerThreads; ++i)
+        io_dicts.workerCopies.push_back(new SmkyHunspellDatabase(io_dicts.locale));
+
+    io_dicts.loadMs = (g_get_monotonic_time() - start) / 1000.0;
+
+    g_debug("SpellCheckEngine: dictionaries of locale '%s' loaded in %g msec",
+            io_dicts.locale.getFullLocale().c_str(), io_dicts.loadMs);
+}
+
+/**
+* replace locale dependent dictionaries with loaded ones, caller holds the exclusive lock,
+* Settings::localeSettings are expected to be changed to the loaded locale meanwhile
+*
+* @param io_dicts
+*   loaded dictionaries, output: previous dictionaries of the engine
+*
+* @return bool
+*   true if dictionaries were exchanged, false if engine is not initialized (io_dicts are not changed)
+*/
+bool SmkySpellCheckEngine::swapLocale (SmkyLocaleDictionaries& io_dicts)
+{
+    //cached results belong to the previous locale
+    m_cache.clear();
+
+    if (!m_initialized)
+        return(false);
+
+    io_dicts.localeWords = m_locale_dictionary.swapDependent(io_dicts.localeWords);
+    io_dicts.whitelistWords = m_white_dictionary.swapDependent(io_dicts.whitelistWords);
+    std::swap(mp_hunspDb, io_dicts.hunspell);
+
+    //copies of worker threads are exchanged too, threads take new ones on their next request
+    g_mutex_lock(&m_worker_mutex);
+
+    std::vector<SmkyHunspellDatabase*> previous(m_spare_dbs);
+    for (WorkerDbMap::iterator it = m_worker_dbs.begin(); it != m_worker_dbs.end(); ++it)
+        previous.push_back(it->second);
+
+    m_worker_dbs.clear();
+    m_spare_dbs.swap(io_dicts.workerCopies);
+    io_dicts.workerCopies.swap(previous);
+
+    //copies being preloaded belong to the previous locale
+    m_locale_generation++;
+    m_preloading = 0;
+    g_cond_broadcast(&m_worker_cond);
+
+    g_mutex_unlock(&m_worker_mutex);
+
+    //extra locales are kept, only their guesses follow the keyboard of the new locale
+    if (mp_extraLocales)
+        mp_extraLocales->setKeyboardLayout(io_dicts.locale.m_keyboardLayout);
+
+    m_locale_switch_ms = io_dicts.loadMs;
+
+    return(true);
+}
+
+/**
+* SmkyLocaleDictionaries
+*
+* @param i_locale
+*   locale of the dictionaries
+*/
+SmkyLocaleDictionaries::SmkyLocaleDictionaries (const LocaleSettings& i_locale)
+    : locale(i_locale)
+    , localeWords(new SmkyFileKeywords())
+    , whitelistWords(new SmkyFileKeywords())
+    , hunspell(NULL)
+    , loadMs(0)
+{
+}
+
+/**
+* ~SmkyLocaleDictionaries
+*/
+SmkyLocaleDictionaries::~SmkyLocaleDictionaries (void)
+{
+    delete localeWords;
+    delete whitelistWords;
+    delete hunspell;
+
+    for (size_t i = 0; i < workerCopies.size(); ++i)
+        delete workerCopies[i];
+}
+
+/**
+* estimated memory used by the dictionaries: keys, values and overhead of all of them
+*
+* @return size_t
+*   bytes
+*/
+size_t SmkyLocaleDictionaries::memoryUsed (void) const
+{
+    std::vector<DictionaryStats> stats(2);
+
+    localeWords->getStats(stats[0]);
+    whitelistWords->getStats(stats[1]);
+
+    if (hunspell)
+        hunspell->getStats(stats);
+
+    for (size_t i = 0; i < workerCopies.size(); ++i)
+        workerCopies[i]->getStats(stats);
+
+    size_t bytes = 0;
+    for (std::vector<DictionaryStats>::const_iterator it = stats.begin(); it != stats.end(); ++it)
+        bytes += it->keyBytes + it->valueBytes + it->overheadBytes;
+
+    return(bytes);
+}
+
+/**
+* rank guesses of hunspell dictionary and its worker copies by other keyboard layout,
+* e.g. when dictionaries are reused for the same language with other keyboard
+*
+* @param i_layout
+*   name of the layout
+*/
+void SmkyLocaleDictionaries::setKeyboardLayout (const std::string& i_layout)
+{
+    if (hunspell)
+        hunspell->setKeyboardLayout(i_layout);
+
+    for (size_t i = 0; i < workerCopies.size(); ++i)
+        workerCopies[i]->setKeyboardLayout(i_layout);
+}
+
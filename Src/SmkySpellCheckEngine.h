@@ -19,18 +19,24 @@
 #ifndef SMKY_SPELL_CHECK_ENGINE_H
 #define SMKY_SPELL_CHECK_ENGINE_H
 
+#include <map>
 #include <set>
 #include <string>
+#include <vector>
 #include "SmkyManufacturerDatabase.h"
 #include "SmkyUserDatabase.h"
 #include "SmkyAutoSubDatabase.h"
+#include "SmkyKnownWords.h"
 #include "StringUtils.h"
 #include "SmkyKeywordsBundle.h"
+#include "SmkySpellCheckCache.h"
+#include "SmkyDeadline.h"
 #include "SpellCheckClient.h"
 
 namespace SmartKey
 {
 class SmkyHunspellDatabase;
+class SmkyExtraLocales;
 struct SpellCheckWordInfo;
 
 const size_t SEL_LIST_SIZE = 32;
@@ -42,6 +48,34 @@ enum EShiftState
     eShiftState_lock
 };
 
+/**
+ * Locale dependent dictionaries loaded for a locale (see SmkySpellCheckEngine::loadLocale()),
+ * swapLocale() exchanges them with dictionaries of the engine, the previous ones are released
+ * together with this object or kept for a later switch back (see SmkyLocalePool).
+ */
+struct SmkyLocaleDictionaries
+{
+    LocaleSettings        locale;
+    SmkyFileKeywords*     localeWords;
+    SmkyFileKeywords*     whitelistWords;
+    SmkyHunspellDatabase* hunspell;
+    std::vector<SmkyHunspellDatabase*> workerCopies; ///< copies of hunspell for other worker threads
+    double                loadMs;
+
+    SmkyLocaleDictionaries (const LocaleSettings& i_locale);
+    ~SmkyLocaleDictionaries (void);
+
+    //estimated memory used by the dictionaries (bytes)
+    size_t memoryUsed (void) const;
+
+    //rank guesses of hunspell dictionaries by other keyboard layout
+    void setKeyboardLayout (const std::string& i_layout);
+
+private:
+    SmkyLocaleDictionaries (const SmkyLocaleDictionaries&);     // don't implement
+    void operator= (const SmkyLocaleDictionaries&);             // don't implement
+};
+
 /**
  * Our wrapper around the spell check engine.
  */
@@ -57,6 +91,9 @@ private:
     //hunspell dictionary
     SmkyHunspellDatabase*     mp_hunspDb;
 
+    //hunspell dictionaries of other languages checked in multi-language mode
+    SmkyExtraLocales*         mp_extraLocales;
+
     //user db
     SmkyUserDatabase*         mp_userDb;
 
@@ -76,20 +113,59 @@ private:
     //string like '{"languages":["en_un","es_un","fr_un","de_un","it_un"]}'
     std::string              m_supported_languages;
 
+    //cache of checkSpelling/autoCorrect results
+    SmkySpellCheckCache       m_cache;
+
+    //all words of whitelist, auto substitution, manufacturer and user dictionaries, updated
+    //under exclusive lock when dictionaries are changed (see getDictionaryGeneration())
+    SmkyKnownWords            m_known_words;
+    gint                      m_known_words_generation;
+
+    //duration of the last update of m_known_words and of the last locale change (ms)
+    double                    m_known_words_ms;
+    double                    m_locale_switch_ms;
+
+    typedef std::map<GThread*, SmkyHunspellDatabase*> WorkerDbMap;
+
+    //thread which uses mp_hunspDb (first one which asked for it)
+    GThread*                  mp_hunspOwner;
+
+    //copies of mp_hunspDb taken by other threads and copies not taken yet
+    WorkerDbMap               m_worker_dbs;
+    std::vector<SmkyHunspellDatabase*> m_spare_dbs;
+    GMutex                    m_worker_mutex;
+
+    //signalled when a preloaded copy is added to m_spare_dbs or preloading stops
+    GCond                     m_worker_cond;
+
+    //copies still to be loaded by mp_preloadThread for locale m_preload_locale
+    int                       m_preloading;
+    GThread*                  mp_preloadThread;
+    LocaleSettings            m_preload_locale;
+
+    //incremented on each locale change, preloaded copies of previous locale are dropped
+    gint                      m_locale_generation;
+
+    //readers are requests, writers are dictionary and locale changes
+    GRWLock                   m_lock;
+
 public:
 
     SmkySpellCheckEngine(void);
     virtual ~SmkySpellCheckEngine();
 
-    //spell check word
-    virtual SmartKeyErrorCode checkSpelling (const std::string& word, SpellCheckWordInfo& result, int maxGuesses);
+    //spell check word (budgetMs < 0 - use default time budget from settings, 0 - no limit; suggestions stop when ticket is superseded)
+    virtual SmartKeyErrorCode checkSpelling (const std::string& word, SpellCheckWordInfo& result, int maxGuesses, int budgetMs = -1, const SmkyRequestTicket& ticket = SmkyRequestTicket());
 
-    //try to correct word
-    virtual SmartKeyErrorCode autoCorrect (const std::string& word, const std::string& context, SpellCheckWordInfo& result, int maxGuesses);
+    //try to correct word (budgetMs < 0 - use default time budget from settings, 0 - no limit; suggestions stop when ticket is superseded)
+    virtual SmartKeyErrorCode autoCorrect (const std::string& word, const std::string& context, SpellCheckWordInfo& result, int maxGuesses, int budgetMs = -1, const SmkyRequestTicket& ticket = SmkyRequestTicket());
 
     //get completion for the word
     virtual SmartKeyErrorCode getCompletion (const std::string& prefix, std::string& result);
 
+    //get up to maxResults ranked completions for the word
+    virtual SmartKeyErrorCode getCompletions (const std::string& prefix, size_t maxResults, std::vector<std::string>& results);
+
     //get user db instance
     virtual SmkyUserDatabase* getUserDatabase (void);
 
@@ -99,18 +175,44 @@ public:
     //get manufacturer db instance
     virtual SmkyManufacturerDatabase* getManufacturerDatabase (void);
 
-    //used for notification class instance about locale change
+    //used for notification class instance about locale change (dictionaries are loaded right away)
     virtual void changedLocaleSettings (void);
 
+    //load locale dependent dictionaries (any thread, the engine is not used)
+    static void loadLocale (SmkyLocaleDictionaries& io_dicts);
+
+    //replace locale dependent dictionaries with loaded ones (engine must be locked exclusively), return false if not swapped
+    bool swapLocale (SmkyLocaleDictionaries& io_dicts);
+
     //get list of supported languages
     virtual const char* getSupportedLanguages (void);
 
+    //append memory usage and load time of all dictionaries and caches (engine must be locked)
+    void getStats (std::vector<DictionaryStats>& o_stats);
+
+    //number of hunspell dictionaries loaded for worker threads (in addition to the main one)
+    size_t getWorkerDictionaries (void);
+
+    //load copies of hunspell dictionary in background, so that each of i_threads worker threads has one
+    void startWorkerDictionaries (int i_threads);
+
+    //duration of the last locale change (ms)
+    double getLocaleSwitchMs (void) const;
+
     //process trace
     virtual SmartKeyErrorCode processTrace (const std::vector<unsigned int>& points, EShiftState shift, const std::string& firstChars, const std::string& lastChars, SpellCheckWordInfo& result, int maxGuesses);
 
     //process taps
     virtual SmartKeyErrorCode processTaps (const TapDataArray& taps, SpellCheckWordInfo& result, int maxGuesses);
 
+    //lock engine for request processing (many threads at once)
+    void lockShared (void);
+    void unlockShared (void);
+
+    //lock engine for dictionary or locale change (waits for running requests)
+    void lockExclusive (void);
+    bool tryLockExclusive (void);
+    void unlockExclusive (void);
 
 private:
     //is current language supported?
@@ -119,6 +221,33 @@ private:
     //release all allocated objects
     void  _clean (void);
 
+    //get hunspell dictionary of calling thread
+    SmkyHunspellDatabase* _getHunspellDb (void);
+
+    //load copies of hunspell dictionary for worker threads
+    static gpointer _preloadThread (gpointer ctx);
+
+    //stop loading copies of hunspell dictionary, wait for the thread
+    void _stopPreload (void);
+
+    //update m_known_words if dictionaries were changed
+    void _updateKnownWords (void);
+
+    //get dictionaries containing the word (bits of SmkyKnownWords::Layer)
+    unsigned int _findKnownWord (const std::string& word);
+
+    //spell check word (not cached)
+    SmartKeyErrorCode _checkSpelling (const std::string& word, SpellCheckWordInfo& result, int maxGuesses, const SmkyDeadline& deadline);
+
+    //check word in hunspell dictionaries (of the current locale and extra ones) and find guesses
+    SmartKeyErrorCode _checkAndSuggest (const std::string& word, SpellCheckWordInfo& result, int maxGuesses, const SmkyDeadline& deadline, bool rankByKeys);
+
+    //try to correct word (not cached)
+    SmartKeyErrorCode _autoCorrect (const std::string& word, const std::string& context, SpellCheckWordInfo& result, int maxGuesses, const SmkyDeadline& deadline);
+
+    //get time budget of request
+    static int _getBudgetMs (int budgetMs);
+
     //get selection results
     SmartKeyErrorCode _getSelectionResults (SpellCheckWordInfo& result, int maxGuesses);
 
@@ -128,16 +257,112 @@ private:
     //get path to locale independent db
     std::string _getLocaleIndependDbPath (void) const;
 
-    //get path to locale dependent db
-    std::string _getLocaleDependDbPath (void) const;
+    //get path to locale dependent db of the locale
+    static std::string _getLocaleDependDbPath (const LocaleSettings& i_locale);
 
     //get path to locale independent whitelist db
     std::string _getWhitelistIndependDbPath (void) const;
 
-    //get path to locale dependent whitelist db
-    std::string _getWhitelistDependDbPath (void) const;
+    //get path to locale dependent whitelist db of the locale
+    static std::string _getWhitelistDependDbPath (const LocaleSettings& i_locale);
 };
 
+/**
+ * Shared lock of engine for the scope of request.
+ */
+class SmkyEngineReadLock
+{
+private:
+    SmkySpellCheckEngine* mp_engine;
+
+public:
+    SmkyEngineReadLock (SmkySpellCheckEngine* ip_engine) : mp_engine(ip_engine)
+    {
+        if (mp_engine)
+            mp_engine->lockShared();
+    }
+
+    ~SmkyEngineReadLock (void)
+    {
+        if (mp_engine)
+            mp_engine->unlockShared();
+    }
+};
+
+/**
+ * Exclusive lock of engine for the scope of dictionary or locale change.
+ */
+class SmkyEngineWriteLock
+{
+private:
+    SmkySpellCheckEngine* mp_engine;
+
+public:
+    SmkyEngineWriteLock (SmkySpellCheckEngine* ip_engine) : mp_engine(ip_engine)
+    {
+        if (mp_engine)
+            mp_engine->lockExclusive();
+    }
+
+    ~SmkyEngineWriteLock (void)
+    {
+        if (mp_engine)
+            mp_engine->unlockExclusive();
+    }
+};
+
+/**
+* lock engine for request processing
+*/
+inline void SmkySpellCheckEngine::lockShared (void)
+{
+    g_rw_lock_reader_lock(&m_lock);
+}
+
+/**
+* unlock engine after request processing
+*/
+inline void SmkySpellCheckEngine::unlockShared (void)
+{
+    g_rw_lock_reader_unlock(&m_lock);
+}
+
+/**
+* lock engine for dictionary or locale change
+*/
+inline void SmkySpellCheckEngine::lockExclusive (void)
+{
+    g_rw_lock_writer_lock(&m_lock);
+}
+
+/**
+* lock engine for dictionary or locale change if no request is running
+*
+* @return bool
+*   true if engine is locked
+*/
+inline bool SmkySpellCheckEngine::tryLockExclusive (void)
+{
+    return(g_rw_lock_writer_trylock(&m_lock));
+}
+
+/**
+* unlock engine after dictionary or locale change, filter of known words is updated before
+*/
+inline void SmkySpellCheckEngine::unlockExclusive (void)
+{
+    _updateKnownWords();
+    g_rw_lock_writer_unlock(&m_lock);
+}
+
+/**
+* duration of the last locale change (ms)
+*/
+inline double SmkySpellCheckEngine::getLocaleSwitchMs (void) const
+{
+    return(m_locale_switch_ms);
+}
+
 /**
 * Return the auto-substitution (read/write) database.
 *
@@ -185,12 +410,15 @@ inline std::string SmkySpellCheckEngine::_getLocaleIndependDbPath (void) const
 /**
 * get path to locale dependent db
 *
+* @param i_locale
+*   locale settings
+*
 * @return string
 *   <return value description>
 */
-inline std::string SmkySpellCheckEngine::_getLocaleDependDbPath (void) const
+inline std::string SmkySpellCheckEngine::_getLocaleDependDbPath (const LocaleSettings& i_locale)
 {
-    return(Settings::getInstance()->getDBFilePath(Settings::DICT_LOCALE, Settings::DICT_LOCALE_DEPEND));
+    return(Settings::getInstance()->getDBFilePath(Settings::DICT_LOCALE, Settings::DICT_LOCALE_DEPEND, i_locale));
 }
 
 /**
@@ -207,12 +435,15 @@ inline std::string SmkySpellCheckEngine::_getWhitelistIndependDbPath (void) cons
 /**
 * get path to locale dependent whitelist db
 *
+* @param i_locale
+*   locale settings
+*
 * @return string
 *   <return value description>
 */
-inline std::string SmkySpellCheckEngine::_getWhitelistDependDbPath (void) const
+inline std::string SmkySpellCheckEngine::_getWhitelistDependDbPath (const LocaleSettings& i_locale)
 {
-    return(Settings::getInstance()->getDBFilePath(Settings::DICT_WHITE, Settings::DICT_LOCALE_DEPEND));
+    return(Settings::getInstance()->getDBFilePath(Settings::DICT_WHITE, Settings::DICT_LOCALE_DEPEND, i_locale));
 }
 
 }
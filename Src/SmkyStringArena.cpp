@@ -0,0 +1,174 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "SmkyStringArena.h"
+#include <string.h>
+#include <algorithm>
+
+using namespace SmartKey;
+
+/**
+* SmkyStringArena
+*/
+SmkyStringArena::SmkyStringArena (void)
+    : m_chunk_size(0)
+    , m_free(0)
+    , m_allocated(0)
+    , m_stored(0)
+{
+}
+
+/**
+* ~SmkyStringArena
+*/
+SmkyStringArena::~SmkyStringArena (void)
+{
+    clear();
+}
+
+/**
+* copy string into the arena, big strings which don't fit get a chunk of their own
+*
+* @param i_str
+*   string (not necessarily zero terminated)
+*
+* @param i_length
+*   length of the string
+*
+* @return const char*
+*   zero terminated copy
+*/
+const char* SmkyStringArena::store (const char* i_str, size_t i_length)
+{
+    size_t size = i_length + 1;
+    char* p_dst;
+
+    if (size > m_free && size > CHUNK_SIZE / 4)
+    {
+        //big string: keep the current chunk for small ones
+        p_dst = new char[size];
+        m_allocated += size;
+
+        if (m_chunks.empty())
+        {
+            m_chunks.push_back(p_dst);
+            m_chunk_sizes.push_back(size);
+        }
+        else
+        {
+            m_chunks.insert(m_chunks.end() - 1, p_dst);
+            m_chunk_sizes.insert(m_chunk_sizes.end() - 1, size);
+        }
+    }
+    else
+    {
+        if (size > m_free)
+        {
+            m_chunks.push_back(new char[CHUNK_SIZE]);
+            m_chunk_sizes.push_back(CHUNK_SIZE);
+            m_allocated += CHUNK_SIZE;
+            m_free = CHUNK_SIZE;
+            m_chunk_size = CHUNK_SIZE;
+        }
+
+        p_dst = m_chunks.back() + (m_chunk_size - m_free);
+        m_free -= size;
+    }
+
+    memcpy(p_dst, i_str, i_length);
+    p_dst[i_length] = '\0';
+    m_stored += size;
+
+    return(p_dst);
+}
+
+/**
+* allocate one block for strings which are going to be stored (e.g. size of the file being loaded),
+* so a load is a single allocation
+*
+* @param i_size
+*   number of bytes (including terminating zeros)
+*/
+void SmkyStringArena::reserve (size_t i_size)
+{
+    if (i_size <= m_free)
+        return;
+
+    size_t size = i_size > CHUNK_SIZE ? i_size : CHUNK_SIZE;
+
+    m_chunks.push_back(new char[size]);
+    m_chunk_sizes.push_back(size);
+    m_allocated += size;
+    m_free = size;
+    m_chunk_size = size;
+}
+
+/**
+* release all strings
+*/
+void SmkyStringArena::clear (void)
+{
+    for (size_t i = 0; i < m_chunks.size(); ++i)
+        delete [] m_chunks[i];
+
+    m_chunks.clear();
+    m_chunk_sizes.clear();
+    m_free = 0;
+    m_chunk_size = 0;
+    m_allocated = 0;
+    m_stored = 0;
+}
+
+/**
+* check whether the string is stored in the arena (or refers to a string kept elsewhere)
+*
+* @param ip_str
+*   string (may be NULL)
+*
+* @return bool
+*   true if the string is in one of the chunks
+*/
+bool SmkyStringArena::contains (const char* ip_str) const
+{
+    if (!ip_str)
+        return(false);
+
+    for (size_t i = 0; i < m_chunks.size(); ++i)
+    {
+        if (ip_str >= m_chunks[i] && ip_str < m_chunks[i] + m_chunk_sizes[i])
+            return(true);
+    }
+
+    return(false);
+}
+
+/**
+* exchange strings with other arena, e.g. with a compacted copy of live strings
+*
+* @param io_other
+*   other arena
+*/
+void SmkyStringArena::swap (SmkyStringArena& io_other)
+{
+    m_chunks.swap(io_other.m_chunks);
+    m_chunk_sizes.swap(io_other.m_chunk_sizes);
+    std::swap(m_chunk_size, io_other.m_chunk_size);
+    std::swap(m_free, io_other.m_free);
+    std::swap(m_allocated, io_other.m_allocated);
+    std::swap(m_stored, io_other.m_stored);
+}
@@ -0,0 +1,99 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SMKY_STRING_ARENA_H
+#define SMKY_STRING_ARENA_H
+
+#include <stddef.h>
+#include <vector>
+
+namespace SmartKey
+{
+
+/**
+ * Storage of strings allocated in big chunks: strings are never moved or freed one by one,
+ * all of them are released at once by clear() (or by swap() with a compacted copy).
+ * Stored strings are zero terminated.
+ */
+class SmkyStringArena
+{
+private:
+    enum { CHUNK_SIZE = 64 * 1024 };
+
+    std::vector<char*> m_chunks;
+    std::vector<size_t> m_chunk_sizes;
+
+    //size and free bytes of the last chunk
+    size_t m_chunk_size;
+    size_t m_free;
+
+    //bytes allocated for all chunks
+    size_t m_allocated;
+
+    //bytes of stored strings (including terminating zeros)
+    size_t m_stored;
+
+public:
+    SmkyStringArena (void);
+    ~SmkyStringArena (void);
+
+    //copy string into the arena, address stays valid until clear()
+    const char* store (const char* i_str, size_t i_length);
+
+    //make sure that next i_size bytes of strings are stored in one block
+    void reserve (size_t i_size);
+
+    //release all strings
+    void clear (void);
+
+    //bytes allocated by the arena
+    size_t allocated (void) const;
+
+    //bytes taken by stored strings
+    size_t stored (void) const;
+
+    //true if the string is stored in the arena
+    bool contains (const char* ip_str) const;
+
+    //exchange strings with other arena
+    void swap (SmkyStringArena& io_other);
+
+private:
+    SmkyStringArena (const SmkyStringArena&);           // don't implement
+    void operator= (const SmkyStringArena&);            // don't implement
+};
+
+/**
+* bytes allocated by the arena
+*/
+inline size_t SmkyStringArena::allocated (void) const
+{
+    return(m_allocated);
+}
+
+/**
+* bytes taken by stored strings (including terminating zeros)
+*/
+inline size_t SmkyStringArena::stored (void) const
+{
+    return(m_stored);
+}
+
+}
+
+#endif
@@ -0,0 +1,591 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "SmkySymSpellIndex.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <algorithm>
+#include <fstream>
+#include <set>
+
+using namespace SmartKey;
+using namespace std;
+
+static const char     k_magic[4] = { 'S', 'M', 'K', 'S' };
+static const uint32_t k_version = 2;
+
+//maximum edit distance of suggestions
+static const uint32_t k_max_distance = 2;
+
+//only deletes from the beginning of the word are indexed, it keeps the index small
+static const uint32_t k_prefix_length = 7;
+
+/**
+* compare index entries by hash only, used by std::equal_range
+*/
+class SmkyIndexEntryHashLess
+{
+public:
+    bool operator()(const SmkySymSpellIndex::IndexEntry& entry, uint32_t hash) const
+    {
+        return (entry.hash < hash);
+    }
+
+    bool operator()(uint32_t hash, const SmkySymSpellIndex::IndexEntry& entry) const
+    {
+        return (hash < entry.hash);
+    }
+};
+
+/**
+* SmkySymSpellIndex
+*/
+SmkySymSpellIndex::SmkySymSpellIndex (void)
+    : mp_map(NULL)
+    , m_map_size(0)
+    , m_flags(0)
+    , m_max_distance(k_max_distance)
+    , m_prefix_length(k_prefix_length)
+    , m_word_count(0)
+    , m_entry_count(0)
+    , mp_words(NULL)
+    , mp_entries(NULL)
+    , mp_pool(NULL)
+{
+}
+
+/**
+* ~SmkySymSpellIndex
+*/
+SmkySymSpellIndex::~SmkySymSpellIndex (void)
+{
+    close();
+}
+
+/**
+* release index
+*/
+void SmkySymSpellIndex::close (void)
+{
+    if (mp_map)
+    {
+        munmap(mp_map, m_map_size);
+    }
+
+    mp_map = NULL;
+    m_map_size = 0;
+
+    m_flags = 0;
+    m_max_distance = k_max_distance;
+    m_prefix_length = k_prefix_length;
+    m_word_count = 0;
+    m_entry_count = 0;
+    mp_words = NULL;
+    mp_entries = NULL;
+    mp_pool = NULL;
+}
+
+/**
+* map compiled index file into memory
+*
+* @param i_index_file
+*   path + filename of the index
+*
+* @return bool
+*   true if mapped and valid
+*/
+bool SmkySymSpellIndex::open (const std::string& i_index_file)
+{
+    close();
+
+    int fd = ::open(i_index_file.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return(false);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(Header))
+    {
+        mp_map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mp_map == MAP_FAILED)
+        {
+            mp_map = NULL;
+        }
+        else
+        {
+            m_map_size = st.st_size;
+        }
+    }
+
+    ::close(fd);
+
+    if (!mp_map)
+    {
+        g_debug("SymSpell: can't map index file: %s", i_index_file.c_str());
+        return(false);
+    }
+
+    const char* p_base = static_cast<const char*>(mp_map);
+    const Header* p_header = reinterpret_cast<const Header*>(p_base);
+
+    if (!_validate(p_header))
+    {
+        g_warning("SymSpell: invalid index file: %s", i_index_file.c_str());
+        close();
+        return(false);
+    }
+
+    m_flags = p_header->flags;
+    m_max_distance = p_header->max_distance;
+    m_prefix_length = p_header->prefix_length;
+    m_word_count = p_header->word_count;
+    m_entry_count = p_header->entry_count;
+    mp_words = reinterpret_cast<const uint32_t*>(p_base + p_header->words_offset);
+    mp_entries = reinterpret_cast<const IndexEntry*>(p_base + p_header->entries_offset);
+    mp_pool = p_base + p_header->pool_offset;
+
+    g_debug("SymSpell: mapped index of %u words from %s", m_word_count, i_index_file.c_str());
+
+    return(true);
+}
+
+/**
+* validate header against the size of mapped file
+*
+* @param ip_header
+*   header of mapped file
+*
+* @return bool
+*   true if valid
+*/
+bool SmkySymSpellIndex::_validate (const Header* ip_header) const
+{
+    if (memcmp(ip_header->magic, k_magic, sizeof(k_magic)) != 0 || ip_header->version != k_version)
+        return(false);
+
+    if (ip_header->word_count == 0 || ip_header->entry_count == 0 || ip_header->pool_size == 0)
+        return(false);
+
+    if (ip_header->entries_offset % sizeof(uint32_t) != 0 || ip_header->words_offset % sizeof(uint32_t) != 0)
+        return(false);
+
+    if ((uint64_t)ip_header->words_offset + (uint64_t)ip_header->word_count * sizeof(uint32_t) > m_map_size ||
+        (uint64_t)ip_header->entries_offset + (uint64_t)ip_header->entry_count * sizeof(IndexEntry) > m_map_size ||
+        (uint64_t)ip_header->pool_offset + ip_header->pool_size > m_map_size)
+        return(false);
+
+    const char* p_pool = static_cast<const char*>(mp_map) + ip_header->pool_offset;
+    return(p_pool[ip_header->pool_size - 1] == '\0');
+}
+
+/**
+* build index data
+*
+* @param i_words
+*   words to index
+*
+* @param o_words
+*   output: offsets of the words in the pool
+*
+* @param o_entries
+*   output: sorted index entries
+*
+* @param o_pool
+*   output: string pool
+*/
+void SmkySymSpellIndex::_makeIndex (const std::vector<std::string>& i_words, std::vector<uint32_t>& o_words, std::vector<IndexEntry>& o_entries, std::string& o_pool)
+{
+    std::set<std::string> known;
+    std::vector<UnicodeString> deletes;
+    UnicodeString word;
+
+    o_words.clear();
+    o_entries.clear();
+    o_pool.clear();
+
+    for (size_t i = 0; i < i_words.size(); ++i)
+    {
+        if (i_words[i].empty() || !g_utf8_validate(i_words[i].c_str(), -1, NULL) || !known.insert(i_words[i]).second)
+            continue;
+
+        _toLowerUnicode(i_words[i].c_str(), word);
+
+        if (word.size() > k_prefix_length)
+            word.resize(k_prefix_length);
+
+        uint32_t word_id = o_words.size();
+        o_words.push_back(o_pool.size());
+        o_pool.append(i_words[i]);
+        o_pool.push_back('\0');
+
+        deletes.clear();
+        _collectDeletes(word, k_max_distance, deletes);
+
+        for (size_t d = 0; d < deletes.size(); ++d)
+        {
+            IndexEntry entry;
+            entry.hash = _hash(deletes[d]);
+            entry.word = word_id;
+            o_entries.push_back(entry);
+        }
+    }
+
+    std::sort(o_entries.begin(), o_entries.end());
+    o_entries.erase(std::unique(o_entries.begin(), o_entries.end()), o_entries.end());
+}
+
+/**
+* collect all the strings made by deleting up to i_distance letters (including the string itself)
+*
+* @param i_str
+*   source string
+*
+* @param i_distance
+*   max number of deleted letters
+*
+* @param o_deletes
+*   output: unique deletes
+*/
+void SmkySymSpellIndex::_collectDeletes (const UnicodeString& i_str, uint32_t i_distance, std::vector<UnicodeString>& o_deletes)
+{
+    std::set<UnicodeString> unique;
+    std::vector<UnicodeString> level;
+
+    unique.insert(i_str);
+    level.push_back(i_str);
+
+    for (uint32_t d = 0; d < i_distance; ++d)
+    {
+        std::vector<UnicodeString> next;
+
+        for (size_t i = 0; i < level.size(); ++i)
+        {
+            for (size_t pos = 0; pos < level[i].size(); ++pos)
+            {
+                UnicodeString del = level[i];
+                del.erase(del.begin() + pos);
+
+                if (unique.insert(del).second)
+                    next.push_back(del);
+            }
+        }
+
+        level.swap(next);
+    }
+
+    o_deletes.assign(unique.begin(), unique.end());
+}
+
+/**
+* convert UTF-8 to lower case unicode string
+*
+* @param ip_str
+*   UTF-8 string
+*
+* @param o_str
+*   output: lower case unicode string
+*/
+void SmkySymSpellIndex::_toLowerUnicode (const char* ip_str, UnicodeString& o_str)
+{
+    o_str.clear();
+
+    for (const gchar* p = ip_str; *p; p = g_utf8_next_char(p))
+    {
+        o_str.push_back(g_unichar_tolower(g_utf8_get_char(p)));
+    }
+}
+
+/**
+* FNV-1a hash of unicode string
+*/
+uint32_t SmkySymSpellIndex::_hash (const UnicodeString& i_str)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < i_str.size(); ++i)
+    {
+        gunichar c = i_str[i];
+
+        for (int b = 0; b < 4; ++b)
+        {
+            hash ^= (c & 0xff);
+            hash *= 16777619u;
+            c >>= 8;
+        }
+    }
+
+    return(hash);
+}
+
+/**
+* edit distance with transpositions of adjacent letters (optimal string alignment)
+*
+* @param i_str1
+*   first string
+*
+* @param i_str2
+*   second string
+*
+* @param i_max
+*   max distance of interest
+*
+* @return uint32_t
+*   distance, or i_max + 1 if it is bigger than i_max
+*/
+uint32_t SmkySymSpellIndex::_distance (const UnicodeString& i_str1, const UnicodeString& i_str2, uint32_t i_max)
+{
+    size_t len1 = i_str1.size();
+    size_t len2 = i_str2.size();
+
+    if ((len1 > len2 ? len1 - len2 : len2 - len1) > i_max)
+        return(i_max + 1);
+
+    std::vector<uint32_t> prev2(len2 + 1), prev(len2 + 1), cur(len2 + 1);
+
+    for (size_t j = 0; j <= len2; ++j)
+        prev[j] = j;
+
+    for (size_t i = 1; i <= len1; ++i)
+    {
+        cur[0] = i;
+        uint32_t row_min = cur[0];
+
+        for (size_t j = 1; j <= len2; ++j)
+        {
+            uint32_t cost = (i_str1[i - 1] == i_str2[j - 1]) ? 0 : 1;
+            uint32_t value = std::min(std::min(prev[j] + 1, cur[j - 1] + 1), prev[j - 1] + cost);
+
+            if (i > 1 && j > 1 && i_str1[i - 1] == i_str2[j - 2] && i_str1[i - 2] == i_str2[j - 1])
+                value = std::min(value, prev2[j - 2] + 1);
+
+            cur[j] = value;
+            row_min = std::min(row_min, value);
+        }
+
+        if (row_min > i_max)
+            return(i_max + 1);
+
+        prev2.swap(prev);
+        prev.swap(cur);
+    }
+
+    return(std::min(prev[len2], i_max + 1));
+}
+
+/**
+* find words within the edit distance, closest first (ties in order of the word list)
+*
+* @param i_word
+*   misspelled word
+*
+* @param i_maxGuesses
+*   limit number of guesses
+*
+* @param o_guesses
+*   output: guesses
+*/
+void SmkySymSpellIndex::lookup (const std::string& i_word, int i_maxGuesses, std::vector<std::string>& o_guesses) const
+{
+    if (!isLoaded() || i_word.empty() || i_maxGuesses <= 0 || !g_utf8_validate(i_word.c_str(), -1, NULL))
+        return;
+
+    UnicodeString query;
+    _toLowerUnicode(i_word.c_str(), query);
+
+    UnicodeString prefix = query;
+    if (prefix.size() > m_prefix_length)
+        prefix.resize(m_prefix_length);
+
+    std::vector<UnicodeString> deletes;
+    _collectDeletes(prefix, m_max_distance, deletes);
+
+    std::set<uint32_t> checked;
+    std::vector< std::pair<uint32_t, uint32_t> > found; //(distance, word id)
+    UnicodeString candidate;
+    const IndexEntry* p_end = mp_entries + m_entry_count;
+
+    for (size_t d = 0; d < deletes.size(); ++d)
+    {
+        std::pair<const IndexEntry*, const IndexEntry*> range = std::equal_range(mp_entries, p_end, _hash(deletes[d]), SmkyIndexEntryHashLess());
+
+        for (const IndexEntry* p = range.first; p != range.second; ++p)
+        {
+            if (p->word >= m_word_count || !checked.insert(p->word).second)
+                continue;
+
+            const char* p_word = mp_pool + mp_words[p->word];
+
+            //the word itself is not a suggestion (but its case variants are)
+            if (i_word == p_word)
+                continue;
+
+            _toLowerUnicode(p_word, candidate);
+
+            uint32_t distance = _distance(query, candidate, m_max_distance);
+            if (distance <= m_max_distance)
+                found.push_back(std::pair<uint32_t, uint32_t>(distance, p->word));
+        }
+    }
+
+    std::sort(found.begin(), found.end());
+
+    //keep capitalization of the first letter like hunspell does
+    gunichar first = g_utf8_get_char(i_word.c_str());
+    bool capitalize = g_unichar_toupper(first) == first && g_unichar_tolower(first) != first;
+
+    for (size_t i = 0; i < found.size() && (int)o_guesses.size() < i_maxGuesses; ++i)
+    {
+        std::string guess = mp_pool + mp_words[found[i].second];
+
+        if (capitalize)
+        {
+            gunichar c = g_utf8_get_char(guess.c_str());
+            gchar buf[8];
+            gint len = g_unichar_to_utf8(g_unichar_toupper(c), buf);
+            guess.replace(0, g_utf8_skip[(guchar)guess[0]], buf, len);
+        }
+
+        if (std::find(o_guesses.begin(), o_guesses.end(), guess) == o_guesses.end())
+            o_guesses.push_back(guess);
+    }
+}
+
+/**
+* compile index file
+*
+* @param i_words
+*   words to index
+*
+* @param i_inflected
+*   words are an expanded word list with inflected forms (not stems only)
+*
+* @param i_index_file
+*   path + filename of the index
+*
+* @return bool
+*   true if written
+*/
+bool SmkySymSpellIndex::compile (const std::vector<std::string>& i_words, bool i_inflected, const std::string& i_index_file)
+{
+    std::vector<uint32_t> words;
+    std::vector<IndexEntry> entries;
+    std::string pool;
+
+    _makeIndex(i_words, words, entries, pool);
+
+    if (entries.empty())
+    {
+        g_warning("SymSpell: nothing to index for %s", i_index_file.c_str());
+        return(false);
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, k_magic, sizeof(k_magic));
+    header.version = k_version;
+    header.flags = i_inflected ? FLAG_INFLECTED : 0;
+    header.max_distance = k_max_distance;
+    header.prefix_length = k_prefix_length;
+    header.word_count = words.size();
+    header.entry_count = entries.size();
+    header.words_offset = sizeof(Header);
+    header.entries_offset = header.words_offset + words.size() * sizeof(uint32_t);
+    header.pool_offset = header.entries_offset + entries.size() * sizeof(IndexEntry);
+    header.pool_size = pool.size();
+
+    FILE* f = fopen(i_index_file.c_str(), "wb");
+    if (!f)
+    {
+        g_warning("SymSpell: can't create index file: %s", i_index_file.c_str());
+        return(false);
+    }
+
+    bool written = fwrite(&header, sizeof(header), 1, f) == 1 &&
+                   fwrite(&words[0], sizeof(uint32_t), words.size(), f) == words.size() &&
+                   fwrite(&entries[0], sizeof(IndexEntry), entries.size(), f) == entries.size() &&
+                   fwrite(pool.data(), 1, pool.size(), f) == pool.size();
+
+    written = (fclose(f) == 0) && written;
+
+    if (!written)
+    {
+        g_warning("SymSpell: failed to write index file: %s", i_index_file.c_str());
+        unlink(i_index_file.c_str());
+    }
+
+    return(written);
+}
+
+/**
+* read words from a word list (one per line), or from hunspell .dic file:
+* the first line (number of words) is skipped and affix flags are cut, so only stems are read
+*
+* @param i_file
+*   path + filename
+*
+* @param o_words
+*   output: words
+*
+* @param o_inflected
+*   output: false if only stems were read (.dic file)
+*
+* @return bool
+*   true if file was read
+*/
+bool SmkySymSpellIndex::readWordList (const std::string& i_file, std::vector<std::string>& o_words, bool& o_inflected)
+{
+    ifstream fin(i_file.c_str());
+
+    if (!fin.is_open())
+    {
+        g_debug("SymSpell: can't open word list: %s", i_file.c_str());
+        return(false);
+    }
+
+    bool is_dic = i_file.length() > 4 && i_file.compare(i_file.length() - 4, 4, ".dic") == 0;
+    std::string line;
+
+    o_inflected = !is_dic;
+
+    if (is_dic)
+        getline(fin, line);
+
+    while (getline(fin, line))
+    {
+        if (is_dic)
+        {
+            size_t end = line.find_first_of("/\t");
+            if (end != std::string::npos)
+                line.erase(end);
+        }
+
+        if (!line.empty() && line[line.length() - 1] == '\r')
+            line.erase(line.length() - 1);
+
+        if (!line.empty())
+            o_words.push_back(line);
+    }
+
+    return(true);
+}
@@ -0,0 +1,185 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SMKY_SYMSPELL_INDEX_H
+#define SMKY_SYMSPELL_INDEX_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <glib.h>
+
+namespace SmartKey
+{
+
+/**
+ * Symmetric delete (SymSpell) index: every word is indexed by the hashes of all the strings made
+ * by deleting up to max_distance letters from its prefix, so candidates within the edit distance are
+ * found by hashing the deletes of the query, without scanning the dictionary.
+ * Letters are compared as lower case unicode characters.
+ *
+ * Index is compiled offline (see Tools/DictionaryCompiler.cpp) and mapped into memory.
+ * File layout (native byte order):
+ *   Header
+ *   uint32_t   words[word_count]      offsets of words in the string pool
+ *   IndexEntry entries[entry_count]   (hash of delete, word id), sorted
+ *   char       pool[pool_size]        zero terminated UTF-8 words
+ */
+class SmkySymSpellIndex
+{
+public:
+    struct Header
+    {
+        char     magic[4];
+        uint32_t version;
+        uint32_t flags;
+        uint32_t max_distance;
+        uint32_t prefix_length;
+        uint32_t word_count;
+        uint32_t entry_count;
+        uint32_t words_offset;
+        uint32_t entries_offset;
+        uint32_t pool_offset;
+        uint32_t pool_size;
+    };
+
+    struct IndexEntry
+    {
+        uint32_t hash;
+        uint32_t word;
+
+        bool operator< (const IndexEntry& other) const
+        {
+            return (hash < other.hash || (hash == other.hash && word < other.word));
+        }
+
+        bool operator== (const IndexEntry& other) const
+        {
+            return (hash == other.hash && word == other.word);
+        }
+    };
+
+    enum
+    {
+        FLAG_INFLECTED = 1  //compiled from expanded word list, not from stems of .dic file
+    };
+
+    typedef std::vector<gunichar> UnicodeString;
+
+private:
+    //mapped file
+    void*                   mp_map;
+    size_t                  m_map_size;
+
+    //index data of mapped file
+    uint32_t                m_flags;
+    uint32_t                m_max_distance;
+    uint32_t                m_prefix_length;
+    uint32_t                m_word_count;
+    uint32_t                m_entry_count;
+    const uint32_t*         mp_words;
+    const IndexEntry*       mp_entries;
+    const char*             mp_pool;
+
+public:
+
+    SmkySymSpellIndex (void);
+    virtual ~SmkySymSpellIndex (void);
+
+    //map compiled index file into memory
+    bool open (const std::string& i_index_file);
+
+    //release index
+    void close (void);
+
+    //is index ready?
+    bool isLoaded (void) const;
+
+    //number of indexed words
+    uint32_t size (void) const;
+
+    //bytes of mapped index file
+    size_t mappedSize (void) const;
+
+    //has index inflected forms of words?
+    bool hasInflectedForms (void) const;
+
+    //find words within the edit distance, closest first
+    void lookup (const std::string& i_word, int i_maxGuesses, std::vector<std::string>& o_guesses) const;
+
+    //compile index file
+    static bool compile (const std::vector<std::string>& i_words, bool i_inflected, const std::string& i_index_file);
+
+    //read words from a word list (one per line) or from hunspell .dic file (stems only)
+    static bool readWordList (const std::string& i_file, std::vector<std::string>& o_words, bool& o_inflected);
+
+private:
+    //build index data
+    static void _makeIndex (const std::vector<std::string>& i_words, std::vector<uint32_t>& o_words, std::vector<IndexEntry>& o_entries, std::string& o_pool);
+
+    //collect all the deletes of the string (including string itself)
+    static void _collectDeletes (const UnicodeString& i_str, uint32_t i_distance, std::vector<UnicodeString>& o_deletes);
+
+    //convert UTF-8 to lower case unicode string
+    static void _toLowerUnicode (const char* ip_str, UnicodeString& o_str);
+
+    //hash of unicode string
+    static uint32_t _hash (const UnicodeString& i_str);
+
+    //edit distance (with transpositions), i_max + 1 if it is bigger than i_max
+    static uint32_t _distance (const UnicodeString& i_str1, const UnicodeString& i_str2, uint32_t i_max);
+
+    //validate mapped data
+    bool _validate (const Header* ip_header) const;
+};
+
+/**
+* is index ready?
+*/
+inline bool SmkySymSpellIndex::isLoaded (void) const
+{
+    return(mp_entries != NULL);
+}
+
+/**
+* number of indexed words
+*/
+inline uint32_t SmkySymSpellIndex::size (void) const
+{
+    return(m_word_count);
+}
+
+/**
+* bytes of mapped index file
+*/
+inline size_t SmkySymSpellIndex::mappedSize (void) const
+{
+    return(m_map_size);
+}
+
+/**
+* has index inflected forms of words?
+*/
+inline bool SmkySymSpellIndex::hasInflectedForms (void) const
+{
+    return((m_flags & FLAG_INFLECTED) != 0);
+}
+
+}
+
+#endif
@@ -69,6 +69,18 @@ public:
     //find word by prefix
     virtual std::string findWordByPrefix (const std::string& prefix);
 
+    //find up to max words by prefix, append them to o_words
+    virtual void findWordsByPrefix (const std::string& prefix, size_t max, std::list<std::string>& o_words);
+
+    //export pointers to user and context words, they are valid until the database is changed
+    void exportWords (std::vector<const char*>& o_words);
+
+    //append words added since the last call, return false if exported words became stale meanwhile
+    bool takeAddedWords (std::vector<const char*>& o_words);
+
+    //append memory usage and load time of user and context dictionaries
+    void getStats (std::vector<DictionaryStats>& o_stats) const;
+
     //notification about locale settings change
     virtual void changedLocaleSettings (void);
 
@@ -157,6 +169,75 @@ inline std::string SmkyUserDatabase::findWordByPrefix (const std::string& prefix
     return( m_context_database.find_by_prefix(prefix) );
 }
 
+/**
+* find words with prefix in user database (user words first, then context words)
+*
+* @param prefix
+*   prefix to search
+*
+* @param max
+*   limit number of words
+*
+* @param o_words
+*   output: found words are appended
+*/
+inline void SmkyUserDatabase::findWordsByPrefix (const std::string& prefix, size_t max, std::list<std::string>& o_words)
+{
+    size_t count = o_words.size();
+    m_user_database.find_all_by_prefix(prefix, max, o_words);
+
+    count = o_words.size() - count;
+    if (count < max)
+        m_context_database.find_all_by_prefix(prefix, max - count, o_words);
+}
+
+/**
+* export words of user and context dictionaries
+*
+* @param o_words
+*   output: words are appended
+*/
+inline void SmkyUserDatabase::exportWords (std::vector<const char*>& o_words)
+{
+    m_user_database.exportKeys(o_words);
+    m_context_database.exportKeys(o_words);
+}
+
+/**
+* append words added to user and context dictionaries since the last call
+*
+* @param o_words
+*   output: added words are appended
+*
+* @return bool
+*   false if words exported before are stale, all of them must be exported again
+*/
+inline bool SmkyUserDatabase::takeAddedWords (std::vector<const char*>& o_words)
+{
+    //both dictionaries forget their changes
+    bool valid = m_user_database.takeAddedKeys(o_words);
+    return(m_context_database.takeAddedKeys(o_words) && valid);
+}
+
+/**
+* append memory usage and load time of user and context dictionaries
+*
+* @param o_stats
+*   output: statistics are appended
+*/
+inline void SmkyUserDatabase::getStats (std::vector<DictionaryStats>& o_stats) const
+{
+    DictionaryStats stats;
+
+    stats.name = "user";
+    m_user_database.getStats(stats);
+    o_stats.push_back(stats);
+
+    stats.name = "context";
+    m_context_database.getStats(stats);
+    o_stats.push_back(stats);
+}
+
 /**
 * learn user word
 *
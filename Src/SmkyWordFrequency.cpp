@@ -0,0 +1,288 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "SmkyWordFrequency.h"
+#include <glib.h>
+#include <ctype.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace SmartKey;
+
+/**
+ * Frequency list loaded from a file, released with the last instance using it
+ */
+struct SmkyWordFrequency::Shared
+{
+    std::string            path;       ///< Text file.
+    time_t                 mtime;      ///< Modification time of the text file when loaded.
+    SmkyCompiledDictionary dictionary;
+    int                    refs;       ///< Guarded by s_shared_mutex.
+};
+
+typedef std::map<std::string, SmkyWordFrequency::Shared*> SharedMap;
+
+//the latest list of every file, guarded by s_shared_mutex
+static SharedMap s_shared;
+static GMutex s_shared_mutex;
+
+//list of instances which loaded nothing
+static const SmkyCompiledDictionary s_empty;
+
+/**
+* modification time of the file
+*
+* @param i_path
+*   path + filename
+*
+* @return time_t
+*   modification time, 0 if there is no such file
+*/
+static time_t file_mtime (const std::string& i_path)
+{
+    struct stat st;
+    return(stat(i_path.c_str(), &st) == 0 ? st.st_mtime : 0);
+}
+
+/**
+* SmkyWordFrequency
+*/
+SmkyWordFrequency::SmkyWordFrequency (void)
+    : mp_shared(NULL)
+{
+}
+
+/**
+* ~SmkyWordFrequency
+*/
+SmkyWordFrequency::~SmkyWordFrequency (void)
+{
+    close();
+}
+
+/**
+* load frequency list, list loaded by another instance is shared unless the file was changed since
+*
+* @param i_text_file
+*   path + filename of text list, compiled file is looked for next to it
+*
+* @return bool
+*   true if loaded
+*/
+bool SmkyWordFrequency::load (const std::string& i_text_file)
+{
+    close();
+
+    if (i_text_file.empty())
+        return(false);
+
+    time_t mtime = file_mtime(i_text_file);
+
+    g_mutex_lock(&s_shared_mutex);
+
+    SharedMap::iterator it = s_shared.find(i_text_file);
+    if (it != s_shared.end() && it->second->mtime == mtime)
+    {
+        mp_shared = it->second;
+        mp_shared->refs++;
+    }
+
+    g_mutex_unlock(&s_shared_mutex);
+
+    if (mp_shared)
+        return(mp_shared->dictionary.isOpen());
+
+    //loaded without the lock, other instances may load the same file meanwhile
+    Shared* p_shared = new Shared;
+    p_shared->path = i_text_file;
+    p_shared->mtime = mtime;
+    p_shared->refs = 1;
+
+    std::string compiled_file = SmkyCompiledDictionary::getCompiledPath(i_text_file);
+
+    if (!(SmkyCompiledDictionary::isFresh(i_text_file, compiled_file) && p_shared->dictionary.open(compiled_file) && p_shared->dictionary.hasFrequencies()))
+    {
+        p_shared->dictionary.close();
+
+        if (g_file_test(i_text_file.c_str(), G_FILE_TEST_EXISTS))
+        {
+            g_debug("WordFrequency: no compiled list for %s, building it in memory", i_text_file.c_str());
+            p_shared->dictionary.build(i_text_file, SmkyCompiledDictionary::SOURCE_FREQUENCIES);
+        }
+    }
+
+    g_mutex_lock(&s_shared_mutex);
+
+    //list of changed file replaces the previous one, instances using that keep it
+    it = s_shared.find(i_text_file);
+    if (it != s_shared.end())
+        it->second->path.clear();
+
+    s_shared[i_text_file] = p_shared;
+    mp_shared = p_shared;
+
+    g_mutex_unlock(&s_shared_mutex);
+
+    return(mp_shared->dictionary.isOpen());
+}
+
+/**
+* release list, it is dropped with the last instance using it
+*/
+void SmkyWordFrequency::close (void)
+{
+    if (!mp_shared)
+        return;
+
+    g_mutex_lock(&s_shared_mutex);
+
+    if (--mp_shared->refs == 0)
+    {
+        //replaced list isn't registered any more (path is cleared)
+        if (!mp_shared->path.empty())
+            s_shared.erase(mp_shared->path);
+
+        delete mp_shared;
+    }
+
+    g_mutex_unlock(&s_shared_mutex);
+
+    mp_shared = NULL;
+}
+
+/**
+* list of the loaded file
+*
+* @return SmkyCompiledDictionary&
+*   list, empty one if nothing is loaded
+*/
+const SmkyCompiledDictionary& SmkyWordFrequency::_dictionary (void) const
+{
+    return(mp_shared ? mp_shared->dictionary : s_empty);
+}
+
+/**
+* usage count of the word
+*
+* @param i_word
+*   word, capitalized word falls back to its lower case form
+*
+* @return uint32_t
+*   usage count, 0 if unknown
+*/
+uint32_t SmkyWordFrequency::getFrequency (const std::string& i_word) const
+{
+    int index = _dictionary().find(i_word.c_str());
+
+    if (index < 0)
+    {
+        std::string lower = _uncapitalize(i_word);
+
+        if (!lower.empty())
+            index = _dictionary().find(lower.c_str());
+    }
+
+    return(index < 0 ? 0 : _dictionary().frequencyAt(index));
+}
+
+/**
+* order completions: more frequent first
+*/
+static bool compare_frequent_first (const std::pair<uint32_t, std::string>& first, const std::pair<uint32_t, std::string>& second)
+{
+    return (first.first > second.first);
+}
+
+/**
+* the most frequent words starting with prefix, capitalized prefix also completes lower case words
+* (results keep capital letter)
+*
+* @param i_prefix
+*   prefix
+*
+* @param i_max
+*   limit number of words
+*
+* @param o_words
+*   output: found words are appended, the most frequent first
+*/
+void SmkyWordFrequency::findBestCompletions (const std::string& i_prefix, size_t i_max, std::list<std::string>& o_words) const
+{
+    if (i_prefix.empty() || i_max == 0)
+        return;
+
+    std::list<std::string> words;
+    _dictionary().findBestKeysByPrefix(i_prefix, i_max, words);
+
+    std::string lower = _uncapitalize(i_prefix);
+
+    if (lower.empty())
+    {
+        o_words.splice(o_words.end(), words);
+        return;
+    }
+
+    std::list<std::string> lower_words;
+    _dictionary().findBestKeysByPrefix(lower, i_max, lower_words);
+
+    //merge both lists by frequency, capitalized forms of lower case words can repeat the words of the first list
+    std::vector< std::pair<uint32_t, std::string> > merged;
+
+    for (std::list<std::string>::iterator it = words.begin(); it != words.end(); ++it)
+    {
+        merged.push_back(std::make_pair(getFrequency(*it), *it));
+    }
+
+    for (std::list<std::string>::iterator it = lower_words.begin(); it != lower_words.end(); ++it)
+    {
+        std::string word = *it;
+        word[0] = toupper((unsigned char)word[0]);
+
+        if (std::find(words.begin(), words.end(), word) == words.end())
+            merged.push_back(std::make_pair(_dictionary().frequencyAt(_dictionary().find(it->c_str())), word));
+    }
+
+    std::stable_sort(merged.begin(), merged.end(), compare_frequent_first);
+
+    for (size_t i = 0; i < merged.size() && i < i_max; ++i)
+    {
+        o_words.push_back(merged[i].second);
+    }
+}
+
+/**
+* lower case first letter of capitalized word
+*
+* @param i_word
+*   word
+*
+* @return std::string
+*   word with lower case first letter, empty if word doesn't start with capital letter
+*/
+std::string SmkyWordFrequency::_uncapitalize (const std::string& i_word)
+{
+    if (i_word.empty() || !isupper((unsigned char)i_word[0]))
+        return("");
+
+    std::string retval = i_word;
+    retval[0] = tolower((unsigned char)retval[0]);
+
+    return(retval);
+}
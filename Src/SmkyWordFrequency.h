@@ -0,0 +1,119 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2010-2013 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef SMKY_WORD_FREQUENCY_H
+#define SMKY_WORD_FREQUENCY_H
+
+#include <stdint.h>
+#include <string>
+#include <list>
+#include "SmkyCompiledDictionary.h"
+
+namespace SmartKey
+{
+
+/**
+ * Usage counts of the words of a locale ('word count' per line, see Tools/Scripts/key_dict_us_1-21).
+ * List is compiled by Tools/DictionaryCompiler.cpp and mapped into memory, or built in memory
+ * from the text file if there is no up to date compiled file. List is read-only, so instances
+ * which load the same file (e.g. hunspell dictionaries of worker threads) share it.
+ */
+class SmkyWordFrequency
+{
+public:
+    //list of a file shared by instances which loaded it
+    struct Shared;
+
+private:
+    Shared* mp_shared;
+
+public:
+
+    SmkyWordFrequency (void);
+    virtual ~SmkyWordFrequency (void);
+
+    //load frequency list (compiled file is used if it is up to date)
+    bool load (const std::string& i_text_file);
+
+    //release list
+    void close (void);
+
+    //is list loaded?
+    bool isLoaded (void) const;
+
+    //number of words
+    uint32_t size (void) const;
+
+    //bytes of mapped file
+    size_t mappedSize (void) const;
+
+    //bytes of list built in memory
+    size_t memoryUsed (void) const;
+
+    //usage count of the word, capitalized words fall back to lower case, 0 if unknown
+    uint32_t getFrequency (const std::string& i_word) const;
+
+    //up to i_max the most frequent words starting with prefix (the most frequent first), append them to o_words
+    void findBestCompletions (const std::string& i_prefix, size_t i_max, std::list<std::string>& o_words) const;
+
+private:
+    //list of the loaded file, empty one if nothing is loaded
+    const SmkyCompiledDictionary& _dictionary (void) const;
+
+    //lower case first letter of capitalized word, empty if word isn't capitalized
+    static std::string _uncapitalize (const std::string& i_word);
+
+    SmkyWordFrequency (const SmkyWordFrequency&);   // don't implement
+    void operator= (const SmkyWordFrequency&);      // don't implement
+};
+
+/**
+* is list loaded?
+*/
+inline bool SmkyWordFrequency::isLoaded (void) const
+{
+    return(_dictionary().isOpen());
+}
+
+/**
+* number of words
+*/
+inline uint32_t SmkyWordFrequency::size (void) const
+{
+    return(_dictionary().size());
+}
+
+/**
+* bytes of mapped file
+*/
+inline size_t SmkyWordFrequency::mappedSize (void) const
+{
+    return(_dictionary().mappedSize());
+}
+
+/**
+* bytes of list built in memory
+*/
+inline size_t SmkyWordFrequency::memoryUsed (void) const
+{
+    return(_dictionary().memoryUsed());
+}
+
+}
+
+#endif
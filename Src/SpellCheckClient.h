@@ -56,7 +56,7 @@ struct WordGuess
  */
 struct SpellCheckWordInfo
 {
-    SpellCheckWordInfo() : inDictionary(true) {}
+    SpellCheckWordInfo() : inDictionary(true), partial(false) {}
     bool isEmpty() const
     {
         return guesses.empty();
@@ -64,10 +64,12 @@ struct SpellCheckWordInfo
     void clear()
     {
         inDictionary = true;
+        partial = false;
         guesses.clear();
     }
 
     bool inDictionary;  ///< Was this word in any dictionary.
+    bool partial;       ///< Time budget was spent, guesses may be incomplete.
     std::vector<WordGuess> guesses; ///< Collection of guesses (may be empty - even if mispelled.)
 };
 
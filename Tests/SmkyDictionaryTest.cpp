@@ -0,0 +1,313 @@
+/**
+ *  Copyright (c) 2010-2013 LG Electronics, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Checks of dictionary storage structures, run from the root of the repository:
+ *
+ *   g++ -ISrc $(pkg-config --cflags --libs glib-2.0) -o /tmp/SmkyDictionaryTest \
+ *       Tests/SmkyDictionaryTest.cpp Src/SmkyFileKeywords.cpp Src/SmkyJournal.cpp \
+ *       Src/SmkyCompiledDictionary.cpp Src/SmkyPrefixIndex.cpp Src/SmkyStringArena.cpp Src/Settings.cpp \
+ *       Src/SmkySymSpellIndex.cpp Src/SmkyFilePairs.cpp Src/SmkyBloomFilter.cpp
+ *   /tmp/SmkyDictionaryTest /tmp
+ *
+ * Files are written into the given directory, exit code is the number of failed checks.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "SmkyBloomFilter.h"
+#include "SmkyCompiledDictionary.h"
+#include "SmkyFileKeywords.h"
+#include "SmkyFilePairs.h"
+#include "SmkyFlatTable.h"
+#include "SmkyJournal.h"
+#include "SmkySymSpellIndex.h"
+
+using namespace SmartKey;
+
+static int g_failed = 0;
+
+static bool test(bool condition, const char* name)
+{
+    if (!condition) {
+        printf("%s: FAILED!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!\n", name);
+        g_failed++;
+    }
+    return condition;
+}
+
+static void writeFile(const std::string& path, const char* content)
+{
+    std::ofstream file(path.c_str(), std::ios::out | std::ios::trunc);
+    file << content;
+}
+
+/**
+* image compiled from pairs must not be used as a keyword list
+*/
+static void compiledDictionaryTest(const std::string& dir)
+{
+    std::string words = dir + "/smky-test-words";
+    std::string pairs = dir + "/smky-test-pairs";
+
+    writeFile(words, "alpha\nbeta\n");
+    writeFile(pairs, "gamma|delta\n");
+
+    //stale image of other format, newer than the text file
+    test(SmkyCompiledDictionary::compile(pairs, SmkyCompiledDictionary::getCompiledPath(words), SmkyCompiledDictionary::SOURCE_PAIRS), "compile pairs");
+
+    SmkyFileKeywords keywords;
+    keywords.load(words);
+    test(keywords.find("alpha") && keywords.find("beta"), "keywords of text file are loaded");
+    test(!keywords.find("gamma"), "pairs image is not used as keywords");
+
+    //image of the right format is used
+    test(SmkyCompiledDictionary::compile(words, SmkyCompiledDictionary::getCompiledPath(words), SmkyCompiledDictionary::SOURCE_WORDS), "compile words");
+    keywords.load(words);
+    test(keywords.find("alpha") && keywords.size() == 2, "keywords image is used");
+
+    //offset of a key pointing outside of the string pool
+    std::string compiled = SmkyCompiledDictionary::getCompiledPath(words);
+    std::string image;
+    {
+        std::ifstream file(compiled.c_str(), std::ios::in | std::ios::binary);
+        image.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+    SmkyCompiledDictionary::Header header;
+    memcpy(&header, image.data(), sizeof(header));
+    uint32_t bad_offset = header.pool_size + 16;
+    image.replace(header.keys_offset + sizeof(uint32_t), sizeof(bad_offset), reinterpret_cast<const char*>(&bad_offset), sizeof(bad_offset));
+    {
+        std::ofstream file(compiled.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+        file << image;
+    }
+    SmkyCompiledDictionary corrupted;
+    test(!corrupted.open(compiled), "image with bad key offset is rejected");
+
+    unlink(SmkyCompiledDictionary::getCompiledPath(words).c_str());
+    unlink(words.c_str());
+    unlink(pairs.c_str());
+}
+
+static bool contains(const std::vector<std::string>& words, const char* word)
+{
+    return std::find(words.begin(), words.end(), word) != words.end();
+}
+
+/**
+* compiled SymSpell index finds words within the edit distance, the closest first
+*/
+static void symSpellTest(const std::string& dir)
+{
+    std::string file = dir + "/smky-test.sym";
+
+    std::vector<std::string> words;
+    words.push_back("hello");
+    words.push_back("help");
+    words.push_back("world");
+    words.push_back("word");
+
+    test(SmkySymSpellIndex::compile(words, true, file), "compile index");
+
+    SmkySymSpellIndex index;
+    test(index.open(file) && index.size() == words.size(), "open index");
+    test(index.hasInflectedForms(), "index of expanded word list");
+
+    std::vector<std::string> guesses;
+    index.lookup("wrld", 5, guesses);
+    test(!guesses.empty() && guesses[0] == "world", "closest guess first");
+
+    guesses.clear();
+    index.lookup("helo", 5, guesses);
+    test(contains(guesses, "hello") && contains(guesses, "help"), "all guesses within distance");
+
+    guesses.clear();
+    index.lookup("xyzzy", 5, guesses);
+    test(guesses.empty(), "no guesses for distant word");
+
+    //stems of .dic file
+    test(SmkySymSpellIndex::compile(words, false, file) && index.open(file) && !index.hasInflectedForms(), "index of stems");
+
+    index.close();
+    unlink(file.c_str());
+}
+
+/**
+* record torn by a crash is dropped from the journal and doesn't merge with the next record
+*/
+static void journalTest(const std::string& dir)
+{
+    std::string words = dir + "/smky-test-journal";
+
+    writeFile(words, "alpha\n");
+    writeFile(SmkyJournal::getPath(words), "+beta\n+wor");
+
+    SmkyFileKeywords keywords;
+    keywords.load(words);
+    test(keywords.find("alpha") && keywords.find("beta"), "complete records are replayed");
+    test(!keywords.find("wor"), "torn record is skipped");
+
+    keywords.add("hello");
+    keywords.add("bad\nword");
+    test(!keywords.find("bad\nword"), "word with line break is rejected");
+    test(keywords.save(words), "save to journal");
+
+    SmkyFileKeywords reloaded;
+    reloaded.load(words);
+    test(reloaded.find("hello") && reloaded.find("beta"), "appended record is replayed");
+    test(!reloaded.find("wor+hello") && !reloaded.find("wor"), "torn record doesn't merge with the next one");
+
+    std::vector<std::string> records;
+    test(SmkyJournal::read(words, records) && records.size() == 2 && records[1] == "+hello", "journal keeps complete records only");
+
+    SmkyJournal::remove(words);
+    unlink(words.c_str());
+}
+
+static std::string numbered(const char* prefix, int n)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s%d", prefix, n);
+    return buf;
+}
+
+/**
+* learn/forget churn must not grow the table nor its storage
+*/
+static void flatTableChurnTest()
+{
+    SmkyFlatTable<SmkyNoValue> table;
+
+    for (int i = 0; i < 100; ++i) {
+        std::string key = numbered("word", i);
+        table.insert(key.data(), key.length(), SmkyNoValue());
+    }
+
+    size_t memory = 0;
+
+    for (int i = 0; i < 100000; ++i) {
+        std::string key = numbered("learned", i);
+        table.insert(key.data(), key.length(), SmkyNoValue());
+        table.erase(table.find(key.data(), key.length()));
+
+        if (i == 1000)
+            memory = table.memoryUsed();
+    }
+
+    test(table.size() == 100 && table.find(numbered("word", 42)) && !table.find(numbered("learned", 3000)), "table content after churn");
+    test(table.memoryUsed() <= memory, "table doesn't grow with churn");
+    test(table.relocations() > 0, "storage of erased keys is compacted");
+}
+
+/**
+* prefix indexes follow keys and values moved by compaction
+*/
+static void dictionaryChurnTest()
+{
+    SmkyFileKeywords keywords;
+    SmkyFilePairs pairs;
+
+    keywords.add("alpha");
+    pairs.add("brb", "be right back");
+
+    for (int i = 0; i < 5000; ++i) {
+        std::string word = numbered("temp", i);
+        keywords.add(word);
+        keywords.remove(word);
+        pairs.add(word, "temporary " + word);
+        pairs.remove(word);
+    }
+
+    test(keywords.find_by_prefix("alp") == "alpha" && keywords.find_by_prefix("temp").empty(), "keywords prefix index after churn");
+    test(pairs.find("brb") == "be right back" && pairs.find_by_prefix("be r") == "be right back", "pairs prefix index after churn");
+    test(pairs.find_by_prefix("temporary").empty(), "erased values are not indexed");
+}
+
+/**
+* added keys extend exported ones until a key is erased
+*/
+static void addedKeysTest()
+{
+    SmkyFileKeywords keywords;
+    SmkyFilePairs pairs;
+    std::vector<const char*> keys;
+
+    keywords.add("alpha");
+    test(!keywords.takeAddedKeys(keys), "new dictionary is exported whole");
+
+    keywords.add("beta");
+    keywords.add("gamma");
+    keys.clear();
+    test(keywords.takeAddedKeys(keys) && keys.size() == 2 && std::string(keys[0]) == "beta", "added keys");
+
+    keys.clear();
+    test(keywords.takeAddedKeys(keys) && keys.empty(), "added keys are taken once");
+
+    keywords.remove("beta");
+    keywords.add("delta");
+    test(!keywords.takeAddedKeys(keys), "erased key needs export");
+
+    pairs.add("brb", "be right back");
+    pairs.takeAddedKeys(keys);
+    pairs.add("afk", "away from keyboard");
+    keys.clear();
+    test(pairs.takeAddedKeys(keys) && keys.size() == 1 && std::string(keys[0]) == "afk", "added shortcuts");
+}
+
+/**
+* added keys are always found, other keys rarely
+*/
+static void bloomFilterTest()
+{
+    SmkyBloomFilter filter;
+    filter.reset(1000);
+
+    for (int i = 0; i < 1000; ++i)
+        filter.add(numbered("word", i));
+
+    bool all = true;
+    for (int i = 0; i < 1000; ++i)
+        all = all && filter.mayContain(numbered("word", i));
+    test(all, "no false negatives");
+
+    int positives = 0;
+    for (int i = 0; i < 10000; ++i)
+        positives += filter.mayContain(numbered("other", i)) ? 1 : 0;
+    test(positives < 500, "false positive rate below 5%");
+}
+
+int main(int argc, char* argv[])
+{
+    std::string dir = argc > 1 ? argv[1] : "/tmp";
+
+    compiledDictionaryTest(dir);
+    symSpellTest(dir);
+    journalTest(dir);
+    flatTableChurnTest();
+    dictionaryChurnTest();
+    addedKeysTest();
+    bloomFilterTest();
+
+    printf("failed checks: %d\n", g_failed);
+
+    return g_failed;
+}
@@ -0,0 +1,196 @@
+/**
+ *  Copyright (c) 2010-2013 LG Electronics, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Checks of guesses of extra locales (multi-language mode), run from the root of the repository:
+ *
+ *   g++ -ISrc $(pkg-config --cflags --libs glib-2.0) -lhunspell-1.3 -o /tmp/SmkyExtraLocalesTest \
+ *       Tests/SmkyExtraLocalesTest.cpp Src/SmkyExtraLocales.cpp Src/SmkyHunspellDatabase.cpp \
+ *       Src/SmkyKeyboardLayout.cpp Src/SmkyWordFrequency.cpp Src/SmkySymSpellIndex.cpp \
+ *       Src/SmkyCompiledDictionary.cpp Src/Settings.cpp
+ *   /tmp/SmkyExtraLocalesTest /tmp
+ *
+ * Small hunspell dictionaries are written into the given directory, exit code is the number of failed checks.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Settings.h"
+#include "SmkyExtraLocales.h"
+
+using namespace SmartKey;
+
+static int g_failed = 0;
+
+static bool test(bool condition, const char* name)
+{
+    if (!condition) {
+        printf("%s: FAILED!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!\n", name);
+        g_failed++;
+    }
+    return condition;
+}
+
+static void writeFile(const std::string& path, const char* content)
+{
+    std::ofstream file(path.c_str(), std::ios::out | std::ios::trunc);
+    file << content;
+}
+
+/**
+* each locale has a single word close to "helo"
+*/
+static void writeDictionaries(const std::string& dir)
+{
+    const char* aff = "SET UTF-8\nTRY esianrtolcdugmphbyfvkwz\n";
+
+    writeFile(dir + "/en_us.aff", aff);
+    writeFile(dir + "/en_us.dic", "2\nhello\nworld\n");
+    writeFile(dir + "/fr.aff", aff);
+    writeFile(dir + "/fr.dic", "2\nhalo\nmonde\n");
+}
+
+static void removeDictionaries(const std::string& dir)
+{
+    unlink((dir + "/en_us.aff").c_str());
+    unlink((dir + "/en_us.dic").c_str());
+    unlink((dir + "/fr.aff").c_str());
+    unlink((dir + "/fr.dic").c_str());
+}
+
+/**
+* guesses of the current locale ("help") merged with guesses of extra locales
+*/
+static std::vector<std::string> mergedGuesses(SmkyExtraLocales& locales, const char* primary)
+{
+    SpellCheckWordInfo result;
+    result.clear();
+
+    WordGuess guess;
+    guess.guess = primary;
+    result.guesses.push_back(guess);
+
+    SmkyDeadline deadline(0);
+    SmkyExtraLocales::Search* p_search = locales.startGuesses("helo", 5, deadline, false, "de");
+    locales.finishGuesses(p_search, result, 5);
+
+    std::vector<std::string> words;
+    for (size_t i = 0; i < result.guesses.size(); ++i)
+        words.push_back(result.guesses[i].guess);
+
+    return words;
+}
+
+/**
+* word is good in any extra locale, except of the current language
+*/
+static void findEntryTest(const LocaleSettings& current)
+{
+    SmkyExtraLocales locales;
+    locales.load("en_us, fr, xx", current);
+
+    test(!locales.isEmpty(), "locales with dictionaries are loaded");
+    test(locales.findEntry("monde", "de") && locales.findEntry("hello", "de"), "word of any locale is good");
+    test(!locales.findEntry("monde", "fr"), "current language is skipped");
+    test(!locales.findEntry("helo", "de"), "misspelled word");
+}
+
+/**
+* guesses are scored by weight of their locale divided by their position, duplicates are skipped
+*/
+static void weightTest(const LocaleSettings& current)
+{
+    SmkyExtraLocales locales;
+
+    locales.load("en_us:70,fr:40", current);
+    std::vector<std::string> words = mergedGuesses(locales, "help");
+    test(words.size() == 3 && words[0] == "help" && words[1] == "hello" && words[2] == "halo", "guesses ordered by weight");
+
+    locales.load("en_us:30,fr:90", current);
+    words = mergedGuesses(locales, "help");
+    test(words.size() == 3 && words[0] == "help" && words[1] == "halo" && words[2] == "hello", "heavier locale first");
+
+    words = mergedGuesses(locales, "hello");
+    test(words.size() == 2 && words[0] == "hello" && words[1] == "halo", "duplicate guess is skipped");
+
+    locales.load("en_us", current);
+    std::vector<DictionaryStats> stats;
+    locales.getStats(stats);
+    test(!stats.empty() && stats[0].name == "hunspell-en_us" && stats[0].entries == 2, "stats of extra locale");
+}
+
+static SmkyExtraLocales* g_locales = NULL;
+static int g_threadFailures = 0;
+
+static gpointer searchThread(gpointer)
+{
+    for (int i = 0; i < 20; ++i)
+    {
+        std::vector<std::string> words = mergedGuesses(*g_locales, "help");
+        if (words.size() != 3 || words[1] != "hello" || words[2] != "halo")
+            g_atomic_int_inc(&g_threadFailures);
+    }
+    return NULL;
+}
+
+/**
+* concurrent searches share copies of dictionaries (no more than one per worker thread)
+* and get the same guesses as a single one
+*/
+static void parallelTest(const LocaleSettings& current)
+{
+    Settings::getInstance()->workerThreads = 2;
+
+    SmkyExtraLocales locales;
+    locales.load("en_us:70,fr:40", current);
+    g_locales = &locales;
+
+    GThread* threads[4];
+    for (int i = 0; i < 4; ++i)
+        threads[i] = g_thread_new("test", searchThread, NULL);
+    for (int i = 0; i < 4; ++i)
+        g_thread_join(threads[i]);
+
+    test(g_threadFailures == 0, "parallel searches are merged");
+
+    g_locales = NULL;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string dir = argc > 1 ? argv[1] : "/tmp";
+
+    writeDictionaries(dir);
+
+    Settings* p_settings = Settings::getInstance();
+    p_settings->hunspellDirectory = dir;
+    p_settings->readOnlyDataDir = dir;
+    p_settings->readWriteDataDir = dir;
+
+    findEntryTest(p_settings->localeSettings);
+    weightTest(p_settings->localeSettings);
+    parallelTest(p_settings->localeSettings);
+
+    removeDictionaries(dir);
+
+    printf("failed checks: %d\n", g_failed);
+
+    return g_failed;
+}
@@ -0,0 +1,129 @@
+/**
+ *  Copyright (c) 2010-2013 LG Electronics, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Checks of superseding requests of client sessions, run from the root of the repository:
+ *
+ *   g++ -ISrc $(pkg-config --cflags --libs glib-2.0) -o /tmp/SmkyRequestSessionsTest \
+ *       Tests/SmkyRequestSessionsTest.cpp Src/SmkyRequestSessions.cpp
+ *   /tmp/SmkyRequestSessionsTest
+ *
+ * Exit code is the number of failed checks.
+ */
+
+#include <stdio.h>
+#include <string>
+
+#include "SmkyRequestSessions.h"
+
+using namespace SmartKey;
+
+static int g_failed = 0;
+
+static bool test(bool condition, const char* name)
+{
+    if (!condition) {
+        printf("%s: FAILED!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!\n", name);
+        g_failed++;
+    }
+    return condition;
+}
+
+static std::string sessionName(int i)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "keyboard-%d", i);
+    return name;
+}
+
+/**
+* request is superseded by a newer one of the same session only
+*/
+static void supersedeTest()
+{
+    SmkyRequestSessions sessions;
+
+    test(sessions.start("a", 1), "first request is started");
+    SmkyRequestTicket first = sessions.getTicket("a", 1);
+    test(!first.isSuperseded(), "latest request is not superseded");
+
+    test(sessions.start("b", 5), "other session");
+    test(!first.isSuperseded(), "request of other session doesn't supersede");
+
+    test(sessions.start("a", 2), "newer request is started");
+    test(first.isSuperseded(), "older request is superseded");
+    test(!sessions.getTicket("a", 2).isSuperseded(), "newer request is not superseded");
+
+    test(!sessions.start("a", 1), "older request is rejected");
+
+    SmkyDeadline deadline(0, sessions.getTicket("b", 5));
+    test(!deadline.isExpired(), "unlimited deadline");
+    sessions.start("b", 6);
+    test(deadline.isCancelled() && deadline.isExpired(), "deadline of superseded request is expired");
+
+    test(!SmkyRequestTicket().isSuperseded() && !sessions.getTicket("unknown", 1).isSuperseded(), "request without session");
+}
+
+/**
+* the least recently used session is dropped, tickets of running requests stay valid
+*/
+static void evictionTest()
+{
+    SmkyRequestSessions sessions;
+
+    sessions.start(sessionName(0), 1);
+    SmkyRequestTicket running = sessions.getTicket(sessionName(0), 1);
+
+    for (int i = 1; i < SmkyRequestSessions::MAX_SESSIONS; ++i)
+        sessions.start(sessionName(i), 1);
+
+    //session 0 is used again, session 1 is the least recently used one
+    sessions.start(sessionName(0), 2);
+    test(running.isSuperseded(), "superseded before sessions are full");
+
+    sessions.start("new", 1);
+    test(sessions.size() == SmkyRequestSessions::MAX_SESSIONS, "number of sessions is bounded");
+
+    SmkyRequestTicket latest = sessions.getTicket("new", 1);
+    sessions.start("new", 2);
+    test(latest.isSuperseded(), "new session is tracked when sessions are full");
+
+    SmkyRequestTicket evicted = sessions.getTicket(sessionName(1), 1);
+    test(!sessions.getTicket(sessionName(0), 2).isSuperseded() && sessions.start(sessionName(0), 3), "recently used session is kept");
+
+    //many new sessions drop all the old ones, ticket keeps the state of its session
+    SmkyRequestTicket old = sessions.getTicket(sessionName(2), 1);
+    for (int i = 0; i < 2 * SmkyRequestSessions::MAX_SESSIONS; ++i)
+        sessions.start(sessionName(1000 + i), 1);
+
+    test(sessions.size() == SmkyRequestSessions::MAX_SESSIONS, "number of sessions stays bounded");
+    test(!old.isSuperseded(), "ticket of dropped session is valid");
+    test(!evicted.isSuperseded(), "ticket taken after eviction is never superseded");
+
+    SmkyRequestTicket copy = old;
+    copy = running;
+    test(copy.isSuperseded(), "ticket is copied");
+}
+
+int main(int argc, char* argv[])
+{
+    supersedeTest();
+    evictionTest();
+
+    printf("failed checks: %d\n", g_failed);
+
+    return g_failed;
+}
@@ -16,185 +16,135 @@
 *
 * LICENSE@@@ */
 
+/*
+ * Compiles text dictionaries into the memory mapped format read by SmkyCompiledDictionary.
+ * The text files stay the source of truth, compiled files are written next to them
+ * (<file>.bin) and are used by the service only while they are not older than the text file.
+ * Built with the service (see SmartKey.pro) and installed as /usr/bin/DictionaryCompiler.
+ *
+ *   DictionaryCompiler -k <words file> [output]      one word per line
+ *   DictionaryCompiler -p <pairs file> [output]      'key|value' per line
+ *   DictionaryCompiler -f <frequency list> [output]  'word count' per line (see Tools/Scripts/key_dict_us_1-21)
+ *   DictionaryCompiler -r <DefaultData dir>          compile all read-only dictionaries
+ *   DictionaryCompiler -s <word list> [output]       SymSpell index (<locale>.sym next to hunspell
+ *                                                    dictionaries), word list is one word per line,
+ *                                                    e.g. expanded with hunspell 'unmunch' tool;
+ *                                                    .dic file can be used directly, but only stems are indexed
+ *                                                    (Hunspell::suggest is still used for inflected forms then)
+ */
+
 #include <string.h>
 #include <stdio.h>
 #include <glib.h>
 
-#include "SmartKeyDictionary.h"
-#include "SmartKeyHashDictionary.h"
-
-#include "Settings.h"
+#include "SmkyCompiledDictionary.h"
+#include "SmkySymSpellIndex.h"
 
-/*
-static gchar* skippedCharsFilename = ;
-static gint max_size = 8;
-static gboolean verbose = FALSE;
-static gboolean beep = FALSE;
-static gboolean rand = FALSE;
+using namespace SmartKey;
 
+static int s_compiled = 0;
+static int s_failed = 0;
 
-static GOptionEntry entries[] =
+static void usage(const char* name)
 {
-  { "repeats", 'r', 0, G_OPTION_ARG_INT, &repeats, "Average over N repetitions", "N" },
-  { "max-size", 'm', 0, G_OPTION_ARG_INT, &max_size, "Test up to 2^M items", "M" },
-  { "verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose, "Be verbose", NULL },
-  { "beep", 'b', 0, G_OPTION_ARG_NONE, &beep, "Beep when done", NULL },
-  { "rand", 0, 0, G_OPTION_ARG_NONE, &rand, "Randomize the data", NULL },
-  { NULL }
-};
-
-*/
-
-void smallTest()
-{
-	/*
-    SmartKey::SmartKeyDictionary dict;
-
-    dict.loadSkippedCharsFromFile("/var/tmp/key_skipped");
-    //dict.loadTermsFromFile("/var/tmp/key_dict_us_the");
-    dict.loadTermsFromFile("/var/tmp/key_dict_us_thermo2");
-    dict.loadEquivalencesFromFile("/var/tmp/key_equiv");
-
-    printf("---- dict read from ascii data ----\n");
-    dict.print();
-
-    const char* filename = "/tmp/node_content";
-
-    dict.writeToFile(filename, true);
-
-    SmartKey::SmartKeyDictionary loadedDict;
-
-    loadedDict.loadCompiledDictionary(filename);
-    printf("---- dict read from bin data ----\n");
-    loadedDict.print();
-
-    const char* compareFilename = "/tmp/node_content_compare";
-    loadedDict.writeToFile(compareFilename, true);
-
-    printf("---- wrote to file read dict: %s ----\n", compareFilename);
-    SmartKey::SmartKeyDictionary reloadedDict;
-    reloadedDict.loadCompiledDictionary(compareFilename);
-    printf("---- dict read from bin data ----\n");
-    reloadedDict.print();
-    */
-
+    printf("usage:\n");
+    printf("  %s -k <words file> [output]\n", name);
+    printf("  %s -p <pairs file> [output]\n", name);
+    printf("  %s -f <frequency list> [output]\n", name);
+    printf("  %s -r <DefaultData dir>\n", name);
+    printf("  %s -s <word list> [output]\n", name);
 }
 
-void buildDefaultDict(Settings& compilerSettings)
+static void compileFile(const std::string& textFile, const std::string& compiledFile, SmkyCompiledDictionary::SourceFormat format)
 {
-    SmartKey::SmartKeyDictionary dict(compilerSettings);
-
-    printf("%s: skipped chars file: '%s'\n", __FUNCTION__, compilerSettings.skippedCharsFile.c_str());
-    dict.loadSkippedCharsFromFile(compilerSettings.skippedCharsFile.c_str());
-    printf("%s: terms file: '%s'\n", __FUNCTION__, compilerSettings.termsFile.c_str());
-    dict.loadTermsFromFile(compilerSettings.termsFile.c_str());
-
-    dict.loadEquivalencesFromFile(compilerSettings.keyEquivalencesFile);
-
-    printf("%s: num nodes loaded from terms file: %d\n", __FUNCTION__, dict.getNodeCount());
-    printf("%s: num words loaded from terms file: %d\n", __FUNCTION__, dict.getWordCount());
-
-    // writing out memmaps
-    bool didWrite = dict.writeMemmaps(compilerSettings.mappedNodesFile,
-    		compilerSettings.mappedWordsFile,
-    		compilerSettings.mappedScoresFile,
-    		compilerSettings.mappedFreqsFile);
-
-    printf("writing memmaped files: %s\n", didWrite ? "succeeded" : "failed");
-
-    if (didWrite) {
-    	printf("files generated:\n%s\n%s\n%s\n%s\n", compilerSettings.mappedNodesFile.c_str(),
-    			compilerSettings.mappedWordsFile.c_str(),
-    			compilerSettings.mappedScoresFile.c_str(),
-    			compilerSettings.mappedFreqsFile.c_str());
+    if (SmkyCompiledDictionary::compile(textFile, compiledFile, format)) {
+        printf("%s -> %s\n", textFile.c_str(), compiledFile.c_str());
+        s_compiled++;
     }
-
-    if (!didWrite) {
-    	exit(-1);
+    else {
+        printf("%s: failed\n", textFile.c_str());
+        s_failed++;
     }
-
-    /*
-	const std::string testSettingsFile("/etc/palm/smartkey.conf");
-	Settings testSettings;
-	if (!testSettings.load(testSettingsFile)) {
-		g_warning("Error loading settings from '%s'", testSettingsFile.c_str());
-	}
-
-*/
-    SmartKey::SmartKeyDictionary memMappedDict(compilerSettings);
-    memMappedDict.initMemmaps(compilerSettings.mappedNodesFile,
-    		compilerSettings.mappedWordsFile,
-    		compilerSettings.mappedScoresFile,
-    		compilerSettings.mappedFreqsFile);
-
-    printf("%s: finished...\n", __FUNCTION__);
 }
 
-void buildAutoreplaceDict(Settings& s)
+/**
+* walk the directory and compile every file with the given name
+*/
+static void compileTree(const std::string& dir, const char* fileName, SmkyCompiledDictionary::SourceFormat format)
 {
-    SmartKey::SmartKeyHashDictionary dict(s);
-
-    bool didWrite = dict.writeAutoreplaceData(s.autoreplaceDefaultFile,
-    		s.autoreplaceTermsFile,
-    		s.autoreplaceMappedWordsFile,
-    		s.autoreplaceMappedNodesFile,
-    		s.autoreplaceMappedScoresFile,
-    		s.autoreplaceMappedFreqsFile);
-
-    printf("num words loaded from terms file: %d\n", dict.getWordCount());
-
-    printf("writing memmaped files: %s\n", didWrite ? "succeeded" : "failed");
-
-    if (didWrite) {
-    	printf("files generated:\n%s\n%s\n%s\n%s\n", s.autoreplaceMappedNodesFile.c_str(),
-        		s.autoreplaceMappedWordsFile.c_str(),
-        		s.autoreplaceMappedScoresFile.c_str(),
-        		s.autoreplaceMappedFreqsFile.c_str());
+    GDir* p_dir = g_dir_open(dir.c_str(), 0, NULL);
+    if (!p_dir)
+        return;
+
+    const gchar* p_name;
+    while ((p_name = g_dir_read_name(p_dir)) != NULL) {
+        std::string path = dir + "/" + p_name;
+
+        if (g_file_test(path.c_str(), G_FILE_TEST_IS_DIR)) {
+            compileTree(path, fileName, format);
+        }
+        else if (strcmp(p_name, fileName) == 0) {
+            compileFile(path, SmkyCompiledDictionary::getCompiledPath(path), format);
+        }
     }
 
-    if (!didWrite) {
-    	exit(-1);
-    }
-
-	const std::string testSettingsFile("/etc/palm/smartkey.conf");
-	Settings testSettings;
-	if (!testSettings.load(testSettingsFile)) {
-		g_warning("Error loading settings from '%s'", testSettingsFile.c_str());
-	}
-
-	// perform basic sanity check by loading the memmaped dictionary
-
-    SmartKey::SmartKeyHashDictionary memMappedDict(s);
-    memMappedDict.loadTermsFromFile(s.autoreplaceTermsFile);
-    memMappedDict.initMemmaps(s.autoreplaceMappedNodesFile,
-    		s.autoreplaceMappedWordsFile,
-    		s.autoreplaceMappedScoresFile,
-    		s.autoreplaceMappedFreqsFile);
-
-//    memMappedDict.print();
+    g_dir_close(p_dir);
 }
 
 int main (int argc, char* const argv[])
 {
+    if (argc < 3) {
+        usage(argv[0]);
+        return -1;
+    }
 
-	const std::string compilerSettingsFile("/etc/palm/smartkey_compiler.conf");
-	Settings compilerSettings;
-	if (!compilerSettings.load(compilerSettingsFile)) {
-		g_warning("Error loading settings from '%s'", compilerSettingsFile.c_str());
-	}
+    std::string mode = argv[1];
+    std::string input = argv[2];
 
-    /*
-    memMappedDict.initMemmaps("/var/tmp/memmaps_nodes",
-    		"/var/tmp/memmaps_words",
-    		"/var/tmp/memmaps_scores");
-*/
-    //memMappedDict.print();
+    if (mode == "-k" || mode == "-p" || mode == "-f") {
+        std::string output = argc > 3 ? argv[3] : SmkyCompiledDictionary::getCompiledPath(input);
+        SmkyCompiledDictionary::SourceFormat format = SmkyCompiledDictionary::SOURCE_WORDS;
 
-	//buildAutoreplaceDict(compilerSettings);
+        if (mode == "-p")
+            format = SmkyCompiledDictionary::SOURCE_PAIRS;
+        else if (mode == "-f")
+            format = SmkyCompiledDictionary::SOURCE_FREQUENCIES;
 
-	buildDefaultDict(compilerSettings);
+        compileFile(input, output, format);
+    }
+    else if (mode == "-s") {
+        std::string output;
+        if (argc > 3)
+            output = argv[3];
+        else if (input.length() > 4 && input.compare(input.length() - 4, 4, ".dic") == 0)
+            output = input.substr(0, input.length() - 4) + ".sym";
+        else
+            output = input + ".sym";
+
+        std::vector<std::string> words;
+        bool inflected = false;
+        if (SmkySymSpellIndex::readWordList(input, words, inflected) && SmkySymSpellIndex::compile(words, inflected, output)) {
+            printf("%s -> %s (%u words)\n", input.c_str(), output.c_str(), (unsigned int)words.size());
+            s_compiled++;
+        }
+        else {
+            printf("%s: failed\n", input.c_str());
+            s_failed++;
+        }
+    }
+    else if (mode == "-r") {
+        compileTree(input + "/locale", "locale-words", SmkyCompiledDictionary::SOURCE_WORDS);
+        compileTree(input + "/whitelist", "whitelist-entries", SmkyCompiledDictionary::SOURCE_WORDS);
+        compileTree(input + "/manufacturer", "man-db-entries", SmkyCompiledDictionary::SOURCE_WORDS);
+        compileTree(input + "/autoreplace-hc", "text-edit-autoreplace", SmkyCompiledDictionary::SOURCE_PAIRS);
+        compileTree(input + "/frequency", "word-frequency", SmkyCompiledDictionary::SOURCE_FREQUENCIES);
+    }
+    else {
+        usage(argv[0]);
+        return -1;
+    }
 
-    printf("finished loading memmapped dict\n");
+    printf("compiled: %d, failed: %d\n", s_compiled, s_failed);
 
-    return 0;
+    return s_failed ? -1 : 0;
 }